@@ -0,0 +1,68 @@
+#include "socket/socket_address.hpp"
+
+#include <chrono>
+#include <cstring>
+
+using namespace unisock;
+
+/* compares the cost of resolving numeric addresses:
+   - getaddrinfo (previous socket_address::addrinfo path)
+   - inet_pton fast path of socket_address::addrinfo (see socket_address::parse_numeric) */
+
+template<typename _Function>
+static long long    time_ns(size_t n_rounds, _Function function)
+{
+    auto before = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < n_rounds; ++round)
+        function();
+    auto after = std::chrono::steady_clock::now();
+    return (std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+}
+
+int main(int argc, char** argv)
+{
+    const size_t    n_rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const char*     hosts[] = { "127.0.0.1", "::1" };
+    const int       families[] = { AF_INET, AF_INET6 };
+    size_t          failures = 0;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_rounds << " rounds" << std::endl << std::endl;
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const char* host = hosts[i];
+        const int   family = families[i];
+        sockaddr_storage address;
+
+        auto getaddrinfo_time = time_ns(n_rounds, [&](){
+            struct addrinfo     hints;
+            struct addrinfo*    result = nullptr;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = family;
+            if (0 != ::getaddrinfo(host, nullptr, &hints, &result))
+                ++failures;
+            else
+                ::freeaddrinfo(result);
+        });
+
+        auto string_time = time_ns(n_rounds, [&](){
+            if (addrinfo_result::SUCCESS != socket_address::addrinfo(address, std::string(host), family))
+                ++failures;
+        });
+
+        const size_t host_len = std::strlen(host);
+        auto buffer_time = time_ns(n_rounds, [&](){
+            if (addrinfo_result::SUCCESS != socket_address::addrinfo(address, host, host_len, family))
+                ++failures;
+        });
+
+        std::cout << host << std::endl
+                  << "  getaddrinfo:        " << (getaddrinfo_time / static_cast<double>(n_rounds)) << "ns/lookup" << std::endl
+                  << "  addrinfo(string):   " << (string_time / static_cast<double>(n_rounds)) << "ns/lookup" << std::endl
+                  << "  addrinfo(char*):    " << (buffer_time / static_cast<double>(n_rounds)) << "ns/lookup" << std::endl;
+    }
+
+    if (failures > 0)
+        std::cout << "failures: " << failures << std::endl;
+}
@@ -0,0 +1,82 @@
+#include "tcp/client.hpp"
+#include "tcp/server.hpp"
+#include "udp/socket.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace unisock;
+
+/* resolves the server and client addresses on a resolver with a slow lookup,
+   while a udp socket keeps receiving ticks on the same handler */
+
+int main(int argc, char** argv)
+{
+    const int lookup_delay_ms = argc > 1 ? std::atoi(argv[1]) : 500;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+
+    // stub lookup simulating a slow DNS server
+    std::shared_ptr<resolver> slow_resolver = std::make_shared<resolver>(handler, resolver::DEFAULT_THREADS,
+        [lookup_delay_ms](socket_address& address, const std::string& hostname, sa_family_t family){
+            std::this_thread::sleep_for(std::chrono::milliseconds(lookup_delay_ms));
+            return (socket_address::addrinfo(address, hostname, family));
+        }
+    );
+
+    tcp::server server { handler };
+    tcp::client client { handler };
+    udp::socket ticker { handler };
+    size_t      ticks = 0;
+    bool        done = false;
+
+    server.set_resolver(slow_resolver);
+    client.set_resolver(slow_resolver);
+
+    server.on<tcp::server_actions::LISTEN>([&client](tcp::server::server_connection* connection){
+        std::cout << "listening on " << socket_address::get_ip(connection->address) << std::endl;
+        client.async_connect("localhost", 8000);
+    });
+
+    client.on<tcp::client_actions::CONNECT>([&ticks](tcp::client::connection* connection){
+        std::cout << "connected after " << ticks << " ticks" << std::endl;
+        connection->send("hello world", 11);
+    });
+
+    server.on<tcp::common_actions::RECEIVE>([&done](tcp::server::client_connection* connection, const char* message, size_t bytes){
+        (void)connection;
+        std::cout << "received: " << std::string(message, bytes) << std::endl;
+        done = true;
+    });
+
+    server.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "server error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    client.on<basic_actions::ERROR>([&done](const std::string& func, int err){
+        std::cout << "client error: " << func << ": " << strerror(err) << std::endl;
+        done = true;
+    });
+
+    ticker.on<udp::actions::RECEIVE>([&ticks](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++ticks;
+    });
+
+    if (!ticker.bind("127.0.0.1", 8001))
+        return (1);
+
+    server.async_listen("localhost", 8000);
+
+    // the handler keeps polling the ticker while lookups are running
+    while (!done && events::poll(handler, 10))
+        ticker.send_to(ticker.address, "tick", 4);
+
+    std::cout << "ticks received: " << ticks << ", pending lookups: " << slow_resolver->pending() << std::endl;
+
+    client.close();
+    server.close();
+    ticker.close();
+}
@@ -0,0 +1,109 @@
+#include "udp/socket.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace unisock;
+
+/* compares the cost of routing a readiness event to a udp socket, through the dispatch table entries of the handler:
+   - default entry socket_base::dispatch_readable: virtual on_readable() + std::function list of basic_actions::READABLE,
+     which calls receive() (previous events::poll path)
+   - direct entry set by udp::socket, udp::socket_impl::dispatch_recvfrom (see unisock::socket::set_dispatch)
+   both entries receive one queued datagram with recvfrom and end in the same RECEIVE hook incrementing a counter,
+   datagrams are queued before each timed batch so that only dispatch and receive are measured */
+
+static const size_t BATCH_ROUNDS = 128;
+
+// sends one datagram to every socket for each round of the batch, not timed
+static void     queue_datagrams(udp::socket& sender, const std::vector<std::unique_ptr<udp::socket>>& sockets, size_t rounds)
+{
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (auto& socket : sockets)
+            sender.send_to(socket->address, "x", 1);
+    }
+}
+
+// dispatches every socket of the handler as readable for **n_rounds** rounds, returns the time spent in dispatch
+static std::chrono::nanoseconds run_dispatch(const std::shared_ptr<events::handler>& handler, udp::socket& sender,
+                                             const std::vector<std::unique_ptr<udp::socket>>& sockets, size_t n_rounds)
+{
+    std::chrono::nanoseconds elapsed { 0 };
+
+    for (size_t done = 0; done < n_rounds; done += BATCH_ROUNDS)
+    {
+        const size_t rounds = std::min(BATCH_ROUNDS, n_rounds - done);
+        queue_datagrams(sender, sockets, rounds);
+
+        auto before = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (size_t i = 0; i < handler->count(); ++i)
+            {
+                const auto& dispatch = handler->dispatchers[i];
+                dispatch.readable(handler->socket_ptrs[i], dispatch.context);
+            }
+        }
+        elapsed += std::chrono::steady_clock::now() - before;
+    }
+    return (elapsed);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_sockets = argc > 1 ? std::atoi(argv[1]) : 64;
+    const size_t n_rounds  = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const int    first_port = argc > 3 ? std::atoi(argv[3]) : 9000;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    std::vector<std::unique_ptr<udp::socket>> sockets {};
+    udp::socket sender {};
+
+    size_t  received = 0;
+
+    if (!sender.open(AF_INET))
+        return (1);
+
+    for (size_t i = 0; i < n_sockets; ++i)
+    {
+        sockets.push_back(std::unique_ptr<udp::socket>(new udp::socket(handler)));
+        udp::socket& socket = *sockets.back();
+
+        socket.on<udp::actions::RECEIVE>([&received](const socket_address&, const char*, size_t){ ++received; });
+        socket.on<basic_actions::ERROR>([](const std::string& func, int err){
+            std::cout << "error: " << func << ": " << strerror(err) << std::endl;
+        });
+        if (!socket.bind("127.0.0.1", first_port + static_cast<int>(i)))
+            return (1);
+
+        // holds a whole batch of datagrams
+        int buffer_size = 1 << 20;
+        ::setsockopt(socket.get_socket(), SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+
+    // direct dispatch, entries set by udp::socket
+    std::vector<socket_base::dispatch_table> direct_entries(handler->dispatchers.begin(), handler->dispatchers.end());
+    received = 0;
+    auto direct_time = run_dispatch(handler, sender, sockets, n_rounds).count();
+    const size_t direct_count = received;
+
+    // virtual + std::function dispatch, default entries of the handler
+    for (auto& socket : sockets)
+        handler->socket_set_dispatch(socket->get_socket(), { &socket_base::dispatch_readable, &socket_base::dispatch_writeable, nullptr });
+    received = 0;
+    auto virtual_time = run_dispatch(handler, sender, sockets, n_rounds).count();
+    const size_t virtual_count = received;
+
+    for (size_t i = 0; i < sockets.size(); ++i)
+        handler->socket_set_dispatch(sockets[i]->get_socket(), direct_entries[i]);
+    for (auto& socket : sockets)
+        socket->close();
+    sender.close();
+
+    const double n_events = static_cast<double>(n_sockets * n_rounds);
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_sockets << " sockets, " << n_rounds << " rounds" << std::endl << std::endl
+              << "virtual dispatch: " << ((float)virtual_time / 1000000) << "ms (" << (virtual_time / n_events) << "ns/event, " << virtual_count << " datagrams)" << std::endl
+              << "direct dispatch:  " << ((float)direct_time / 1000000) << "ms (" << (direct_time / n_events) << "ns/event, " << direct_count << " datagrams)" << std::endl;
+}
@@ -0,0 +1,63 @@
+#include "tcp/server.hpp"
+
+#include <unistd.h>
+
+using namespace unisock;
+using namespace tcp::common_actions;
+using namespace tcp::server_actions;
+
+/* echo server that can be restarted without closing its port:
+   start it, then start it again in another terminal, the new process adopts
+   the listener and the clients of the running one, which then exits.
+   usage: hot-restart [port] [handoff socket path, or @name for an abstract socket] */
+
+#if defined(__linux__)
+# define DEFAULT_HANDOFF_NAME "@unisock-hot-restart"
+#else
+# define DEFAULT_HANDOFF_NAME "/tmp/unisock-hot-restart.sock"
+#endif
+
+int main(int argc, char** argv)
+{
+    const ushort        port = argc > 1 ? static_cast<ushort>(std::atoi(argv[1])) : 8000;
+    const std::string   handoff_name = argc > 2 ? argv[2] : DEFAULT_HANDOFF_NAME;
+    const bool          abstract = (handoff_name[0] == '@');
+    const std::string   handoff_path = abstract ? handoff_name.substr(1) : handoff_name;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    tcp::server server { handler };
+
+    server.on<LISTEN>([](tcp::server::server_connection* listener){
+        char address[socket_address::FORMAT_BUFFER_SIZE];
+        listener->address.format(address, sizeof(address));
+        std::cout << getpid() << ": listening on " << address << std::endl;
+    });
+
+    server.on<RECEIVE>([](tcp::server::client_connection* client, const char* message, size_t bytes){
+        const std::string reply = std::to_string(getpid()) + ": " + std::string(message, bytes);
+        client->send(reply.data(), reply.size());
+    });
+
+    server.on<HANDOFF>([](size_t n_sockets){
+        std::cout << getpid() << ": handed " << n_sockets << " sockets to the new process" << std::endl;
+    });
+
+    // takes over a running server, or starts listening if there is none:
+    // a filesystem socket can be looked up first, an abstract one is only
+    // found by connecting, which is refused when no server is running
+    const bool running = abstract || (0 == ::access(handoff_path.c_str(), F_OK));
+    const bool adopted = running && server.adopt(handoff_path, abstract);
+
+    server.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << getpid() << ": error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!adopted && !server.listen("0.0.0.0", port))
+        return (1);
+    if (!server.enable_handoff(handoff_path, abstract, true))
+        return (1);
+
+    // returns once the sockets were handed to a new process
+    while (events::poll( handler ))
+        ;
+}
@@ -0,0 +1,82 @@
+#include "raw/socket.hpp"
+#include "udp/socket.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+
+/* udp echo on loopback written to a pcapng file, open it with Wireshark:
+   - capture.pcapng holds the datagrams received by the udp sockets, with IP and udp headers rebuilt
+   - with "ring" as second argument, the loopback interface is also captured with an AF_PACKET ring in the same file */
+
+int main(int argc, char** argv)
+{
+    const std::string   path = argc > 1 ? argv[1] : "capture.pcapng";
+    const bool          use_ring = argc > 2 && std::string(argv[2]) == "ring";
+    const size_t        n_messages = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+    std::shared_ptr<raw::pcapng_writer> writer = std::make_shared<raw::pcapng_writer>();
+    if (!writer->open(path))
+    {
+        std::cout << "open: " << strerror(errno) << std::endl;
+        return (1);
+    }
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    udp::socket server { handler };
+    udp::socket client { handler };
+    raw::socket capture { handler };
+    size_t      received = 0;
+
+    server.on<udp::actions::RECEIVE>([&server](const socket_address& address, const char* message, size_t message_len){
+        server.send_to(address, message, message_len);
+    });
+
+    client.on<udp::actions::RECEIVE>([&received](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++received;
+    });
+
+    if (!server.bind("127.0.0.1", 8020) || !client.bind("127.0.0.1", 8021))
+        return (1);
+    // kernel timestamps, otherwise packets are timestamped when written
+    server.set_timestamping(TIMESTAMP_RX_SOFTWARE);
+    if (!server.set_capture(writer) || !client.set_capture(writer))
+        return (1);
+
+#if defined(__linux__)
+    if (use_ring)
+    {
+        raw::filter_builder filter { AF_INET };
+        filter.protocol(IPPROTO_UDP).destination_port(8020, 8021);
+        if (!capture.open(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))
+            || !capture.attach_filter(filter)
+            || !capture.set_packet_ring()
+            || !capture.bind_interface("lo")
+            || !capture.set_capture(writer))
+            return (1);
+    }
+#endif
+
+    const std::string payload(64, 'x');
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t sent = 0; sent < n_messages; )
+    {
+        for (size_t burst = 0; burst < 64 && sent < n_messages; ++burst, ++sent)
+            client.send_to(server.address, payload.c_str(), payload.size());
+        while (received < sent && events::poll(handler, 100))
+            ;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    writer->close();
+    std::cout << "wrote " << writer->packets() << " packets to " << path << " in " << seconds << "s ("
+              << writer->packets() / seconds << " packets/s)" << std::endl;
+
+    if (capture.get_socket() >= 0)
+        capture.close();
+    server.close();
+    client.close();
+}
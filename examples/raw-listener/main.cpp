@@ -4,7 +4,7 @@
 using namespace unisock;
 using namespace unisock::raw::actions;
 
-int main()
+int main(int argc, char** argv)
 {
     /* basic implementation of udp server using raw interface */
     raw::socket socket { };
@@ -15,7 +15,9 @@ int main()
     });
 
     socket.on<RECVFROM>([](const socket_address& address, const char* message, size_t message_len){
-        std::cout << "received message from " << address.to_string() << ": " << std::string(message, message_len) << std::endl;
+        char from[socket_address::FORMAT_BUFFER_SIZE];
+        address.format(from, sizeof(from));
+        std::cout << "received message from " << from << ": " << std::string(message, message_len) << std::endl;
     });
 
     socket.on<basic_actions::ERROR>([](const std::string& func, int message){
@@ -28,6 +30,20 @@ int main()
     if (!socket.bind())
         return (1);
 
+#if defined(__linux__)
+    /* only messages starting with argv[1] leave the kernel */
+    if (argc > 1)
+    {
+        raw::filter_builder filter { AF_INET };
+        filter.protocol(IPPROTO_UDP).payload_prefix(argv[1]);
+        if (!socket.attach_filter(filter))
+            return (1);
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+
     while (events::poll(socket))
         ;
     
@@ -0,0 +1,95 @@
+#include "raw/socket.hpp"
+#include "udp/socket.hpp"
+
+#include <chrono>
+#include <netinet/ip.h>
+
+using namespace unisock;
+using namespace unisock::raw::actions;
+
+/* captures udp datagrams sent on loopback with an AF_PACKET socket, either read in place from a TPACKET_V3 ring
+   or copied with recvfrom, and reports the capture rate of both paths */
+
+static const uint16_t   PORT = 8010;
+
+// returns true if **data** is an ethernet frame holding an IPv4 udp datagram sent to PORT
+static bool     is_capture_target(const char* data, size_t length)
+{
+    const size_t ip_offset = sizeof(ethhdr);
+    if (length < ip_offset + sizeof(iphdr) + sizeof(udphdr))
+        return (false);
+    const iphdr* ip = reinterpret_cast<const iphdr*>(data + ip_offset);
+    if (ip->protocol != IPPROTO_UDP)
+        return (false);
+    const udphdr* udp = reinterpret_cast<const udphdr*>(data + ip_offset + ip->ihl * 4);
+    return (ntohs(udp->dest) == PORT);
+}
+
+int main(int argc, char** argv)
+{
+    const bool      use_ring = argc < 2 || std::string(argv[1]) != "copy";
+    const size_t    n_messages = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    raw::socket capture { handler };
+    udp::socket client { handler };
+    size_t      captured = 0;
+
+    // loopback packets are captured twice, when sent (PACKET_OUTGOING) and when received
+    capture.on<PACKET>([&captured](const raw::packet_frame& frame){
+        if (frame.packet_type != PACKET_OUTGOING && is_capture_target(frame.data, frame.length))
+            ++captured;
+    });
+
+    capture.on<RECVFROM>([&captured](const socket_address& address, const char* message, size_t message_len){
+        if (reinterpret_cast<const sockaddr_ll*>(address.to<sockaddr>())->sll_pkttype != PACKET_OUTGOING && is_capture_target(message, message_len))
+            ++captured;
+    });
+
+    capture.on<basic_actions::ERROR>([](const std::string& func, int error){
+        std::cout << "error: " << func << ": " << strerror(error) << std::endl;
+    });
+
+    if (!capture.open(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL)))
+        return (1);
+    if (use_ring && !capture.set_packet_ring(1 << 20, 64, 2048, 5))
+        return (1);
+    if (!use_ring)
+        capture.on<basic_actions::READABLE>([&capture](){
+            // one syscall and one copy per packet, until the socket is drained
+            while (capture.recvfrom())
+                ;
+        });
+    if (!capture.bind_interface("lo") || !client.open(AF_INET))
+        return (1);
+
+    const socket_address    target = socket_address::from("127.0.0.1", PORT, AF_INET);
+    const std::string       payload(64, 'x');
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t sent = 0; sent < n_messages; )
+    {
+        // sends in bursts so that the capture socket is drained between them
+        for (size_t burst = 0; burst < 256 && sent < n_messages; ++burst, ++sent)
+            client.send_to(target, payload.c_str(), payload.size());
+        events::poll(handler, 0);
+    }
+    // waits for the retire timeout of the last block
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (captured < n_messages && std::chrono::steady_clock::now() < deadline)
+        events::poll(handler, 10);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (use_ring ? "ring" : "copy") << ": captured " << captured << "/" << n_messages
+              << " datagrams in " << seconds << "s (" << captured / seconds << " datagrams/s)" << std::endl;
+
+    if (use_ring)
+    {
+        raw::packet_ring_stats stats;
+        if (capture.get_ring_stats(stats))
+            std::cout << "ring: " << stats.packets << " packets, " << stats.drops << " drops, " << stats.freezes << " freezes" << std::endl;
+    }
+
+    capture.close();
+    client.close();
+}
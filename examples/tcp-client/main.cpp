@@ -22,7 +22,9 @@ int main()
     });
 
     client.on<RECEIVE>([](tcp::client::connection* connection, const char* message, size_t bytes){
-        std::cout << "received from connection " << socket_address::get_ip(connection->address) << ": " << std::string(message, bytes) << std::endl;
+        char from[socket_address::FORMAT_BUFFER_SIZE];
+        connection->address.format(from, sizeof(from));
+        std::cout << "received from connection " << from << ": " << std::string(message, bytes) << std::endl;
     });
 
     client.on<basic_actions::ERROR>([](const std::string& func, int err){
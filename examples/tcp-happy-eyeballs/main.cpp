@@ -0,0 +1,46 @@
+#include "tcp/client.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+using namespace tcp::common_actions;
+using namespace tcp::client_actions;
+
+/* connects to every address of a dual-stack hostname at once (happy eyeballs),
+   prints the address that won the race and the time it took */
+
+int main(int argc, char** argv)
+{
+    const std::string   hostname = argc > 1 ? argv[1] : "localhost";
+    const ushort        port = argc > 2 ? static_cast<ushort>(std::atoi(argv[2])) : 8000;
+    const int           attempt_delay_ms = argc > 3 ? std::atoi(argv[3]) : tcp::client::DEFAULT_ATTEMPT_DELAY;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    tcp::client client { handler };
+
+    const auto  start = std::chrono::steady_clock::now();
+    bool        connected = false;
+
+    client.on<CONNECT>([&start, &connected](tcp::client::connection* connection){
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        char address[socket_address::FORMAT_BUFFER_SIZE];
+        connection->address.format(address, sizeof(address));
+        std::cout << "connected to " << address << " in " << elapsed.count() << " us" << std::endl;
+        connected = true;
+        connection->close();
+    });
+
+    client.on<basic_actions::ERROR>([&start](const std::string& func, int err){
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "error: " << func << ": " << strerror(err) << " after " << elapsed.count() << " us" << std::endl;
+    });
+
+    // the race runs from events::poll, other sockets of the handler are still served meanwhile
+    client.connect_any(hostname, port, std::chrono::milliseconds(attempt_delay_ms), std::chrono::seconds(10));
+
+    while (events::poll( handler ))
+        ;
+
+    client.close();
+    return (connected ? 0 : 1);
+}
@@ -17,7 +17,9 @@ int main()
     });
 
     server.on<RECEIVE>([&server](tcp::server::client_connection* conn, const char* message, size_t bytes){
-        std::cout << "received from " << socket_address::get_ip(conn->address) << ": " << std::string(message, bytes) << std::endl;       
+        char from[socket_address::FORMAT_BUFFER_SIZE];
+        conn->address.format(from, sizeof(from));
+        std::cout << "received from " << from << ": " << std::string(message, bytes) << std::endl;
 
 
         if (std::string(message, bytes) == "close\n")
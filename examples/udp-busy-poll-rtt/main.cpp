@@ -0,0 +1,128 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstring>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* measures udp round trip time on loopback with and without busy polling on the client handler,
+   an echo server runs in its own thread on its own handler.
+   each ping carries its sequence number and waits at most timeout for its reply, replies that do not
+   arrive in time are counted as lost and late replies to older pings are ignored */
+
+struct  rtt_result
+{
+    double  avg_rtt;
+    size_t  lost;
+};
+
+static rtt_result   run_rtt(size_t n_messages, std::chrono::milliseconds timeout, const events::busy_poll_config& config, events::busy_poll_stats& stats)
+{
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    handler->set_busy_poll(config);
+
+    udp::socket client { handler };
+    socket_address server_address = socket_address::from("127.0.0.1", 8000, AF_INET);
+
+    size_t  sequence = 0;
+    size_t  received = 0;
+    size_t  lost = 0;
+    std::chrono::steady_clock::time_point send_time;
+    std::chrono::nanoseconds total_rtt { 0 };
+
+    client.on<RECEIVE>([&](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        size_t  reply;
+        if (message_len != sizeof(reply))
+            return;
+        std::memcpy(&reply, message, sizeof(reply));
+        if (reply != sequence)
+            return;
+        total_rtt += std::chrono::steady_clock::now() - send_time;
+        ++received;
+    });
+
+    client.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "client error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    client.bind("127.0.0.1", 8001);
+
+    for (sequence = 0; sequence < n_messages; ++sequence)
+    {
+        send_time = std::chrono::steady_clock::now();
+        const std::chrono::steady_clock::time_point deadline = send_time + timeout;
+        client.send_to(server_address, reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+
+        const size_t expected = received + 1;
+        while (received < expected)
+        {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                ++lost;
+                break;
+            }
+            events::poll(handler, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+        }
+    }
+
+    stats = handler->get_busy_poll_stats();
+    client.close();
+    return { received ? static_cast<double>(total_rtt.count()) / received : 0, lost };
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_messages = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const long   spin_us = argc > 2 ? std::atol(argv[2]) : 50;
+    const std::chrono::milliseconds timeout { argc > 3 ? std::atol(argv[3]) : 100 };
+
+    std::atomic<bool> running { true };
+    udp::socket server {};
+
+    server.on<RECEIVE>([&server](const socket_address& address, const char* message, size_t message_len) {
+        server.send_to(address, message, message_len);
+    });
+
+    server.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "server error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!server.bind("127.0.0.1", 8000))
+        return (1);
+
+    std::thread server_thread([&server, &running](){
+        while (running && events::poll(server, 100))
+            ;
+    });
+
+    events::busy_poll_stats blocking_stats;
+    events::busy_poll_stats spin_stats;
+
+    events::busy_poll_config blocking {};
+    events::busy_poll_config spinning {};
+    spinning.spin = std::chrono::microseconds(spin_us);
+    spinning.min_spin = std::chrono::microseconds(1);
+    spinning.adaptive = true;
+    spinning.socket_busy_poll = spin_us;
+
+    rtt_result blocking_rtt = run_rtt(n_messages, timeout, blocking, blocking_stats);
+    rtt_result spin_rtt = run_rtt(n_messages, timeout, spinning, spin_stats);
+
+    running = false;
+    server_thread.join();
+    server.close();
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_messages << " messages" << std::endl << std::endl
+              << "blocking poll:   avg rtt " << (blocking_rtt.avg_rtt / 1000) << "us, lost " << blocking_rtt.lost << std::endl
+              << "busy poll (" << spin_us << "us adaptive spin): avg rtt " << (spin_rtt.avg_rtt / 1000) << "us, lost " << spin_rtt.lost << std::endl
+              << "  spin polls:       " << spin_stats.spin_polls << std::endl
+              << "  spin wakeups:     " << spin_stats.spin_wakeups << std::endl
+              << "  blocking wakeups: " << spin_stats.blocking_wakeups << std::endl
+              << "  spin ratio:       " << spin_stats.spin_ratio() << std::endl;
+}
@@ -12,7 +12,9 @@ int main()
 
 
     client.on<RECEIVE>([](const socket_address& address, const char* message,  size_t message_len) {
-        std::cout << "received from " << socket_address::get_ip(address) << ":" << std::endl;
+        char from[socket_address::FORMAT_BUFFER_SIZE];
+        address.format(from, sizeof(from));
+        std::cout << "received from " << from << ":" << std::endl;
         std::cout << std::string(message, message_len) << std::endl;
         
     });
@@ -0,0 +1,67 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* udp ping-pong with a fixed peer on loopback, compares sendto/recvfrom with
+   a connected udp socket using send/recv (see udp::socket::connect) */
+
+static void     run_ping_pong(size_t n_messages, bool connected)
+{
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    udp::socket server { handler };
+    udp::socket client { handler };
+    size_t      received = 0;
+
+    server.on<RECEIVE>([&server](const socket_address& address, const char* message, size_t message_len){
+        server.send_to(address, message, message_len);
+    });
+
+    client.on<RECEIVE>([&received](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++received;
+    });
+
+    client.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "client error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!server.bind("127.0.0.1", 8000) || !client.bind("127.0.0.1", 8001))
+        return ;
+    if (connected && !client.connect(server.address))
+        return ;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n_messages; ++i)
+    {
+        if (connected)
+            client.send("ping", 4);
+        else
+            client.send_to(server.address, "ping", 4);
+
+        const size_t expected = received + 1;
+        while (received < expected && events::poll(handler, 100))
+            ;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    server.close();
+    client.close();
+
+    std::cout << (connected ? "connect + send/recv: " : "sendto/recvfrom:     ")
+              << received << "/" << n_messages << " round trips, avg " << (static_cast<double>(elapsed) / n_messages / 1000) << "us" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_messages = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_messages << " round trips" << std::endl << std::endl;
+    run_ping_pong(n_messages, false);
+    run_ping_pong(n_messages, true);
+}
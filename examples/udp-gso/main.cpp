@@ -0,0 +1,77 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* bulk udp stream of fixed size datagrams on loopback, compares:
+   - one sendto per datagram, one recvfrom per datagram
+   - send-side segmentation (UDP_SEGMENT) and receive-side coalescing (UDP_GRO) */
+
+static void     run_stream(size_t n_runs, size_t run_length, uint16_t datagram_size, bool offload)
+{
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    udp::socket sender { handler };
+    udp::socket receiver { handler };
+    size_t      received = 0;
+    size_t      received_bytes = 0;
+
+    receiver.on<RECEIVE>([&](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        ++received;
+        received_bytes += message_len;
+    });
+
+    receiver.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "receiver error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    sender.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "sender error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!receiver.bind("127.0.0.1", 8000) || !sender.bind("127.0.0.1", 8001))
+        return ;
+    if (offload && !receiver.set_gro(8))
+        return ;
+
+    const std::vector<char> run(run_length * datagram_size, 'x');
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n_runs; ++i)
+    {
+        if (offload)
+            sender.send_segments(receiver.address, run.data(), run.size(), datagram_size);
+        else
+        {
+            for (size_t datagram = 0; datagram < run_length; ++datagram)
+                sender.send_to(receiver.address, run.data() + datagram * datagram_size, datagram_size);
+        }
+
+        const size_t expected = (i + 1) * run_length;
+        while (received < expected && events::poll(handler, 100))
+            ;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    sender.close();
+    receiver.close();
+
+    std::cout << (offload ? "UDP_SEGMENT + UDP_GRO: " : "sendto + recvfrom:     ")
+              << received << "/" << n_runs * run_length << " datagrams (" << received_bytes << " bytes) in "
+              << ((float)elapsed / 1000) << "ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_runs = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const size_t run_length = argc > 2 ? std::atoi(argv[2]) : 32;
+    const uint16_t datagram_size = argc > 3 ? std::atoi(argv[3]) : 1200;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_runs << " runs of " << run_length << " datagrams of " << datagram_size << " bytes" << std::endl << std::endl;
+    run_stream(n_runs, run_length, datagram_size, false);
+    run_stream(n_runs, run_length, datagram_size, true);
+}
@@ -0,0 +1,67 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+
+#if defined(__linux__)
+# include <sys/prctl.h>
+#endif
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* sends datagrams at a fixed period using events::run_until between sends,
+   and reports how late each send was compared to its deadline */
+
+int main(int argc, char** argv)
+{
+    const size_t n_messages = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const long   period_us = argc > 2 ? std::atol(argv[2]) : 250;
+
+#if defined(__linux__)
+    // default timer slack (50us) delays ppoll wakeups, reduce it for this thread
+    prctl(PR_SET_TIMERSLACK, 1);
+#endif
+
+    udp::socket socket {};
+    size_t      received = 0;
+
+    socket.on<RECEIVE>([&received](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++received;
+    });
+
+    socket.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!socket.bind("127.0.0.1", 8000))
+        return (1);
+
+    const std::chrono::microseconds period { period_us };
+    std::chrono::nanoseconds total_lateness { 0 };
+    std::chrono::nanoseconds max_lateness { 0 };
+
+    auto deadline = std::chrono::steady_clock::now() + period;
+    for (size_t i = 0; i < n_messages; ++i)
+    {
+        if (!events::run_until(socket.get_handler(), deadline))
+            break;
+
+        std::chrono::nanoseconds lateness = std::chrono::steady_clock::now() - deadline;
+        total_lateness += lateness;
+        max_lateness = std::max(max_lateness, lateness);
+
+        socket.send_to(socket.address, "tick", 4);
+        deadline += period;
+    }
+    events::poll(socket, 10);
+
+    socket.close();
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_messages << " messages every " << period_us << "us (" << received << " received)" << std::endl << std::endl
+              << "  avg lateness: " << (static_cast<double>(total_lateness.count()) / n_messages / 1000) << "us" << std::endl
+              << "  max lateness: " << (static_cast<double>(max_lateness.count()) / 1000) << "us" << std::endl;
+}
@@ -0,0 +1,79 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* compares udp receive throughput on loopback with one recvfrom per readable event
+   and with batched receive (recvmmsg), a sender thread floods the receiver with small datagrams */
+
+static void     run_receive(size_t n_messages, size_t batch_size)
+{
+    udp::socket receiver {};
+    size_t      received = 0;
+    size_t      batches = 0;
+
+    receiver.on<RECEIVE>([&received](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++received;
+    });
+
+    receiver.on<RECEIVE_BATCH>([&batches](const raw::datagram* datagrams, size_t count){
+        (void)datagrams;
+        (void)count;
+        ++batches;
+    });
+
+    receiver.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "receiver error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    receiver.set_recv_batch(batch_size);
+    if (!receiver.bind("127.0.0.1", 8000))
+        return ;
+
+    std::thread sender_thread([n_messages](){
+        raw::socket sender {};
+        sender.open(AF_INET, SOCK_DGRAM, 0);
+        socket_address address = socket_address::from("127.0.0.1", 8000, AF_INET);
+        for (size_t i = 0; i < n_messages; ++i)
+            sender.send_to(address, "telemetry", 9);
+        sender.close();
+    });
+
+    size_t  polls = 0;
+    auto    start = std::chrono::steady_clock::now();
+    auto    last = start;
+    // stops when all messages were received or when nothing was received for 100ms (datagrams dropped)
+    while (received < n_messages && std::chrono::steady_clock::now() - last < std::chrono::milliseconds(100))
+    {
+        const size_t before = received;
+        events::poll(receiver, 10);
+        ++polls;
+        if (received != before)
+            last = std::chrono::steady_clock::now();
+    }
+    sender_thread.join();
+    receiver.close();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(last - start).count();
+    std::cout << (batch_size == 0 ? "recvfrom:        " : "recvmmsg (batch): ")
+              << received << "/" << n_messages << " received in " << ((float)elapsed / 1000) << "ms, "
+              << polls << " polls, " << batches << " batches, "
+              << (elapsed > 0 ? static_cast<double>(received) / elapsed : 0) << " Mpps" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_messages = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const size_t batch_size = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_messages << " messages, batch of " << batch_size << std::endl << std::endl;
+    run_receive(n_messages, 0);
+    run_receive(n_messages, batch_size);
+}
@@ -0,0 +1,65 @@
+#include "udp/socket.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* bursty udp responder: every request received is answered with a burst of datagrams,
+   compares one sendto per datagram with the outbound queue flushed with sendmmsg */
+
+static void     run_burst(size_t n_requests, size_t burst, size_t batch_size)
+{
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    udp::socket responder { handler };
+    udp::socket client { handler };
+    size_t      responses = 0;
+
+    responder.on<RECEIVE>([&responder, burst](const socket_address& address, const char* message, size_t message_len){
+        for (size_t i = 0; i < burst; ++i)
+            responder.send_to(address, message, message_len);
+    });
+
+    client.on<RECEIVE>([&responses](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++responses;
+    });
+
+    responder.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "responder error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    responder.set_send_batch(batch_size);
+    if (!responder.bind("127.0.0.1", 8000) || !client.bind("127.0.0.1", 8001))
+        return ;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n_requests; ++i)
+    {
+        client.send_to(responder.address, "request", 7);
+
+        const size_t expected = responses + burst;
+        while (responses < expected && events::poll(handler, 100))
+            ;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    responder.close();
+    client.close();
+
+    std::cout << (batch_size == 0 ? "sendto:             " : "sendmmsg (queued):  ")
+              << responses << "/" << n_requests * burst << " responses in " << ((float)elapsed / 1000) << "ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_requests = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const size_t burst = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_requests << " requests, bursts of " << burst << " datagrams" << std::endl << std::endl;
+    run_burst(n_requests, burst, 0);
+    run_burst(n_requests, burst, burst);
+}
@@ -8,7 +8,11 @@ int main()
     udp::socket server {};
 
     server.on<RECEIVE>([&server](const socket_address& address, const char* message, size_t message_len) {
-        std::cout << "received from " << socket_address::get_ip(address) << " on endpoint listening on " << socket_address::get_ip(server.address) << ":" << std::endl;
+        char from[socket_address::FORMAT_BUFFER_SIZE];
+        char local[socket_address::FORMAT_BUFFER_SIZE];
+        address.format(from, sizeof(from));
+        server.address.format(local, sizeof(local));
+        std::cout << "received from " << from << " on endpoint listening on " << local << ":" << std::endl;
         std::cout << std::string(message, message_len) << std::endl;
         server.send_to(address, "received msg", 13);
     });
@@ -0,0 +1,84 @@
+#include "udp/sessions.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace unisock;
+using namespace unisock::udp::session_actions;
+
+/* udp server keeping a per-peer counter in a session, many clients send a few datagrams each,
+   sessions are created on the first datagram of a peer and expired after an idle timeout */
+
+struct peer_stats
+{
+    size_t  datagrams = 0;
+    size_t  bytes = 0;
+};
+
+using server_type = udp::session_server_of<peer_stats>;
+
+int main(int argc, char** argv)
+{
+    const size_t n_clients = argc > 1 ? std::atoi(argv[1]) : 200;
+    const size_t n_messages = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    server_type server {};
+    size_t      new_peers = 0;
+    size_t      expired_peers = 0;
+    size_t      received = 0;
+
+    server.on<NEW_PEER>([&new_peers](server_type::session_type* session){
+        (void)session;
+        ++new_peers;
+    });
+
+    server.on<RECEIVE>([&server, &received](server_type::session_type* session, const char* message, size_t message_len){
+        ++session->data.datagrams;
+        session->data.bytes += message_len;
+        ++received;
+        server.send_to(session, message, message_len);
+    });
+
+    server.on<PEER_EXPIRED>([&expired_peers](server_type::session_type* session){
+        (void)session;
+        ++expired_peers;
+    });
+
+    server.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "server error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    server.set_idle_timeout(std::chrono::milliseconds(200));
+    if (!server.bind("127.0.0.1", 8000))
+        return (1);
+
+    std::vector<std::unique_ptr<udp::socket>> clients;
+    for (size_t i = 0; i < n_clients; ++i)
+    {
+        clients.emplace_back(new udp::socket(server.get_handler()));
+        clients.back()->open(AF_INET);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t message = 0; message < n_messages; ++message)
+    {
+        const size_t expected = received + n_clients;
+        for (auto& client : clients)
+            client->send_to(server.address, "hello", 5);
+        // stops when all datagrams were received or when nothing was received for 100ms (datagrams dropped)
+        while (received < expected && events::poll(server.get_handler(), 100))
+            ;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << received << "/" << n_clients * n_messages << " datagrams from " << new_peers << " peers in "
+              << ((float)elapsed / 1000) << "ms, " << server.session_count() << " sessions" << std::endl;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    server.expire();
+    std::cout << expired_peers << " sessions expired, " << server.session_count() << " left" << std::endl;
+
+    for (auto& client : clients)
+        client->close();
+    server.close();
+}
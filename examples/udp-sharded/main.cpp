@@ -0,0 +1,83 @@
+#include "udp/sharded.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* udp collector on loopback fed by several sender threads (one flow per sender),
+   compares one socket drained by one thread with SO_REUSEPORT shards drained by one thread each */
+
+static void     run_collector(size_t n_shards, size_t n_senders, size_t n_messages, udp::shard_steering steering)
+{
+    udp::sharded_socket collector { n_shards };
+
+    collector.on<RECEIVE>([](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        // simulates some processing per datagram
+        volatile size_t work = 0;
+        for (size_t i = 0; i < 200; ++i)
+            work = work + i;
+    });
+
+    collector.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "collector error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    for (size_t index = 0; index < collector.shard_count(); ++index)
+        collector.shard(index).set_recv_batch(32);
+
+    if (!collector.bind("127.0.0.1", 0, false, steering))
+        return ;
+    collector.start(10);
+
+    const socket_address address = collector.address();
+    std::vector<std::thread> senders;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t sender = 0; sender < n_senders; ++sender)
+    {
+        senders.emplace_back([address, n_messages](){
+            raw::socket socket {};
+            socket.open(AF_INET, SOCK_DGRAM, 0);
+            for (size_t i = 0; i < n_messages; ++i)
+                socket.send_to(address, "telemetry", 9);
+            socket.close();
+        });
+    }
+    for (std::thread& sender : senders)
+        sender.join();
+
+    // waits for shards to drain their queues
+    size_t received = collector.stats().datagrams;
+    do
+    {
+        received = collector.stats().datagrams;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    while (collector.stats().datagrams != received);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() - 50000;
+
+    collector.close();
+
+    std::cout << n_shards << " shard(s): " << received << "/" << n_senders * n_messages << " received in "
+              << ((float)elapsed / 1000) << "ms, per shard:";
+    for (size_t index = 0; index < collector.shard_count(); ++index)
+        std::cout << " " << collector.stats(index).datagrams;
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_shards = argc > 1 ? std::atoi(argv[1]) : 4;
+    const size_t n_senders = argc > 2 ? std::atoi(argv[2]) : 8;
+    const size_t n_messages = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_senders << " senders of " << n_messages << " datagrams" << std::endl << std::endl;
+    run_collector(1, n_senders, n_messages, udp::shard_steering::DEFAULT);
+    run_collector(n_shards, n_senders, n_messages, udp::shard_steering::DEFAULT);
+    run_collector(n_shards, n_senders, n_messages, udp::shard_steering::CPU);
+}
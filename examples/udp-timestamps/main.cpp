@@ -0,0 +1,90 @@
+#include "udp/socket.hpp"
+#include "events/instrumentation.hpp"
+
+#include <chrono>
+
+using namespace unisock;
+using namespace unisock::udp::actions;
+
+/* udp ping-pong on loopback with kernel timestamps, reports:
+   - the delay between the kernel receive timestamp and the RECEIVE hook (time spent in socket queue and event loop)
+   - the delay between send_to and the kernel send timestamp read from the error queue */
+
+static uint64_t to_nanoseconds(const timespec& time)
+{
+    return (static_cast<uint64_t>(time.tv_sec) * 1000000000 + time.tv_nsec);
+}
+
+static uint64_t realtime_now()
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (to_nanoseconds(now));
+}
+
+static void     print_histogram(const std::string& name, const events::latency_histogram& histogram)
+{
+    std::cout << name << ": " << histogram.count() << " samples, p50 " << histogram.percentile(50) / 1000.0
+              << "us, p99 " << histogram.percentile(99) / 1000.0 << "us, max " << histogram.max() / 1000.0 << "us" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n_messages = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+    udp::socket server { handler };
+    udp::socket client { handler };
+    size_t      received = 0;
+
+    events::latency_histogram   receive_delay;
+    events::latency_histogram   send_delay;
+    std::vector<uint64_t>       send_times;
+
+    server.on<RECEIVE>([&server, &receive_delay](const socket_address& address, const char* message, size_t message_len){
+        const packet_timestamps& timestamps = server.get_timestamps();
+        if (timestamps.has_software)
+            receive_delay.record(realtime_now() - to_nanoseconds(timestamps.software));
+        server.send_to(address, message, message_len);
+    });
+
+    client.on<RECEIVE>([&received](const socket_address& address, const char* message, size_t message_len){
+        (void)address;
+        (void)message;
+        (void)message_len;
+        ++received;
+    });
+
+    client.on<basic_actions::TX_TIMESTAMP>([&send_times, &send_delay](const packet_timestamps& timestamps){
+        if (timestamps.has_software && timestamps.key < send_times.size())
+            send_delay.record(to_nanoseconds(timestamps.software) - send_times[timestamps.key]);
+    });
+
+    client.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "client error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!server.bind("127.0.0.1", 8000) || !client.bind("127.0.0.1", 8001))
+        return (1);
+    if (!server.set_timestamping(TIMESTAMP_RX_SOFTWARE) || !client.set_timestamping(TIMESTAMP_TX_SOFTWARE))
+        return (1);
+
+    send_times.reserve(n_messages);
+    for (size_t i = 0; i < n_messages; ++i)
+    {
+        send_times.push_back(realtime_now());
+        client.send_to(server.address, "ping", 4);
+        while (received < i + 1 && events::poll(handler, 100))
+            ;
+    }
+    // reads send timestamps of the last messages
+    client.recv_errqueue();
+
+    std::cout << "*************************************" << std::endl
+              << "results for " << n_messages << " ping-pongs" << std::endl << std::endl;
+    print_histogram("kernel receive -> RECEIVE hook", receive_delay);
+    print_histogram("send_to -> kernel send        ", send_delay);
+
+    server.close();
+    client.close();
+}
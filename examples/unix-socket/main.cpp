@@ -0,0 +1,53 @@
+#include "tcp/client.hpp"
+#include "tcp/server.hpp"
+
+using namespace unisock;
+using namespace tcp::common_actions;
+
+/* echo server and client over a unix domain socket, with the same actions as tcp,
+   usage: unix-socket [path] [abstract] */
+
+int main(int argc, char** argv)
+{
+    const std::string   path = argc > 1 ? argv[1] : "/tmp/unisock-example.sock";
+    const bool          abstract = argc > 2 && std::string(argv[2]) == "abstract";
+
+    std::shared_ptr<events::handler> handler = std::make_shared<events::handler>();
+
+    tcp::server server { handler };
+    tcp::client client { handler };
+
+    server.on<RECEIVE>([](tcp::server::client_connection* connection, const char* message, size_t bytes){
+        connection->send(message, bytes);
+    });
+
+    client.on<tcp::client_actions::CONNECT>([](tcp::client::connection* connection){
+        char address[sizeof(sockaddr_un::sun_path) + 1];
+        connection->address.format(address, sizeof(address));
+        std::cout << "connected to " << address << std::endl;
+        connection->send("hello world", 11);
+    });
+
+    client.on<RECEIVE>([&server](tcp::client::connection* connection, const char* message, size_t bytes){
+        std::cout << "received: " << std::string(message, bytes) << std::endl;
+        connection->close();
+        server.close();
+    });
+
+    server.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "server error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    client.on<basic_actions::ERROR>([](const std::string& func, int err){
+        std::cout << "client error: " << func << ": " << strerror(err) << std::endl;
+    });
+
+    if (!server.listen_unix(path, abstract) || !client.connect_unix(path, abstract))
+        return (1);
+
+    while (events::poll( handler ))
+        ;
+
+    if (!abstract)
+        ::unlink(path.c_str());
+}
@@ -13,6 +13,11 @@
 
 #include <functional>
 #include <type_traits>
+#include <typeinfo>
+
+#ifdef ENABLE_INSTRUMENTATION
+# include "events/instrumentation.hpp"
+#endif
 
 /**
  * @addindex
@@ -125,6 +130,10 @@ struct action
     template<typename ..._Args>
     void    execute(_Args&&... args)
     {
+#ifdef ENABLE_INSTRUMENTATION
+        // records callbacks duration in the instrumentation of the handler dispatching on this thread, if any
+        _lib::action_timer  timer(executor_list.empty() ? nullptr : _ActionTag::action_name);
+#endif
         for (action_callback& executor : executor_list)
         {
             if (executor.flags & action_flag::SKIP)
@@ -173,6 +182,13 @@ class action_handler<actions_list<_Actions...>>
          */
         explicit action_handler() = default;
 
+        action_handler(const action_handler& copy) = default;
+        action_handler(action_handler&& move) = default;
+        action_handler& operator=(const action_handler& copy) = default;
+        action_handler& operator=(action_handler&& move) = default;
+
+        virtual ~action_handler() = default;
+
   
         /**
          * @brief statically get an action from the action handler, used by action_handler::execute (see specializations details for more informations)
@@ -267,9 +283,23 @@ class action_handler<actions_list<_Actions...>>
             std::get<action_type>(actions).add_callback(
                 static_cast<typename action_type::function_prototype>(function), flags
             );
+            this->action_hooked(typeid(_ActionType));
         }
 
     protected:
+        /**
+         * @brief   called by on() after a task was added to the action of tag **action**
+         *
+         * @details lets derived classes react to new hooks whatever the type on() was called through
+         *          (derived class or action_handler reference), does nothing by default
+         *
+         * @param action    type of the tag of the hooked action
+         */
+        virtual void    action_hooked(const std::type_info& action)
+        {
+            (void)action;
+        }
+
         /**
          * @brief executes all tasks of the action of type _ActionType
          * 
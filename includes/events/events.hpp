@@ -33,19 +33,109 @@ namespace unisock {
 namespace events {
 
 
+/**
+ * @addindex
+ */
+namespace _lib {
+
+/**
+ * @brief   busy polling run mode of events::poll, spins on poll_impl with zero timeout before blocking
+ * @details spins for the current spin time of the handler (bounded by **timeout**), if no socket became ready
+ *          while spinning, blocks on poll_impl for the rest of **timeout**. the spin time is adapted
+ *          after each call when busy_poll_config::adaptive is set.
+ * 
+ * @tparam _Handler handler type
+ * @param handler   the handler to poll on
+ * @param timeout   timeout for poll, negative waits indefinitely
+ * 
+ * @return the number of sockets that were ready
+ */
+template<handler_types _Handler>
+int                     busy_poll_impl(std::shared_ptr<unisock::events::handler> handler, std::chrono::nanoseconds timeout)
+{
+    using clock = std::chrono::steady_clock;
+
+    const busy_poll_config& config = handler->busy_poll;
+    busy_poll_stats&        stats = handler->busy_poll_statistics;
+
+    std::chrono::nanoseconds spin = config.adaptive ? handler->spin : config.spin;
+    if (timeout.count() >= 0 && timeout < spin)
+        spin = timeout;
+
+    const clock::time_point start = clock::now();
+    const clock::time_point spin_end = start + spin;
+    do
+    {
+        ++stats.spin_polls;
+        int n_ready = poll_impl<_Handler>(handler, std::chrono::nanoseconds::zero());
+        if (n_ready > 0)
+        {
+            ++stats.spin_wakeups;
+            if (config.adaptive)
+                handler->spin = std::min(config.spin, std::max(handler->spin * 2, std::chrono::microseconds(1)));
+            return (n_ready);
+        }
+        // all sockets may have been closed by a requeued socket dispatch
+        if (handler->empty())
+            return (0);
+    }
+    while (clock::now() < spin_end);
+
+    ++stats.blocking_wakeups;
+    if (config.adaptive)
+        handler->spin = std::max(config.min_spin, handler->spin / 2);
+
+    std::chrono::nanoseconds remaining = timeout;
+    if (timeout.count() >= 0)
+    {
+        std::chrono::nanoseconds elapsed = clock::now() - start;
+        remaining = elapsed < timeout ? timeout - elapsed : std::chrono::nanoseconds::zero();
+    }
+    return (poll_impl<_Handler>(handler, remaining));
+}
+
+} // ******** namespace _lib
+
+
+
+/**
+ * @brief       poll events on events::handler with a timeout of any precision
+ * 
+ * @details     if busy polling is enabled on handler (see events::handler::set_busy_poll), spins with zero-timeout polls before blocking,
+ *              timeout is passed with nanosecond precision to the handler implementation (see _lib::poll_impl)
+ * 
+ * @tparam _Rep     duration representation
+ * @tparam _Period  duration period
+ * 
+ * @param handler   the handler to poll on
+ * @param timeout   timeout for poll, negative waits indefinitely, 0 dont wait
+ */
+template<typename _Rep, typename _Period>
+bool                    poll(std::shared_ptr<unisock::events::handler> handler, std::chrono::duration<_Rep, _Period> timeout)
+{
+    if (handler->empty() && !handler->has_timers())
+        return (false);
+
+    const std::chrono::nanoseconds timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+    if (timeout_ns.count() != 0 && handler->get_busy_poll().spin.count() > 0)
+        unisock::events::_lib::busy_poll_impl<unisock::events::handler_type>(handler, timeout_ns);
+    else
+        unisock::events::_lib::poll_impl<unisock::events::handler_type>(handler, timeout_ns);
+    return (true);
+}
+
 
 /**
  * @brief       poll events on events::handler
  * 
+ * @details     if busy polling is enabled on handler (see events::handler::set_busy_poll), spins with zero-timeout polls before blocking
+ * 
  * @param handler   the handler to poll on
  * @param timeout   timeout in milliseconds for poll, -1 waits indefinitely, 0 dont wait
  */
 bool                    poll(std::shared_ptr<unisock::events::handler> handler, int timeout = -1)
 {
-    if (handler->empty())
-        return (false);
-    unisock::events::_lib::poll_impl<unisock::events::handler_type>(handler, timeout);
-    return (true);
+    return unisock::events::poll(handler, timeout < 0 ? std::chrono::nanoseconds(-1) : std::chrono::milliseconds(timeout));
 }
 
 
@@ -67,6 +157,50 @@ poll(_PollableEntity& entity, int timeout = -1)
     return unisock::events::poll(entity.get_handler(), timeout);
 }
 
+/**
+ * @brief   poll events on entity with a timeout of any precision
+ * 
+ * @tparam _PollableEntity type of the entity to poll on
+ * @tparam _Rep     duration representation
+ * @tparam _Period  duration period
+ * 
+ * @param entity    the entity to poll on 
+ * @param timeout   timeout for poll, negative waits indefinitely, 0 dont wait
+ */
+template<typename _PollableEntity, typename _Rep, typename _Period>
+typename std::enable_if<std::is_base_of<unisock::events::pollable_entity, _PollableEntity>::value, bool>::type
+poll(_PollableEntity& entity, std::chrono::duration<_Rep, _Period> timeout)
+{
+    return unisock::events::poll(entity.get_handler(), timeout);
+}
+
+
+/**
+ * @brief   polls events on events::handler until **deadline** is reached
+ * 
+ * @details polls repeatedly with the time left before **deadline** as timeout, so that the call returns
+ *          as close as possible to **deadline** (ppoll precision, see _lib::poll_impl), this can be used to pace sends
+ *          or run timers between polls.
+ * 
+ * @tparam _Clock       clock of the deadline
+ * @tparam _Duration    duration of the deadline
+ * 
+ * @param handler   the handler to poll on
+ * @param deadline  time point to return at
+ * 
+ * @return true when deadline was reached, false if handler has no socket to poll
+ */
+template<typename _Clock, typename _Duration>
+bool                    run_until(std::shared_ptr<unisock::events::handler> handler, const std::chrono::time_point<_Clock, _Duration>& deadline)
+{
+    for (typename _Clock::time_point now = _Clock::now(); now < deadline; now = _Clock::now())
+    {
+        if (!unisock::events::poll(handler, deadline - now))
+            return (false);
+    }
+    return (true);
+}
+
 
 } // ******** namespace events
 
@@ -15,6 +15,9 @@
 
 #include "socket/socket_base.hpp"
 
+#include <chrono>
+#include <memory>
+
 /**
  * @addindex
  */
@@ -61,8 +64,9 @@ enum  handler_types
 
 #  define _POLL_HANDLER handler_types::EPOLL
 
-# elif   defined(__APPLE__) || defined(__NetBSD__) || defined(__FreeBSD__)
+# elif   defined(__APPLE__) || defined(__NetBSD__) || defined(__FreeBSD__) || defined(__linux__)
 
+// there is no epoll handler yet, linux uses poll() too
 #  define _POLL_HANDLER handler_types::POLL
 //#  include "events/poll.hpp"
 
@@ -136,6 +140,17 @@ class handler_impl_base
          */
         virtual size_t  count() const = 0;
 
+        /**
+         * @brief returns true if **socket** is handled with **socket_ptr** attached to it
+         * 
+         * @details lets a hook caller check whether its socket was deleted without dereferencing it,
+         *          when ref_has_changed() only says that some socket was added or deleted
+         * 
+         * @param socket        socket file descriptor
+         * @param socket_ptr    socket object expected to be attached to descriptor
+         */
+        virtual bool    has_socket(int socket, const unisock::socket_base* socket_ptr) const = 0;
+
         /**
          * @brief set/unset read flag on socket for next poll on handler
          * 
@@ -151,6 +166,14 @@ class handler_impl_base
          * @param active        state to set to write event flag for socket
          */
         virtual void    socket_want_write(int socket, bool active) = 0;
+
+        /**
+         * @brief sets the direct dispatch table used by events::poll for socket
+         * 
+         * @param socket        socket descriptor in handler
+         * @param dispatch      dispatch table to copy for socket
+         */
+        virtual void    socket_set_dispatch(int socket, const unisock::socket_base::dispatch_table& dispatch) = 0;
 };
 
 
@@ -171,10 +194,24 @@ class handler_impl : public handler_impl_base {};
  * 
  * @tparam _Handler 
  * @param handler   the handler containing the sockets to poll
- * @param timeout   timeout in milliseconds for poll, -1 waits indefinitely, 0 dont wait
+ * @param timeout   timeout for poll, negative waits indefinitely, 0 dont wait
+ * 
+ * @return the number of sockets that were ready
+ */
+template<handler_types _Handler>
+int                     poll_impl(std::shared_ptr<unisock::events::handler> handler, std::chrono::nanoseconds timeout);
+
+/**
+ * @brief busy polling run mode of events::poll, spins on poll_impl with zero timeout before blocking (see events::busy_poll_config)
+ * 
+ * @tparam _Handler 
+ * @param handler   the handler containing the sockets to poll
+ * @param timeout   timeout for poll, negative waits indefinitely
+ * 
+ * @return the number of sockets that were ready
  */
 template<handler_types _Handler>
-void                    poll_impl(std::shared_ptr<unisock::events::handler> handler, int timeout);
+int                     busy_poll_impl(std::shared_ptr<unisock::events::handler> handler, std::chrono::nanoseconds timeout);
 
 
 } // ******** namespace _lib
@@ -59,6 +59,11 @@ class handler_impl<handler_types::POLL> : public handler_impl_base
          * @note  the socket and socket_ptrs vectors are always the same size, this way pointers to socket objects are retrieved directly by index
          */
         std::vector<unisock::socket_base*>          socket_ptrs;
+        /**
+         * @brief vector of direct dispatch tables of sockets, copied from socket_base::get_dispatch() when socket is added
+         * @note  this vector is always the same size as sockets, so that events::poll calls the socket dispatch by index without any virtual call
+         */
+        std::vector<unisock::socket_base::dispatch_table>   dispatchers;
 
         /**
          * @brief adds a socket to the handler
@@ -85,6 +90,14 @@ class handler_impl<handler_types::POLL> : public handler_impl_base
          */
         size_t  count() const override;
 
+        /**
+         * @brief returns true if **socket** is handled with **socket_ptr** attached to it
+         * 
+         * @param socket        socket file descriptor
+         * @param socket_ptr    socket object expected to be attached to descriptor
+         */
+        bool    has_socket(int socket, const unisock::socket_base* socket_ptr) const override;
+
         /**
          * @brief set/unset read flag on socket for next poll on handler
          * 
@@ -100,6 +113,14 @@ class handler_impl<handler_types::POLL> : public handler_impl_base
          * @param active        state to set to write event flag for socket 
          */
         void    socket_want_write(int socket, bool active = true) override;
+
+        /**
+         * @brief sets the direct dispatch table used by events::poll for socket
+         * 
+         * @param socket        socket descriptor in handler
+         * @param dispatch      dispatch table to copy for socket
+         */
+        void    socket_set_dispatch(int socket, const unisock::socket_base::dispatch_table& dispatch) override;
 };
 
 
@@ -16,6 +16,9 @@
 #endif
 
 #include <poll.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
 
 /**
  * @addindex
@@ -33,46 +36,215 @@ namespace events {
 namespace _lib {
 
 
+/**
+ * @brief   marks sockets requeued by the dispatch budget as ready for **event**, without waiting for poll to report them
+ * 
+ * @details sockets are found at the index recorded when they were requeued, they are only searched for
+ *          if sockets were added or deleted since and the index does not match their descriptor anymore
+ * 
+ * @tparam _Requeued requeued socket entry of the handler, with its descriptor and index
+ * @param sockets   pollfd vector of the handler
+ * @param requeued  sockets requeued by the handler, cleared by this call
+ * @param event     event to set in revents (POLLIN or POLLOUT)
+ * 
+ * @return the number of sockets that became ready by this call
+ */
+template<typename _Requeued>
+inline int  poll_requeue(std::vector<pollfd>& sockets, std::vector<_Requeued>& requeued, short event)
+{
+    int n_ready = 0;
+    for (const _Requeued& entry : requeued)
+    {
+        auto it = sockets.begin();
+        if (entry.index < sockets.size() && sockets[entry.index].fd == entry.socket)
+            it += entry.index;
+        else
+            it = std::find(sockets.begin(), sockets.end(), entry.socket);
+        // socket was deleted, or does not want the event anymore
+        if (it == sockets.end() || !(it->events & event))
+            continue ;
+        if (it->revents == 0)
+            ++n_ready;
+        it->revents |= event;
+    }
+    requeued.clear();
+    return (n_ready);
+}
+
+
 /**
  * @brief   events::poll implementation for poll.h, polls on all sockets stored in handler
- * @details this call will for every socket readable or writeable, respectively call the on_readable, and on_writeable members of their container, which indicates to the container to handle the appropriate event.
+ * @details this call will for every socket readable or writeable, respectively call the readable and writeable functions of their dispatch table,
+ *          which by default call the on_readable, and on_writeable members of their container, which indicates to the container to handle the appropriate event.
+ *          sockets can set a direct dispatch (see unisock::socket::set_dispatch) to route the event to their concrete recv()/accept() path without virtual calls.\n
+ *          dispatch is limited by the handler events::dispatch_budget, sockets that exhausted their quota, and sockets not dispatched
+ *          because the cycle budget was exhausted, are requeued and dispatched first next cycle.
+ *          that cycle dispatches them without calling poll, the cycle after it polls again even if sockets were requeued,
+ *          so that sockets that became ready meanwhile wait at most one cycle.\n
+ *          poll does not wait past the earliest timer of the handler, expired timers are called back after sockets are dispatched
+ *          (see events::handler::add_timer).
  * 
  * @tparam  
  * @param handler the handler to poll on
- * @param timeout timeout in milliseconds for poll, -1 waits indefinitely, 0 dont wait
+ * @param timeout timeout for poll, negative waits indefinitely, 0 dont wait, 
+ *                uses ppoll with nanosecond precision where available, otherwise timeout is rounded up to the next millisecond
+ *
+ * @note    when built with ENABLE_INSTRUMENTATION, poll calls, blocked time and dispatches are recorded in the handler instrumentation
+ * 
+ * @return the number of sockets that were ready, including requeued sockets
  */
 template<>
-void    poll_impl<handler_types::POLL>(std::shared_ptr<unisock::events::handler> handler, int timeout)
+int     poll_impl<handler_types::POLL>(std::shared_ptr<unisock::events::handler> handler, std::chrono::nanoseconds timeout)
 {
-    int n_changes = poll(reinterpret_cast<pollfd*>(handler->sockets.data()), handler->sockets.size(), timeout);
-    for (auto it = handler->sockets.begin(); it != handler->sockets.end(); ++it)
+    // requeued sockets still have pending data and will be dispatched this cycle, dont wait for other events,
+    // and dont poll at all unless last cycle did not poll either, so that other sockets are not starved
+    const bool requeued = !handler->requeued_readers.empty() || !handler->requeued_writers.empty();
+    const bool skip_poll = requeued && !handler->skipped_poll;
+    handler->skipped_poll = skip_poll;
+    if (requeued)
+        timeout = std::chrono::nanoseconds::zero();
+    // dont wait past the earliest timer
+    timeout = handler->timer_timeout(timeout);
+
+#ifdef ENABLE_INSTRUMENTATION
+    using instrumentation_clock = handler_instrumentation::clock;
+    instrumentation_snapshot& counters = handler->instrumentation.counters;
+#endif
+
+    int n_changes = 0;
+    if (!skip_poll)
+    {
+#ifdef ENABLE_INSTRUMENTATION
+        const instrumentation_clock::time_point poll_start = instrumentation_clock::now();
+#endif
+#if defined(__linux__)
+        struct timespec timeout_spec;
+        timeout_spec.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        timeout_spec.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+
+        n_changes = ppoll(reinterpret_cast<pollfd*>(handler->sockets.data()), handler->sockets.size(),
+                            timeout.count() < 0 ? nullptr : &timeout_spec, nullptr);
+#else
+        // rounds up so that poll never returns before timeout
+        int timeout_ms = -1;
+        if (timeout.count() >= 0)
+            timeout_ms = static_cast<int>((timeout.count() + 999999) / 1000000);
+
+        n_changes = poll(reinterpret_cast<pollfd*>(handler->sockets.data()), handler->sockets.size(), timeout_ms);
+#endif
+#ifdef ENABLE_INSTRUMENTATION
+        ++counters.poll_calls;
+        counters.blocked_time += instrumentation_clock::now() - poll_start;
+#endif
+    }
+    if (skip_poll || n_changes < 0)
     {
-        auto&   socket = *it;
-        ushort  handler_ref = handler->get_ref();
+        // revents still hold the last poll results, or are not updated on error,
+        // clear them so that only requeued sockets are dispatched
+        for (pollfd& socket : handler->sockets)
+            socket.revents = 0;
+        n_changes = 0;
+    }
+    n_changes += poll_requeue(handler->sockets, handler->requeued_readers, POLLIN);
+    n_changes += poll_requeue(handler->sockets, handler->requeued_writers, POLLOUT);
+
+    const int n_ready = n_changes;
+    handler->begin_cycle();
+
+#ifdef ENABLE_INSTRUMENTATION
+    counters.ready_events += n_ready;
+    // actions executed by dispatches record their duration in this handler
+    instrumentation_scope scope(&handler->instrumentation);
+#endif
 
-        if (socket.revents == 0)
+    // starts where the last cycle ran out of budget, so that sockets at the end of the handler are not starved,
+    // unless sockets were added or deleted since and the index does not designate the same socket anymore
+    const size_t count = handler->sockets.size();
+    const size_t first = handler->first_dispatch < count && !handler->ref_has_changed(handler->first_dispatch_ref)
+                            ? handler->first_dispatch : 0;
+    handler->first_dispatch = 0;
+
+    for (size_t n = 0; n < count && n_changes > 0; ++n)
+    {
+        // client pointer and dispatch will be at the same place in the socket_ptrs and dispatchers vectors
+        const size_t index = (first + n) % count;
+        const int    socket = handler->sockets[index].fd;
+        const short  revents = handler->sockets[index].revents;
+        ushort       handler_ref = handler->get_ref();
+
+        if (revents == 0)
             continue ;
-        // socket is available for reading
-        if (socket.revents & POLLIN)
+        n_changes--;
+
+        bool exhausted = false;
+        // socket is available for reading, POLLERR is dispatched as readable so that the error is read by the receive path
+        // (pending socket error, or timestamps on the error queue, see unisock::socket::recv_errqueue)
+        if (revents & (POLLIN | POLLERR))
         {
-            // client pointer will be at the same place in the socket_ptrs vector
-            unisock::socket_base* sockobj = handler->socket_ptrs[it - handler->sockets.begin()];
-            sockobj->on_readable();
+            if (handler->begin_dispatch(socket, index, false))
+            {
+                const auto&  dispatch = handler->dispatchers[index];
+#ifdef ENABLE_INSTRUMENTATION
+                const instrumentation_clock::time_point dispatch_start = instrumentation_clock::now();
+#endif
+                dispatch.readable(handler->socket_ptrs[index], dispatch.context);
+                handler->end_dispatch();
+#ifdef ENABLE_INSTRUMENTATION
+                ++counters.readable_dispatches;
+                counters.callback_time += instrumentation_clock::now() - dispatch_start;
+#endif
+            }
+            else
+                exhausted = true;
         }
         if (handler->ref_has_changed(handler_ref))
             break;
         // socket is available for writing
-        if (socket.revents & POLLOUT)
+        if (revents & POLLOUT)
         {
-            // client pointer will be at the same place in the socket_ptrs vector
-            auto* sockobj = handler->socket_ptrs[it - handler->sockets.begin()];
-            sockobj->on_writeable();
+            if (handler->begin_dispatch(socket, index, true))
+            {
+                const auto&  dispatch = handler->dispatchers[index];
+#ifdef ENABLE_INSTRUMENTATION
+                const instrumentation_clock::time_point dispatch_start = instrumentation_clock::now();
+#endif
+                dispatch.writeable(handler->socket_ptrs[index], dispatch.context);
+                handler->end_dispatch();
+#ifdef ENABLE_INSTRUMENTATION
+                ++counters.writeable_dispatches;
+                counters.callback_time += instrumentation_clock::now() - dispatch_start;
+#endif
+            }
+            else
+                exhausted = true;
         }
+        if (handler->ref_has_changed(handler_ref))
+            break;
 
-        n_changes--;
-        if (n_changes == 0 || handler->ref_has_changed(handler_ref))
+        if (exhausted)
+        {
+            // cycle budget exhausted, requeue sockets left to dispatch
+            for (size_t left = n + 1; left < count && n_changes > 0; ++left)
+            {
+                const size_t  ready_index = (first + left) % count;
+                const pollfd& ready = handler->sockets[ready_index];
+                if (ready.revents == 0)
+                    continue ;
+                if (ready.revents & (POLLIN | POLLERR))
+                    handler->requeued_readers.push_back({ ready.fd, ready_index });
+                if (ready.revents & POLLOUT)
+                    handler->requeued_writers.push_back({ ready.fd, ready_index });
+                n_changes--;
+            }
+            handler->first_dispatch = index;
+            handler->first_dispatch_ref = handler->get_ref();
             break;
+        }
     }
+
+    if (handler->has_timers())
+        handler->run_timers();
+    return (n_ready);
 }
 
 } // ******** namespace _lib
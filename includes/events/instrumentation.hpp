@@ -0,0 +1,359 @@
+/**
+ * @file instrumentation.hpp
+ * @author ROBINO Luca
+ * @brief  optional instrumentation of events::handler, enabled with ENABLE_INSTRUMENTATION
+ * @version 1.0
+ * @date 2024-02-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace events {
+
+/**
+ * @brief   log-linear histogram of durations in nanoseconds
+ *
+ * @details values are grouped by power of two, each power of two being split in SUB_BUCKETS linear buckets,
+ *          this keeps a relative error under 1 / SUB_BUCKETS with a fixed size for all values.
+ */
+class latency_histogram
+{
+    public:
+        /**
+         * @brief number of bits used for linear buckets in each power of two
+         */
+        static constexpr size_t SUB_BUCKET_BITS = 3;
+
+        /**
+         * @brief number of linear buckets in each power of two
+         */
+        static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+        /**
+         * @brief total number of buckets, enough for any 64 bits value
+         */
+        static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        /**
+         * @brief records a duration in nanoseconds
+         *
+         * @param nanoseconds   duration to record
+         */
+        void        record(uint64_t nanoseconds)
+        {
+            ++buckets[index_of(nanoseconds)];
+            ++total_count;
+            total += nanoseconds;
+            if (nanoseconds > maximum)
+                maximum = nanoseconds;
+        }
+
+        /**
+         * @brief returns the number of recorded durations
+         */
+        uint64_t    count() const
+        {
+            return (total_count);
+        }
+
+        /**
+         * @brief returns the sum of recorded durations in nanoseconds
+         */
+        uint64_t    sum() const
+        {
+            return (total);
+        }
+
+        /**
+         * @brief returns the maximum recorded duration in nanoseconds
+         */
+        uint64_t    max() const
+        {
+            return (maximum);
+        }
+
+        /**
+         * @brief   returns an upper bound of the **percentile** of recorded durations in nanoseconds
+         *
+         * @param percentile    percentile in [0, 100]
+         *
+         * @return upper bound of the bucket containing the percentile, 0 if no duration was recorded
+         */
+        uint64_t    percentile(double percentile) const
+        {
+            if (total_count == 0)
+                return (0);
+
+            uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total_count);
+            if (rank >= total_count)
+                rank = total_count - 1;
+
+            uint64_t seen = 0;
+            for (size_t index = 0; index < BUCKETS; ++index)
+            {
+                seen += buckets[index];
+                if (seen > rank)
+                    return (std::min(upper_bound_of(index), maximum));
+            }
+            return (maximum);
+        }
+
+        /**
+         * @brief returns the number of durations recorded in bucket **index**
+         */
+        uint64_t    bucket(size_t index) const
+        {
+            return (buckets[index]);
+        }
+
+        /**
+         * @brief returns the bucket index of **value**
+         */
+        static size_t   index_of(uint64_t value)
+        {
+            if (value < SUB_BUCKETS)
+                return (static_cast<size_t>(value));
+
+            const size_t msb = 63 - __builtin_clzll(value);
+            const size_t shift = msb - SUB_BUCKET_BITS;
+            return ((shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1)));
+        }
+
+        /**
+         * @brief returns the highest value recorded in bucket **index**
+         */
+        static uint64_t upper_bound_of(size_t index)
+        {
+            if (index < SUB_BUCKETS)
+                return (index);
+
+            const size_t shift = index / SUB_BUCKETS - 1;
+            const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+            return (lower + ((static_cast<uint64_t>(1) << shift) - 1));
+        }
+
+    private:
+        /**
+         * @brief number of recorded durations per bucket
+         */
+        std::array<uint64_t, BUCKETS>   buckets {};
+
+        /**
+         * @brief number of recorded durations
+         */
+        uint64_t    total_count = 0;
+
+        /**
+         * @brief sum of recorded durations
+         */
+        uint64_t    total = 0;
+
+        /**
+         * @brief maximum recorded duration
+         */
+        uint64_t    maximum = 0;
+};
+
+
+/**
+ * @brief   snapshot of events::handler instrumentation
+ *
+ * @details all fields are left empty when the library is built without ENABLE_INSTRUMENTATION
+ *
+ * @ref     events::handler::get_instrumentation
+ */
+struct instrumentation_snapshot
+{
+    /**
+     * @brief number of poll syscalls done by events::poll
+     */
+    size_t      poll_calls = 0;
+
+    /**
+     * @brief number of sockets reported ready (including requeued sockets)
+     */
+    size_t      ready_events = 0;
+
+    /**
+     * @brief number of readable dispatches
+     */
+    size_t      readable_dispatches = 0;
+
+    /**
+     * @brief number of writeable dispatches
+     */
+    size_t      writeable_dispatches = 0;
+
+    /**
+     * @brief total time spent in poll syscalls
+     */
+    std::chrono::nanoseconds    blocked_time { 0 };
+
+    /**
+     * @brief total time spent in readable and writeable dispatches
+     */
+    std::chrono::nanoseconds    callback_time { 0 };
+
+    /**
+     * @brief durations of actions executed while dispatching, keyed by action_name of the action tag
+     */
+    std::map<std::string, latency_histogram>    callbacks;
+};
+
+
+/**
+ * @addindex
+ */
+namespace _lib {
+
+/**
+ * @brief   instrumentation data of an events::handler, only used when ENABLE_INSTRUMENTATION is defined
+ */
+struct handler_instrumentation
+{
+    /**
+     * @brief clock used for all measures
+     */
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief compares action names by value, names are the same literals in most cases
+     */
+    struct name_less
+    {
+        bool    operator()(const char* a, const char* b) const
+        {
+            return (a != b && std::strcmp(a, b) < 0);
+        }
+    };
+
+    /**
+     * @brief counters of the handler, callbacks is left empty and filled from actions on snapshot()
+     */
+    instrumentation_snapshot    counters;
+
+    /**
+     * @brief durations of actions keyed by action_name
+     */
+    std::map<const char*, latency_histogram, name_less>    actions;
+
+    /**
+     * @brief returns a snapshot of the instrumentation
+     */
+    instrumentation_snapshot    snapshot() const
+    {
+        instrumentation_snapshot result = counters;
+        for (const auto& action : actions)
+            result.callbacks.emplace(action.first, action.second);
+        return (result);
+    }
+
+    /**
+     * @brief returns a reference to the instrumentation of the handler dispatching on this thread, nullptr outside of dispatch
+     */
+    static handler_instrumentation*&    current()
+    {
+        static thread_local handler_instrumentation* instrumentation = nullptr;
+        return (instrumentation);
+    }
+};
+
+
+/**
+ * @brief   sets the instrumentation of the handler dispatching on this thread for the lifetime of this object
+ */
+class instrumentation_scope
+{
+    public:
+        /**
+         * @brief sets **instrumentation** as current, previous one is restored on destruction
+         */
+        explicit instrumentation_scope(handler_instrumentation* instrumentation)
+        : previous(handler_instrumentation::current())
+        {
+            handler_instrumentation::current() = instrumentation;
+        }
+
+        instrumentation_scope(const instrumentation_scope& copy) = delete;
+
+        ~instrumentation_scope()
+        {
+            handler_instrumentation::current() = previous;
+        }
+
+    private:
+        /**
+         * @brief instrumentation of an outer dispatch, for nested events::poll
+         */
+        handler_instrumentation*    previous;
+};
+
+
+/**
+ * @brief   records the duration of an action execution in the current handler instrumentation
+ */
+class action_timer
+{
+    public:
+        /**
+         * @brief starts the timer for action named **name** if a handler is dispatching on this thread
+         * 
+         * @param name  action_name of the action tag, nullptr to disable the timer (action without callbacks)
+         */
+        explicit action_timer(const char* name)
+        : instrumentation(name != nullptr ? handler_instrumentation::current() : nullptr), name(name)
+        {
+            if (instrumentation != nullptr)
+                start = handler_instrumentation::clock::now();
+        }
+
+        action_timer(const action_timer& copy) = delete;
+
+        ~action_timer()
+        {
+            if (instrumentation == nullptr)
+                return ;
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(handler_instrumentation::clock::now() - start);
+            instrumentation->actions[name].record(static_cast<uint64_t>(elapsed.count()));
+        }
+
+    private:
+        /**
+         * @brief instrumentation to record to, nullptr if no handler is dispatching
+         */
+        handler_instrumentation*            instrumentation;
+
+        /**
+         * @brief name of the action
+         */
+        const char*                         name;
+
+        /**
+         * @brief execution start
+         */
+        handler_instrumentation::clock::time_point  start;
+};
+
+} // ******** namespace _lib
+
+} // ******** namespace events
+
+} // ******** namespace unisock
@@ -15,12 +15,14 @@
 #pragma once
 
 #include <thread>
+#include <chrono>
 #include <functional>
 #include <vector>
 #include <map>
 
 #include "socket/socket.hpp"
 #include "events/events_types.hpp"
+#include "events/instrumentation.hpp"
 
 
 /* include handler implementations */
@@ -37,6 +39,112 @@ namespace unisock {
  */
 namespace events {
 
+/**
+ * @brief   fairness budget of events::poll dispatch
+ * 
+ * @details limits the work done for a single socket and for a whole events::poll cycle,
+ *          so that one socket receiving a continuous stream cannot monopolise the handler.\n
+ *          sockets that exhaust their quota while still having data are requeued and dispatched
+ *          again next cycle without waiting for poll to report them.
+ * 
+ * @ref     events::handler::set_budget
+ */
+struct dispatch_budget
+{
+    /**
+     * @brief   maximum number of reads (or writes) a socket can do per readiness event in one cycle
+     * @details readers loop until EAGAIN within this quota, 0 disables looping (one read per event)
+     */
+    size_t  socket_events = 0;
+
+    /**
+     * @brief   maximum number of bytes a socket can read (or write) in one cycle, 0 for no limit
+     * @note    only used when socket_events is not 0
+     */
+    size_t  socket_bytes = 0;
+
+    /**
+     * @brief   maximum number of reads and writes dispatched in one events::poll cycle, 0 for no limit
+     */
+    size_t  cycle_events = 0;
+};
+
+
+/**
+ * @brief   busy polling run mode of events::poll
+ * 
+ * @details when **spin** is set, events::poll spins with zero-timeout polls for up to **spin** before blocking,
+ *          trading cpu time for wakeup latency. when **adaptive** is set, the spin duration is doubled (up to **spin**)
+ *          each time spinning caught events and halved (down to **min_spin**) each time events::poll had to block.\n
+ *          **socket_busy_poll** and **prefer_busy_poll** set SO_BUSY_POLL / SO_PREFER_BUSY_POLL on sockets added to the handler
+ *          (on systems that support them), so that the kernel also busy polls the device queue on receive.
+ * 
+ * @ref     events::handler::set_busy_poll
+ * @ref     events::busy_poll_stats
+ */
+struct busy_poll_config
+{
+    /**
+     * @brief maximum time spent spinning per events::poll before blocking, 0 disables busy polling
+     */
+    std::chrono::microseconds   spin { 0 };
+
+    /**
+     * @brief minimum spin time when **adaptive** is set
+     */
+    std::chrono::microseconds   min_spin { 0 };
+
+    /**
+     * @brief adapt spin time to the rate of events caught while spinning
+     */
+    bool                        adaptive = false;
+
+    /**
+     * @brief value in microseconds of SO_BUSY_POLL for sockets added to the handler, 0 leaves the option unset
+     * @note  raising SO_BUSY_POLL may require CAP_NET_ADMIN, setsockopt errors are ignored
+     */
+    int                         socket_busy_poll = 0;
+
+    /**
+     * @brief sets SO_PREFER_BUSY_POLL on sockets added to the handler
+     */
+    bool                        prefer_busy_poll = false;
+};
+
+
+/**
+ * @brief   statistics of busy polling run mode
+ * 
+ * @ref     events::busy_poll_config
+ */
+struct busy_poll_stats
+{
+    /**
+     * @brief number of zero-timeout polls done while spinning
+     */
+    size_t  spin_polls = 0;
+
+    /**
+     * @brief number of events::poll that caught events while spinning
+     */
+    size_t  spin_wakeups = 0;
+
+    /**
+     * @brief number of events::poll that did not catch events while spinning and blocked
+     */
+    size_t  blocking_wakeups = 0;
+
+    /**
+     * @brief returns the ratio of events::poll that caught events while spinning over all busy polled events::poll
+     */
+    double  spin_ratio() const
+    {
+        const size_t total = spin_wakeups + blocking_wakeups;
+        return (total == 0 ? 0.0 : static_cast<double>(spin_wakeups) / total);
+    }
+};
+
+
 /**
  * @brief   socket handler class, define a way to poll on group of sockets, \n 
  *          **socket_container** instances can be created on a single handler to be polled together
@@ -72,6 +180,7 @@ class handler : public _lib::handler_impl<handler_type>
         void    add_socket(int socket, unisock::socket_base* sptr)
         {
             this->handler_impl::add_socket(socket, sptr);
+            set_busy_poll_options(sptr);
             ++invalid; // changes 
         }
 
@@ -114,6 +223,388 @@ class handler : public _lib::handler_impl<handler_type>
             return (old_ref != get_ref());
         }
 
+
+        /**
+         * @brief sets the fairness budget used by events::poll on this handler
+         * 
+         * @param budget    the new budget, applied from next cycle
+         */
+        void    set_budget(const dispatch_budget& budget)
+        {
+            this->budget = budget;
+        }
+
+        /**
+         * @brief returns the fairness budget of this handler
+         */
+        const dispatch_budget&  get_budget() const
+        {
+            return (this->budget);
+        }
+
+        /**
+         * @brief   returns true if **socket** is being dispatched by events::poll and its reads/writes are accounted by consume()
+         * 
+         * @details a reader/writer called outside of its dispatch (directly by the user or by a hook of another socket)
+         *          is not bounded by the budget, consume() then always returns false
+         * 
+         * @param socket    socket file descriptor
+         */
+        bool    dispatches(int socket) const
+        {
+            return (dispatching && socket == quota.socket);
+        }
+
+        /**
+         * @brief   accounts a read or a write of **bytes** done by **socket** while it is dispatched by events::poll
+         * 
+         * @details readers and writers call this after each successful syscall to know if they can loop again.
+         *          when the socket or cycle quota is exhausted, the socket is requeued for next cycle.
+         * 
+         * @param socket    socket file descriptor that did the read/write
+         * @param bytes     number of bytes read or written
+         * 
+         * @return true if **socket** can read/write again in this cycle
+         */
+        bool    consume(int socket, size_t bytes)
+        {
+            if (!dispatching || socket != quota.socket || budget.socket_events == 0)
+                return (false);
+
+            quota.events = quota.events > 0 ? quota.events - 1 : 0;
+            quota.bytes = quota.bytes > bytes ? quota.bytes - bytes : 0;
+
+            if (quota.events == 0 || (budget.socket_bytes != 0 && quota.bytes == 0) || (budget.cycle_events != 0 && cycle_events == 0))
+            {
+                // quota exhausted, socket may still have pending data
+                (quota.write ? requeued_writers : requeued_readers).push_back({ socket, quota.index });
+                dispatching = false;
+                return (false);
+            }
+
+            if (budget.cycle_events != 0)
+                --cycle_events;
+            return (true);
+        }
+
+
+        /**
+         * @brief   sets the busy polling run mode of this handler
+         * 
+         * @note    socket options of **config** are set on sockets added to the handler after this call
+         * 
+         * @param config    busy polling configuration, spin set to 0 disables busy polling
+         */
+        void    set_busy_poll(const busy_poll_config& config)
+        {
+            this->busy_poll = config;
+            this->spin = config.spin;
+        }
+
+        /**
+         * @brief returns the busy polling configuration of this handler
+         */
+        const busy_poll_config&     get_busy_poll() const
+        {
+            return (this->busy_poll);
+        }
+
+        /**
+         * @brief returns statistics of busy polling on this handler
+         */
+        const busy_poll_stats&      get_busy_poll_stats() const
+        {
+            return (this->busy_poll_statistics);
+        }
+
+
+        /**
+         * @brief   returns a snapshot of the instrumentation of this handler
+         * 
+         * @details counts poll calls, ready sockets and dispatches, time blocked in poll and time spent in dispatches,
+         *          and a latency histogram of each action executed while dispatching, keyed by action name.\n
+         *          instrumentation is only recorded when the library is built with ENABLE_INSTRUMENTATION
+         *          (cmake option **instrumentation**), otherwise the snapshot is empty and nothing is measured.
+         */
+        instrumentation_snapshot    get_instrumentation() const
+        {
+#ifdef ENABLE_INSTRUMENTATION
+            return (this->instrumentation.snapshot());
+#else
+            return (instrumentation_snapshot {});
+#endif
+        }
+
+        /**
+         * @brief resets the instrumentation of this handler
+         */
+        void    reset_instrumentation()
+        {
+#ifdef ENABLE_INSTRUMENTATION
+            this->instrumentation = _lib::handler_instrumentation {};
+#endif
+        }
+
+        /**
+         * @brief clock of handler timers
+         */
+        using timer_clock = std::chrono::steady_clock;
+
+        /**
+         * @brief identifier of a timer, returned by add_timer(), 0 is never a timer
+         */
+        using timer_id = size_t;
+
+        /**
+         * @brief   calls **callback** from events::poll once **deadline** is reached
+         * 
+         * @details events::poll does not wait past the deadline of the earliest timer, and calls back expired timers
+         *          after dispatching sockets, on the thread polling the handler like hooks. events::poll keeps polling
+         *          a handler with pending timers even if it has no socket.
+         * 
+         * @note    meant for the few deadlines of connection attempts and retries, timers are kept sorted in a std::multimap
+         * 
+         * @param deadline  time at which **callback** is called
+         * @param callback  function to call, may add or cancel timers
+         * 
+         * @return the identifier of the timer, see cancel_timer()
+         */
+        timer_id    add_timer(timer_clock::time_point deadline, std::function<void()> callback)
+        {
+            const timer_id id = ++last_timer;
+            timers.emplace(deadline, timer { id, std::move(callback) });
+            return (id);
+        }
+
+        /**
+         * @brief cancels timer **id** if it was not called yet
+         */
+        void    cancel_timer(timer_id id)
+        {
+            for (auto it = timers.begin(); it != timers.end(); ++it)
+            {
+                if (it->second.id == id)
+                {
+                    timers.erase(it);
+                    return ;
+                }
+            }
+        }
+
+        /**
+         * @brief returns true if a timer is waiting to be called
+         */
+        bool    has_timers() const
+        {
+            return (!timers.empty());
+        }
+
+    private:
+        /**
+         * @brief sets SO_BUSY_POLL and SO_PREFER_BUSY_POLL on socket according to busy_poll configuration
+         * 
+         * @param sptr  socket added to the handler
+         */
+        void    set_busy_poll_options(unisock::socket_base* sptr)
+        {
+#ifdef SO_BUSY_POLL
+            if (busy_poll.socket_busy_poll > 0)
+                sptr->setsockopt(SOL_SOCKET, SO_BUSY_POLL, &busy_poll.socket_busy_poll, sizeof(busy_poll.socket_busy_poll));
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+            if (busy_poll.prefer_busy_poll)
+            {
+                int prefer = 1;
+                sptr->setsockopt(SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+            }
+#endif
+            (void)sptr;
+        }
+
+        /**
+         * @brief starts a new dispatch cycle, called by events::poll
+         */
+        void    begin_cycle()
+        {
+            cycle_events = budget.cycle_events;
+        }
+
+        /**
+         * @brief   starts the dispatch of **socket**, called by events::poll before dispatching a readiness event
+         * 
+         * @param socket    socket file descriptor being dispatched
+         * @param index     index of **socket** in the sockets of the handler
+         * @param write     true if socket is dispatched as writeable
+         * 
+         * @return false if the cycle budget is exhausted and socket should be requeued
+         */
+        bool    begin_dispatch(int socket, size_t index, bool write)
+        {
+            if (budget.cycle_events != 0)
+            {
+                if (cycle_events == 0)
+                {
+                    (write ? requeued_writers : requeued_readers).push_back({ socket, index });
+                    return (false);
+                }
+                --cycle_events;
+            }
+            quota.socket = socket;
+            quota.index = index;
+            quota.write = write;
+            quota.events = budget.socket_events;
+            quota.bytes = budget.socket_bytes;
+            dispatching = true;
+            return (true);
+        }
+
+        /**
+         * @brief ends the dispatch of current socket, called by events::poll
+         */
+        void    end_dispatch()
+        {
+            dispatching = false;
+        }
+
+        /**
+         * @brief   returns **timeout** shortened to the deadline of the earliest timer
+         * 
+         * @param timeout   timeout of events::poll, negative waits indefinitely
+         */
+        std::chrono::nanoseconds    timer_timeout(std::chrono::nanoseconds timeout) const
+        {
+            if (timers.empty())
+                return (timeout);
+
+            const timer_clock::time_point now = timer_clock::now();
+            const timer_clock::time_point deadline = timers.begin()->first;
+            const std::chrono::nanoseconds until = deadline > now ? std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now)
+                                                                  : std::chrono::nanoseconds::zero();
+            return (timeout.count() < 0 || until < timeout ? until : timeout);
+        }
+
+        /**
+         * @brief   calls back expired timers, called by events::poll after dispatching sockets
+         * 
+         * @return the number of timers called
+         */
+        int     run_timers()
+        {
+            int n_expired = 0;
+            const timer_clock::time_point now = timer_clock::now();
+            // one at a time, callbacks may add or cancel timers
+            while (!timers.empty() && timers.begin()->first <= now)
+            {
+                std::function<void()> callback = std::move(timers.begin()->second.callback);
+                timers.erase(timers.begin());
+                callback();
+                ++n_expired;
+            }
+            return (n_expired);
+        }
+
+        /**
+         * @brief quota of the socket currently dispatched by events::poll
+         */
+        struct
+        {
+            int     socket;
+            size_t  index;
+            bool    write;
+            size_t  events;
+            size_t  bytes;
+        }   quota {};
+
+        /**
+         * @brief fairness budget of this handler
+         */
+        dispatch_budget     budget {};
+
+        /**
+         * @brief reads and writes left in current cycle when budget.cycle_events is set
+         */
+        size_t              cycle_events = 0;
+
+        /**
+         * @brief true while events::poll dispatches a socket
+         */
+        bool                dispatching = false;
+
+        /**
+         * @brief socket requeued for next cycle, with its index in sockets when it was requeued
+         */
+        struct  requeued_socket
+        {
+            int     socket;
+            size_t  index;
+        };
+
+        /**
+         * @brief sockets that exhausted their read quota, dispatched again as readable next cycle
+         */
+        std::vector<requeued_socket>    requeued_readers;
+
+        /**
+         * @brief sockets that exhausted their write quota, dispatched again as writeable next cycle
+         */
+        std::vector<requeued_socket>    requeued_writers;
+
+        /**
+         * @brief index of the socket to dispatch first next cycle, set when the cycle budget is exhausted
+         */
+        size_t              first_dispatch = 0;
+
+        /**
+         * @brief get_ref() when first_dispatch was set, first_dispatch is ignored if sockets were added or deleted since
+         */
+        ushort              first_dispatch_ref = 0;
+
+        /**
+         * @brief true if last cycle dispatched requeued sockets without polling, next cycle polls
+         */
+        bool                skipped_poll = false;
+
+        /**
+         * @brief timer waiting to be called, see add_timer()
+         */
+        struct  timer
+        {
+            timer_id                id;
+            std::function<void()>   callback;
+        };
+
+        /**
+         * @brief pending timers sorted by deadline
+         */
+        std::multimap<timer_clock::time_point, timer>  timers;
+
+        /**
+         * @brief identifier of the last timer added
+         */
+        timer_id            last_timer = 0;
+
+        /**
+         * @brief busy polling configuration
+         */
+        busy_poll_config    busy_poll {};
+
+        /**
+         * @brief current spin time of busy polling, adapted when busy_poll.adaptive is set
+         */
+        std::chrono::microseconds   spin { 0 };
+
+        /**
+         * @brief busy polling statistics
+         */
+        busy_poll_stats     busy_poll_statistics {};
+
+#ifdef ENABLE_INSTRUMENTATION
+        /**
+         * @brief instrumentation counters and histograms, recorded by events::poll
+         */
+        _lib::handler_instrumentation   instrumentation {};
+#endif
+
     private:
         /**
          * @brief short to keep track of inner containers iterators validity,
@@ -127,7 +618,12 @@ class handler : public _lib::handler_impl<handler_type>
          * @brief friend with the correct events::poll implementation
          * @details this is so that events::poll can access its members to route back parsed events to callbacks
          */
-        friend void _lib::poll_impl<handler_type>(std::shared_ptr<handler>, int);
+        friend int _lib::poll_impl<handler_type>(std::shared_ptr<handler>, std::chrono::nanoseconds);
+
+        /**
+         * @brief friend with events::poll busy polling implementation
+         */
+        friend int _lib::busy_poll_impl<handler_type>(std::shared_ptr<handler>, std::chrono::nanoseconds);
 };
 
 
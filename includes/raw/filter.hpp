@@ -0,0 +1,385 @@
+/**
+ * @file filter.hpp
+ * @author ROBINO Luca
+ * @brief  classic BPF socket filter builder (SO_ATTACH_FILTER)
+ * @version 1.0
+ * @date 2024-02-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+# include <arpa/inet.h>
+# include <linux/filter.h>
+# include <netinet/in.h>
+#endif
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace raw {
+
+#if defined(__linux__)
+
+/**
+ * @brief   builds a classic BPF program accepting IP packets that match all of its predicates
+ *
+ * @details fields are loaded relative to the network header (SKF_NET_OFF), so the same program can be attached
+ *          to AF_PACKET sockets, AF_INET / AF_INET6 raw sockets and udp sockets.\n
+ *          packets of another IP version are rejected, port and payload predicates also reject IPv4 fragments
+ *          other than the first one. for IPv6, transport headers are expected right after the fixed header
+ *          (no extension headers).
+ *
+ * @code
+ *  raw::filter_builder filter { AF_INET };
+ *  filter.protocol(IPPROTO_UDP).destination_port(8000, 8100).source("10.0.0.0", 8).payload_prefix("PING");
+ *  socket.attach_filter(filter);
+ * @endcode
+ *
+ * @ref raw::socket_impl::attach_filter
+ */
+class   filter_builder
+{
+    public:
+        /**
+         * @brief   creates a filter for packets of IP **family**
+         *
+         * @param family    AF_INET or AF_INET6
+         */
+        explicit filter_builder(int family = AF_INET)
+        : family(family)
+        {
+            if (family != AF_INET && family != AF_INET6)
+                throw std::logic_error("filter_builder: family must be AF_INET or AF_INET6");
+
+            // A = IP version
+            this->emit(BPF_LD | BPF_B | BPF_ABS, NET_OFFSET);
+            this->emit(BPF_ALU | BPF_RSH | BPF_K, 4);
+            this->reject_unless(BPF_JEQ, family == AF_INET ? 4 : 6);
+        }
+
+        /**
+         * @brief accepts packets of transport **protocol** (IPPROTO_UDP, IPPROTO_TCP, ...)
+         */
+        filter_builder&     protocol(uint8_t protocol)
+        {
+            this->emit(BPF_LD | BPF_B | BPF_ABS, NET_OFFSET + (family == AF_INET ? 9 : 6));
+            this->reject_unless(BPF_JEQ, protocol);
+            return (*this);
+        }
+
+        /**
+         * @brief   accepts packets with a source port between **first** and **last** included
+         *
+         * @note    should be combined with protocol(), ports are read at the offset of udp and tcp ports
+         */
+        filter_builder&     source_port(uint16_t first, uint16_t last)
+        {
+            this->port_range(0, first, last);
+            return (*this);
+        }
+
+        /**
+         * @brief accepts packets with source port **port**
+         */
+        filter_builder&     source_port(uint16_t port)
+        {
+            return (this->source_port(port, port));
+        }
+
+        /**
+         * @brief   accepts packets with a destination port between **first** and **last** included
+         *
+         * @note    should be combined with protocol(), ports are read at the offset of udp and tcp ports
+         */
+        filter_builder&     destination_port(uint16_t first, uint16_t last)
+        {
+            this->port_range(2, first, last);
+            return (*this);
+        }
+
+        /**
+         * @brief accepts packets with destination port **port**
+         */
+        filter_builder&     destination_port(uint16_t port)
+        {
+            return (this->destination_port(port, port));
+        }
+
+        /**
+         * @brief   accepts packets with a source address in **address** with a prefix of **prefix_len** bits
+         *
+         * @param address       numeric address of the family of the filter
+         * @param prefix_len    number of leading bits to match, the full address if greater than the address size
+         *
+         * @throw std::logic_error if **address** is not a numeric address of the family of the filter
+         */
+        filter_builder&     source(const std::string& address, unsigned prefix_len)
+        {
+            this->address_prefix(family == AF_INET ? 12 : 8, address, prefix_len);
+            return (*this);
+        }
+
+        /**
+         * @brief   accepts packets with a destination address in **address** with a prefix of **prefix_len** bits
+         *
+         * @param address       numeric address of the family of the filter
+         * @param prefix_len    number of leading bits to match, the full address if greater than the address size
+         *
+         * @throw std::logic_error if **address** is not a numeric address of the family of the filter
+         */
+        filter_builder&     destination(const std::string& address, unsigned prefix_len)
+        {
+            this->address_prefix(family == AF_INET ? 16 : 24, address, prefix_len);
+            return (*this);
+        }
+
+        /**
+         * @brief   accepts udp datagrams whose payload starts with the **prefix_len** bytes of **prefix**
+         *
+         * @note    the payload is read after an 8 bytes udp header, should be combined with protocol(IPPROTO_UDP)
+         */
+        filter_builder&     payload_prefix(const char* prefix, size_t prefix_len)
+        {
+            this->load_transport_offset();
+            uint32_t offset = UDP_HEADER_SIZE;
+            for (size_t index = 0; index < prefix_len; )
+            {
+                const size_t    remaining = prefix_len - index;
+                const size_t    size = remaining >= 4 ? 4 : (remaining >= 2 ? 2 : 1);
+                uint32_t        expected = 0;
+                for (size_t byte = 0; byte < size; ++byte)
+                    expected = (expected << 8) | static_cast<uint8_t>(prefix[index + byte]);
+
+                this->emit(BPF_LD | (size == 4 ? BPF_W : (size == 2 ? BPF_H : BPF_B)) | this->transport_mode(),
+                            this->transport_offset(offset));
+                this->reject_unless(BPF_JEQ, expected);
+                index += size;
+                offset += static_cast<uint32_t>(size);
+            }
+            return (*this);
+        }
+
+        /**
+         * @brief accepts udp datagrams whose payload starts with **prefix**
+         */
+        filter_builder&     payload_prefix(const std::string& prefix)
+        {
+            return (this->payload_prefix(prefix.data(), prefix.size()));
+        }
+
+        /**
+         * @brief returns the number of instructions of the program
+         */
+        size_t              size() const
+        {
+            return (code.size() + 2);
+        }
+
+        /**
+         * @brief   returns the instructions of the program, ending with the accept and reject returns
+         *
+         * @throw std::logic_error if the program is too long for the 8 bits jumps of classic BPF (about 250 instructions)
+         */
+        std::vector<sock_filter>    build() const
+        {
+            std::vector<sock_filter>    program = code;
+            const size_t                accept = program.size();
+            const size_t                reject = accept + 1;
+
+            if (reject > UINT8_MAX)
+                throw std::logic_error("filter_builder: program too long");
+            // jumps to reject were emitted with a placeholder, resolved now that the end of the program is known
+            for (const reject_jump& jump : reject_jumps)
+            {
+                const uint8_t offset = static_cast<uint8_t>(reject - jump.index - 1);
+                if (jump.on_true)
+                    program[jump.index].jt = offset;
+                else
+                    program[jump.index].jf = offset;
+            }
+
+            program.push_back(BPF_STMT(BPF_RET | BPF_K, ACCEPT));
+            program.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+            return (program);
+        }
+
+    private:
+        /**
+         * @brief offset of the network header for absolute and indirect loads
+         */
+        static constexpr uint32_t   NET_OFFSET = static_cast<uint32_t>(SKF_NET_OFF);
+
+        /**
+         * @brief size of a udp header
+         */
+        static constexpr uint32_t   UDP_HEADER_SIZE = 8;
+
+        /**
+         * @brief size of the fixed IPv6 header
+         */
+        static constexpr uint32_t   IPV6_HEADER_SIZE = 40;
+
+        /**
+         * @brief return value accepting the whole packet
+         */
+        static constexpr uint32_t   ACCEPT = 0xFFFFFFFF;
+
+        /**
+         * @brief appends instruction **opcode** with constant **k**
+         */
+        void        emit(uint16_t opcode, uint32_t k)
+        {
+            code.push_back(BPF_STMT(opcode, k));
+        }
+
+        /**
+         * @brief   appends a conditional jump on A **condition** **k**, falling through if true and rejecting the packet otherwise
+         *
+         * @param condition BPF_JEQ, BPF_JGE, BPF_JGT or BPF_JSET
+         */
+        void        reject_unless(uint16_t condition, uint32_t k)
+        {
+            reject_jumps.push_back(reject_jump { code.size(), false });
+            code.push_back(BPF_JUMP(BPF_JMP | condition | BPF_K, k, 0, 0));
+        }
+
+        /**
+         * @brief   appends a conditional jump on A **condition** **k**, rejecting the packet if true and falling through otherwise
+         *
+         * @param condition BPF_JEQ, BPF_JGE, BPF_JGT or BPF_JSET
+         */
+        void        reject_if(uint16_t condition, uint32_t k)
+        {
+            reject_jumps.push_back(reject_jump { code.size(), true });
+            code.push_back(BPF_JUMP(BPF_JMP | condition | BPF_K, k, 0, 0));
+        }
+
+        /**
+         * @brief   sets X to the offset of the transport header from the network header, rejects non first IPv4 fragments
+         *
+         * @details IPv6 transport headers are at a fixed offset, loads use absolute offsets instead of X
+         */
+        void        load_transport_offset()
+        {
+            if (family != AF_INET)
+                return ;
+            // A = fragment offset, only the first fragment holds the transport header
+            this->emit(BPF_LD | BPF_H | BPF_ABS, NET_OFFSET + 6);
+            this->reject_if(BPF_JSET, 0x1FFF);
+            // X = 4 * IHL
+            this->emit(BPF_LDX | BPF_B | BPF_MSH, NET_OFFSET);
+        }
+
+        /**
+         * @brief returns the addressing mode of loads relative to the transport header
+         */
+        uint16_t    transport_mode() const
+        {
+            return (family == AF_INET ? BPF_IND : BPF_ABS);
+        }
+
+        /**
+         * @brief returns the constant of a load at **offset** from the transport header
+         */
+        uint32_t    transport_offset(uint32_t offset) const
+        {
+            return (NET_OFFSET + (family == AF_INET ? 0 : IPV6_HEADER_SIZE) + offset);
+        }
+
+        /**
+         * @brief appends a check of the port at **offset** of the transport header against [first, last]
+         */
+        void        port_range(uint32_t offset, uint16_t first, uint16_t last)
+        {
+            this->load_transport_offset();
+            this->emit(BPF_LD | BPF_H | this->transport_mode(), this->transport_offset(offset));
+            if (first == last)
+                this->reject_unless(BPF_JEQ, first);
+            else
+            {
+                this->reject_unless(BPF_JGE, first);
+                this->reject_if(BPF_JGT, last);
+            }
+        }
+
+        /**
+         * @brief appends a check of the address at **offset** of the network header against **address** with a prefix of **prefix_len** bits
+         */
+        void        address_prefix(uint32_t offset, const std::string& address, unsigned prefix_len)
+        {
+            unsigned char   bytes[sizeof(in6_addr)];
+            const size_t    address_size = (family == AF_INET ? sizeof(in_addr) : sizeof(in6_addr));
+
+            if (1 != ::inet_pton(family, address.c_str(), bytes))
+                throw std::logic_error("filter_builder: invalid address " + address);
+            if (prefix_len > address_size * 8)
+                prefix_len = static_cast<unsigned>(address_size * 8);
+
+            // compares the prefix one 32 bits word at a time
+            for (uint32_t word = 0; prefix_len > 0; ++word, prefix_len -= std::min(prefix_len, 32u))
+            {
+                uint32_t value;
+                std::memcpy(&value, bytes + word * 4, sizeof(value));
+                value = ntohl(value);
+
+                const uint32_t mask = prefix_len >= 32 ? 0xFFFFFFFF : ~(0xFFFFFFFFu >> prefix_len);
+                this->emit(BPF_LD | BPF_W | BPF_ABS, NET_OFFSET + offset + word * 4);
+                if (mask != 0xFFFFFFFF)
+                    this->emit(BPF_ALU | BPF_AND | BPF_K, mask);
+                this->reject_unless(BPF_JEQ, value & mask);
+            }
+        }
+
+        /**
+         * @brief IP family of the filter
+         */
+        int                         family;
+
+        /**
+         * @brief instructions of the predicates, without the final returns
+         */
+        std::vector<sock_filter>    code;
+
+        /**
+         * @brief conditional jump to the reject return, resolved by build()
+         */
+        struct  reject_jump
+        {
+            /**
+             * @brief index of the jump in code
+             */
+            size_t  index;
+
+            /**
+             * @brief true if the packet is rejected when the condition is true, false when it is false
+             */
+            bool    on_true;
+        };
+
+        /**
+         * @brief jumps to the reject return, in order of emission
+         */
+        std::vector<reject_jump>    reject_jumps;
+};
+
+#endif
+
+} // ******** namespace raw
+
+} // ******** namespace unisock
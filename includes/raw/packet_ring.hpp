@@ -0,0 +1,314 @@
+/**
+ * @file packet_ring.hpp
+ * @author ROBINO Luca
+ * @brief  memory mapped receive ring (PACKET_MMAP, TPACKET_V3) for AF_PACKET raw sockets
+ * @version 1.0
+ * @date 2024-02-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+# include <arpa/inet.h>
+# include <linux/if_packet.h>
+# include <sys/mman.h>
+#endif
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace raw {
+
+/**
+ * @brief   zero-copy view on a frame of raw::packet_ring
+ *
+ * @details data points into the ring shared with the kernel, it is only valid until the end of the PACKET hook
+ */
+struct  packet_frame
+{
+    /**
+     * @brief frame bytes, starting at the link layer header
+     */
+    const char*     data = nullptr;
+
+    /**
+     * @brief number of bytes captured in data
+     */
+    size_t          length = 0;
+
+    /**
+     * @brief size of the packet on the wire, larger than length if the packet was truncated to the frame size
+     */
+    size_t          original_length = 0;
+
+    /**
+     * @brief time the packet was received by the kernel
+     */
+    timespec        timestamp {};
+
+    /**
+     * @brief index of the interface the packet was captured on
+     */
+    int             interface = 0;
+
+    /**
+     * @brief link layer protocol of the packet (ETH_P_*), in host byte order
+     */
+    uint16_t        protocol = 0;
+
+    /**
+     * @brief type of the packet (PACKET_HOST, PACKET_OUTGOING, ...)
+     */
+    uint8_t         packet_type = 0;
+
+    /**
+     * @brief receive hash of the packet
+     */
+    uint32_t        hash = 0;
+};
+
+
+/**
+ * @brief   statistics of a raw::packet_ring, see raw::socket_impl::get_ring_stats
+ */
+struct  packet_ring_stats
+{
+    /**
+     * @brief number of packets received by the socket
+     */
+    size_t          packets = 0;
+
+    /**
+     * @brief number of packets dropped because the ring was full
+     */
+    size_t          drops = 0;
+
+    /**
+     * @brief number of times the ring was full
+     */
+    size_t          freezes = 0;
+};
+
+
+#if defined(__linux__)
+
+/**
+ * @brief   receive ring of an AF_PACKET socket, mapped in memory and shared with the kernel (TPACKET_V3)
+ *
+ * @details the kernel writes packets into blocks of the ring and hands each block to user space when it is full or
+ *          when its retire timeout expires, frames of a block are then read in place without any syscall and the block
+ *          is given back to the kernel once all its frames were read.
+ *
+ * @ref raw::socket_impl::set_packet_ring
+ */
+class   packet_ring
+{
+    public:
+        /**
+         * @brief default size of a block, a multiple of the page size
+         */
+        static constexpr size_t     DEFAULT_BLOCK_SIZE = 1 << 20;
+
+        /**
+         * @brief default number of blocks
+         */
+        static constexpr size_t     DEFAULT_BLOCK_COUNT = 16;
+
+        /**
+         * @brief default maximum size of a frame, larger packets are truncated
+         */
+        static constexpr size_t     DEFAULT_FRAME_SIZE = 2048;
+
+        /**
+         * @brief default time in milliseconds after which a block that is not full is handed to user space
+         */
+        static constexpr unsigned   DEFAULT_RETIRE_TIMEOUT = 10;
+
+        /**
+         * @brief   describes a ring of **block_count** blocks of **block_size** bytes, the ring is created by map()
+         *
+         * @param block_size        size of a block, a multiple of the page size
+         * @param block_count       number of blocks
+         * @param frame_size        maximum size of a frame, a multiple of TPACKET_ALIGNMENT
+         * @param retire_timeout    time in milliseconds after which a block that is not full is handed to user space
+         */
+        explicit packet_ring(size_t block_size = DEFAULT_BLOCK_SIZE,
+                                size_t block_count = DEFAULT_BLOCK_COUNT,
+                                size_t frame_size = DEFAULT_FRAME_SIZE,
+                                unsigned retire_timeout = DEFAULT_RETIRE_TIMEOUT)
+        : block_size(block_size), block_count(block_count), frame_size(frame_size), retire_timeout(retire_timeout)
+        {}
+
+        packet_ring(const packet_ring& copy) = delete;
+
+        /**
+         * @brief unmaps the ring
+         */
+        ~packet_ring()
+        {
+            if (ring != nullptr)
+                ::munmap(ring, block_size * block_count);
+        }
+
+        /**
+         * @brief   creates the ring on AF_PACKET **socket** and maps it in memory
+         *
+         * @return true if ring was mapped, false on error with errno set
+         */
+        bool        map(int socket)
+        {
+            int version = TPACKET_V3;
+            if (0 > ::setsockopt(socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)))
+                return (false);
+
+            tpacket_req3 request {};
+            request.tp_block_size = static_cast<unsigned>(block_size);
+            request.tp_block_nr = static_cast<unsigned>(block_count);
+            request.tp_frame_size = static_cast<unsigned>(frame_size);
+            request.tp_frame_nr = static_cast<unsigned>(block_size / frame_size * block_count);
+            request.tp_retire_blk_tov = retire_timeout;
+            request.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+            if (0 > ::setsockopt(socket, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)))
+                return (false);
+
+            void* mapped = ::mmap(nullptr, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED, socket, 0);
+            if (mapped == MAP_FAILED)
+                return (false);
+            ring = static_cast<char*>(mapped);
+            current = 0;
+            next_frame = 0;
+            return (true);
+        }
+
+        /**
+         * @brief returns true if the next block was handed to user space by the kernel
+         */
+        bool        ready() const
+        {
+            return (ring != nullptr && (block(current)->hdr.bh1.block_status & TP_STATUS_USER));
+        }
+
+        /**
+         * @brief   reads the frames of the next block if it is ready, then gives the block back to the kernel
+         *
+         * @details the position of the next frame is recorded before **function** is called, so that a read stopped
+         *          by **function** resumes after the last delivered frame on the next call. a block whose last frame
+         *          was delivered by a stopped read is given back to the kernel by the next call.
+         *
+         * @param function  called with each packet_frame of the block, returns false to stop reading
+         *                  (the ring is not used anymore until the next call, it may have been deleted by the function)
+         *
+         * @return true if a block was read, false if no block was ready
+         */
+        template<typename _Function>
+        bool        consume_block(_Function function)
+        {
+            if (!this->ready())
+                return (false);
+
+            tpacket_block_desc* descriptor = block(current);
+            // reads frames only after the kernel released the block
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            const uint32_t  n_frames = descriptor->hdr.bh1.num_pkts;
+            const char*     position = reinterpret_cast<const char*>(descriptor)
+                                        + (next_frame == 0 ? descriptor->hdr.bh1.offset_to_first_pkt : next_offset);
+            for (uint32_t i = next_frame; i < n_frames; ++i)
+            {
+                const tpacket3_hdr* header = reinterpret_cast<const tpacket3_hdr*>(position);
+                const sockaddr_ll*  link = reinterpret_cast<const sockaddr_ll*>(position + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+
+                packet_frame frame;
+                frame.data = position + header->tp_mac;
+                frame.length = header->tp_snaplen;
+                frame.original_length = header->tp_len;
+                frame.timestamp.tv_sec = header->tp_sec;
+                frame.timestamp.tv_nsec = header->tp_nsec;
+                frame.interface = link->sll_ifindex;
+                frame.protocol = ntohs(link->sll_protocol);
+                frame.packet_type = link->sll_pkttype;
+                frame.hash = header->hv1.tp_rxhash;
+
+                position += header->tp_next_offset;
+                next_frame = i + 1;
+                next_offset = static_cast<size_t>(position - reinterpret_cast<const char*>(descriptor));
+                if (!function(frame))
+                    return (true);
+            }
+
+            // frames are read before the block is given back to the kernel
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            descriptor->hdr.bh1.block_status = TP_STATUS_KERNEL;
+            current = (current + 1) % block_count;
+            next_frame = 0;
+            return (true);
+        }
+
+    private:
+        /**
+         * @brief returns the descriptor of block at **index**
+         */
+        tpacket_block_desc* block(size_t index) const
+        {
+            return (reinterpret_cast<tpacket_block_desc*>(ring + index * block_size));
+        }
+
+        /**
+         * @brief size of a block
+         */
+        size_t      block_size;
+
+        /**
+         * @brief number of blocks
+         */
+        size_t      block_count;
+
+        /**
+         * @brief maximum size of a frame
+         */
+        size_t      frame_size;
+
+        /**
+         * @brief retire timeout of blocks in milliseconds
+         */
+        unsigned    retire_timeout;
+
+        /**
+         * @brief mapped ring, nullptr before map()
+         */
+        char*       ring = nullptr;
+
+        /**
+         * @brief index of the next block to read
+         */
+        size_t      current = 0;
+
+        /**
+         * @brief index in the current block of the next frame to read, 0 if the block was not read yet
+         */
+        uint32_t    next_frame = 0;
+
+        /**
+         * @brief offset in the current block of the next frame to read, valid if next_frame is not 0
+         */
+        size_t      next_offset = 0;
+};
+
+#endif
+
+} // ******** namespace raw
+
+} // ******** namespace unisock
@@ -0,0 +1,536 @@
+/**
+ * @file pcapng.hpp
+ * @author ROBINO Luca
+ * @brief  buffered pcapng writer for packets captured by raw and udp sockets
+ * @version 1.0
+ * @date 2024-02-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "socket/socket_address.hpp"
+#include "socket/timestamping.hpp"
+#include "raw/packet_ring.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace raw {
+
+/**
+ * @brief   writes captured packets to a pcapng file, readable by Wireshark and tcpdump
+ *
+ * @details blocks are appended to a memory buffer and written to the file with a single write() each time the buffer
+ *          is full, so that capturing from an event loop costs a memcpy per packet and a syscall per buffer.\n
+ *          the file is opened in append mode, each writer starts a new section (section header and interfaces),
+ *          so several captures can be appended to the same file.\n
+ *          packets are timestamped with their kernel timestamp when there is one (see unisock::socket::set_timestamping),
+ *          otherwise with the time they are written.
+ *
+ * @code
+ *  raw::pcapng_writer capture;
+ *  capture.open("capture.pcapng");
+ *  socket.on<raw::actions::PACKET>([&capture](const raw::packet_frame& frame){ capture.write(frame); });
+ * @endcode
+ */
+class   pcapng_writer
+{
+    public:
+        /**
+         * @brief default size of the write buffer
+         */
+        static constexpr size_t     DEFAULT_BUFFER_SIZE = 1 << 20;
+
+        /**
+         * @brief link type of packets starting with an ethernet header (raw::packet_frame of AF_PACKET SOCK_RAW sockets)
+         */
+        static constexpr uint16_t   LINKTYPE_ETHERNET = 1;
+
+        /**
+         * @brief link type of packets starting with an IPv4 or IPv6 header
+         */
+        static constexpr uint16_t   LINKTYPE_RAW = 101;
+
+        /**
+         * @brief   creates a closed writer
+         *
+         * @param buffer_size   size of the write buffer, blocks are written to the file when it is full,
+         *                      packets larger than the buffer are not written
+         */
+        explicit pcapng_writer(size_t buffer_size = DEFAULT_BUFFER_SIZE)
+        : buffer(buffer_size)
+        {}
+
+        pcapng_writer(const pcapng_writer& copy) = delete;
+
+        /**
+         * @brief flushes buffered blocks and closes the file
+         */
+        ~pcapng_writer()
+        {
+            this->close();
+        }
+
+        /**
+         * @brief   opens **path** in append mode and writes a section header
+         *
+         * @return true if file was opened, false on error with errno set
+         */
+        bool        open(const std::string& path)
+        {
+            this->close();
+            file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (file < 0)
+                return (false);
+
+            interfaces.clear();
+            n_packets = 0;
+            this->write_section_header();
+            return (true);
+        }
+
+        /**
+         * @brief returns true if a file is opened
+         */
+        bool        is_open() const
+        {
+            return (file >= 0);
+        }
+
+        /**
+         * @brief   writes buffered blocks to the file
+         *
+         * @return true if blocks were written, false on error with errno set (buffered blocks are dropped)
+         */
+        bool        flush()
+        {
+            const bool written = this->write_file(buffer.data(), used);
+            used = 0;
+            return (written);
+        }
+
+        /**
+         * @brief flushes buffered blocks and closes the file
+         *
+         * @return true if blocks were written, false on error with errno set
+         */
+        bool        close()
+        {
+            if (file < 0)
+                return (true);
+            const bool written = this->flush();
+            ::close(file);
+            file = -1;
+            return (written);
+        }
+
+        /**
+         * @brief returns the number of packets written since open()
+         */
+        size_t      packets() const
+        {
+            return (n_packets);
+        }
+
+        /**
+         * @brief   writes a frame read from a packet ring (ethernet link type)
+         *
+         * @return true if frame was written, false on error with errno set
+         */
+        bool        write(const packet_frame& frame)
+        {
+            return (this->write_packet(this->interface(LINKTYPE_ETHERNET),
+                                        frame.data,
+                                        frame.length,
+                                        frame.original_length,
+                                        frame.timestamp));
+        }
+
+        /**
+         * @brief   writes an IP packet received by an AF_INET / AF_INET6 raw socket, header included
+         *
+         * @param packet        packet starting with its IP header
+         * @param packet_len    size of **packet**
+         * @param timestamps    receive timestamps of the packet, the time of the call is used if empty
+         *
+         * @return true if packet was written, false on error with errno set
+         */
+        bool        write_ip(const char* packet, size_t packet_len, const packet_timestamps& timestamps = packet_timestamps {})
+        {
+            return (this->write_packet(this->interface(LINKTYPE_RAW), packet, packet_len, packet_len, this->timestamp(timestamps)));
+        }
+
+        /**
+         * @brief   writes a udp datagram received by a udp socket, IP and udp headers are rebuilt from the addresses
+         *
+         * @param source        address the datagram was received from
+         * @param destination   address the datagram was sent to, usually the address of the receiving socket
+         * @param payload       payload of the datagram
+         * @param payload_len   size of **payload**
+         * @param timestamps    receive timestamps of the datagram, the time of the call is used if empty
+         *
+         * @return true if datagram was written, false on error with errno set
+         */
+        bool        write_udp(const socket_address& source,
+                                const socket_address& destination,
+                                const char* payload,
+                                size_t payload_len,
+                                const packet_timestamps& timestamps = packet_timestamps {})
+        {
+            char            headers[IPV6_HEADER_SIZE + UDP_HEADER_SIZE];
+            const size_t    headers_len = this->udp_headers(headers, source, destination, payload_len);
+
+            return (this->write_packet(this->interface(LINKTYPE_RAW),
+                                        headers, headers_len,
+                                        payload, payload_len,
+                                        this->timestamp(timestamps)));
+        }
+
+        /**
+         * @brief   writes a packet of **captured_len** bytes on an interface of **link_type**
+         *
+         * @param link_type     link type of the packet (LINKTYPE_*)
+         * @param data          packet bytes, starting with the header of **link_type**
+         * @param captured_len  size of **data**
+         * @param original_len  size of the packet on the wire
+         * @param time          time the packet was received
+         *
+         * @return true if packet was written, false on error with errno set
+         */
+        bool        write(uint16_t link_type, const char* data, size_t captured_len, size_t original_len, const timespec& time)
+        {
+            return (this->write_packet(this->interface(link_type), data, captured_len, original_len, time));
+        }
+
+        /**
+         * @brief returns the kernel timestamp in **timestamps**, or the current time if there is none
+         */
+        static timespec timestamp(const packet_timestamps& timestamps)
+        {
+            if (timestamps.has_software)
+                return (timestamps.software);
+            if (timestamps.has_hardware)
+                return (timestamps.hardware);
+            timespec now;
+            ::clock_gettime(CLOCK_REALTIME, &now);
+            return (now);
+        }
+
+    private:
+        /**
+         * @brief size of the IPv4 header written by write_udp
+         */
+        static constexpr size_t     IPV4_HEADER_SIZE = 20;
+
+        /**
+         * @brief size of the IPv6 header written by write_udp
+         */
+        static constexpr size_t     IPV6_HEADER_SIZE = 40;
+
+        /**
+         * @brief size of a udp header
+         */
+        static constexpr size_t     UDP_HEADER_SIZE = 8;
+
+        /**
+         * @brief size of the fixed fields of an enhanced packet block, with its trailing length
+         */
+        static constexpr size_t     PACKET_BLOCK_SIZE = 32;
+
+        /**
+         * @brief id returned by interface() when the description block could not be written
+         */
+        static constexpr uint32_t   INVALID_INTERFACE = UINT32_MAX;
+
+        /**
+         * @brief returns **size** rounded up to a multiple of 4, blocks and options are 32 bits aligned
+         */
+        static size_t   padded(size_t size)
+        {
+            return ((size + 3) & ~static_cast<size_t>(3));
+        }
+
+        /**
+         * @brief appends **size** bytes of **data** to the block being built at **block**
+         */
+        static char*    put(char* block, const void* data, size_t size)
+        {
+            std::memcpy(block, data, size);
+            return (block + size);
+        }
+
+        /**
+         * @brief appends 32 bits **value** to the block being built at **block**
+         */
+        static char*    put32(char* block, uint32_t value)
+        {
+            return (put(block, &value, sizeof(value)));
+        }
+
+        /**
+         * @brief appends 16 bits **value** to the block being built at **block**
+         */
+        static char*    put16(char* block, uint16_t value)
+        {
+            return (put(block, &value, sizeof(value)));
+        }
+
+        /**
+         * @brief   returns a pointer to **size** bytes at the end of the buffer, flushing it first if it is full
+         *
+         * @return pointer in the buffer, nullptr on write error, if the file is closed or if **size** is larger than the buffer
+         */
+        char*       reserve(size_t size)
+        {
+            if (file < 0)
+            {
+                errno = EBADF;
+                return (nullptr);
+            }
+            if (used + size > buffer.size() && !this->flush())
+                return (nullptr);
+            if (size > buffer.size())
+            {
+                errno = EMSGSIZE;
+                return (nullptr);
+            }
+            char* block = buffer.data() + used;
+            used += size;
+            return (block);
+        }
+
+        /**
+         * @brief writes **size** bytes of **data** to the file, retrying partial writes
+         */
+        bool        write_file(const char* data, size_t size)
+        {
+            while (size > 0)
+            {
+                ssize_t n_bytes = ::write(file, data, size);
+                if (n_bytes < 0)
+                {
+                    if (errno == EINTR)
+                        continue ;
+                    return (false);
+                }
+                data += n_bytes;
+                size -= static_cast<size_t>(n_bytes);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief writes the section header block starting the section of this writer
+         */
+        void        write_section_header()
+        {
+            const uint32_t  length = 28;
+            const int64_t   section_length = -1;
+            char*           block = this->reserve(length);
+            if (block == nullptr)
+                return ;
+
+            block = put32(block, 0x0A0D0D0A);
+            block = put32(block, length);
+            block = put32(block, 0x1A2B3C4D);
+            block = put16(block, 1);
+            block = put16(block, 0);
+            block = put(block, &section_length, sizeof(section_length));
+            put32(block, length);
+        }
+
+        /**
+         * @brief   returns the id of the interface of **link_type**, writes its description block the first time
+         *
+         * @details interfaces are described with nanosecond timestamps (if_tsresol 9)
+         *
+         * @return the interface id, INVALID_INTERFACE with errno set if the description block could not be written
+         */
+        uint32_t    interface(uint16_t link_type)
+        {
+            for (size_t index = 0; index < interfaces.size(); ++index)
+            {
+                if (interfaces[index] == link_type)
+                    return (static_cast<uint32_t>(index));
+            }
+
+            const uint32_t  length = 32;
+            const uint8_t   resolution[4] = { 9, 0, 0, 0 };
+            char*           block = this->reserve(length);
+            // the packet must not be written either, it would refer to an undescribed interface
+            if (block == nullptr)
+                return (INVALID_INTERFACE);
+
+            block = put32(block, 0x00000001);
+            block = put32(block, length);
+            block = put16(block, link_type);
+            block = put16(block, 0);
+            // no snap length
+            block = put32(block, 0);
+            // if_tsresol: 10^-9 seconds, padded to 32 bits
+            block = put16(block, 9);
+            block = put16(block, 1);
+            block = put(block, resolution, sizeof(resolution));
+            // opt_endofopt
+            block = put32(block, 0);
+            put32(block, length);
+
+            interfaces.push_back(link_type);
+            return (static_cast<uint32_t>(interfaces.size() - 1));
+        }
+
+        /**
+         * @brief writes an enhanced packet block of **data** on **interface**
+         */
+        bool        write_packet(uint32_t interface, const char* data, size_t captured_len, size_t original_len, const timespec& time)
+        {
+            return (this->write_packet(interface, data, captured_len, nullptr, 0, time, original_len));
+        }
+
+        /**
+         * @brief   writes an enhanced packet block made of **header** followed by **data** on **interface**
+         *
+         * @param original_len  size of the packet on the wire, header_len + data_len if 0
+         */
+        bool        write_packet(uint32_t interface,
+                                    const char* header, size_t header_len,
+                                    const char* data, size_t data_len,
+                                    const timespec& time,
+                                    size_t original_len = 0)
+        {
+            // interface() failed, errno is already set
+            if (interface == INVALID_INTERFACE)
+                return (false);
+
+            const size_t    captured_len = header_len + data_len;
+            const uint32_t  length = static_cast<uint32_t>(PACKET_BLOCK_SIZE + padded(captured_len));
+            const uint64_t  nanoseconds = static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+            char*           block = this->reserve(length);
+            if (block == nullptr)
+                return (false);
+
+            block = put32(block, 0x00000006);
+            block = put32(block, length);
+            block = put32(block, interface);
+            block = put32(block, static_cast<uint32_t>(nanoseconds >> 32));
+            block = put32(block, static_cast<uint32_t>(nanoseconds));
+            block = put32(block, static_cast<uint32_t>(captured_len));
+            block = put32(block, static_cast<uint32_t>(original_len != 0 ? original_len : captured_len));
+            block = put(block, header, header_len);
+            if (data_len > 0)
+                block = put(block, data, data_len);
+            std::memset(block, 0, padded(captured_len) - captured_len);
+            block += padded(captured_len) - captured_len;
+            put32(block, length);
+
+            ++n_packets;
+            return (true);
+        }
+
+        /**
+         * @brief   writes IP and udp headers of a datagram from **source** to **destination** in **headers**
+         *
+         * @details the IP version is the one of **source**, **destination** is written as the unspecified address if
+         *          it is of another family. the udp checksum is left to 0.
+         *
+         * @return size of the headers
+         */
+        static size_t   udp_headers(char* headers, const socket_address& source, const socket_address& destination, size_t payload_len)
+        {
+            const bool      ipv6 = source.family() == AF_INET6;
+            const size_t    ip_len = ipv6 ? IPV6_HEADER_SIZE : IPV4_HEADER_SIZE;
+            const bool      same_family = destination.family() == source.family();
+            unsigned char*  ip = reinterpret_cast<unsigned char*>(headers);
+
+            std::memset(headers, 0, ip_len + UDP_HEADER_SIZE);
+            if (ipv6)
+            {
+                const uint16_t payload_length = htons(static_cast<uint16_t>(UDP_HEADER_SIZE + payload_len));
+                ip[0] = 0x60;
+                std::memcpy(ip + 4, &payload_length, sizeof(payload_length));
+                ip[6] = IPPROTO_UDP;
+                ip[7] = 64;
+                std::memcpy(ip + 8, &source.to<sockaddr_in6>()->sin6_addr, sizeof(in6_addr));
+                if (same_family)
+                    std::memcpy(ip + 24, &destination.to<sockaddr_in6>()->sin6_addr, sizeof(in6_addr));
+            }
+            else
+            {
+                const uint16_t total_length = htons(static_cast<uint16_t>(ip_len + UDP_HEADER_SIZE + payload_len));
+                ip[0] = 0x45;
+                std::memcpy(ip + 2, &total_length, sizeof(total_length));
+                // don't fragment
+                ip[6] = 0x40;
+                ip[8] = 64;
+                ip[9] = IPPROTO_UDP;
+                if (source.family() == AF_INET)
+                    std::memcpy(ip + 12, &source.to<sockaddr_in>()->sin_addr, sizeof(in_addr));
+                if (same_family)
+                    std::memcpy(ip + 16, &destination.to<sockaddr_in>()->sin_addr, sizeof(in_addr));
+
+                // header checksum, one's complement sum of 16 bits words
+                uint32_t sum = 0;
+                for (size_t index = 0; index < ip_len; index += 2)
+                    sum += (ip[index] << 8) | ip[index + 1];
+                while (sum >> 16)
+                    sum = (sum & 0xFFFF) + (sum >> 16);
+                const uint16_t checksum = htons(static_cast<uint16_t>(~sum));
+                std::memcpy(ip + 10, &checksum, sizeof(checksum));
+            }
+
+            unsigned char*  udp = ip + ip_len;
+            const uint16_t  source_port = htons(source.port());
+            const uint16_t  destination_port = htons(same_family ? destination.port() : 0);
+            const uint16_t  udp_length = htons(static_cast<uint16_t>(UDP_HEADER_SIZE + payload_len));
+            std::memcpy(udp, &source_port, sizeof(source_port));
+            std::memcpy(udp + 2, &destination_port, sizeof(destination_port));
+            std::memcpy(udp + 4, &udp_length, sizeof(udp_length));
+            return (ip_len + UDP_HEADER_SIZE);
+        }
+
+        /**
+         * @brief file descriptor of the capture file, -1 if closed
+         */
+        int                     file = -1;
+
+        /**
+         * @brief write buffer
+         */
+        std::vector<char>       buffer;
+
+        /**
+         * @brief number of bytes of buffer holding blocks not written yet
+         */
+        size_t                  used = 0;
+
+        /**
+         * @brief link types of the interfaces described in the section, index is the interface id
+         */
+        std::vector<uint16_t>   interfaces;
+
+        /**
+         * @brief number of packets written since open()
+         */
+        size_t                  n_packets = 0;
+};
+
+} // ******** namespace raw
+
+} // ******** namespace unisock
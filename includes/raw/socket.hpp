@@ -12,13 +12,26 @@
 
 #include "socket/socket.hpp"
 #include "socket/socket_address.hpp"
+#include "socket/ancillary.hpp"
+#include "raw/packet_ring.hpp"
+#include "raw/filter.hpp"
+#include "raw/pcapng.hpp"
 
 #include "events/events.hpp"
 #include "events/action_hanlder.hpp"
 
+#include <cassert>
 #include <iostream>
 #include <queue>
+#include <memory>
+#include <vector>
 #include <fcntl.h>
+#include <netinet/udp.h>
+
+#if defined(__linux__)
+# include <net/if.h>
+# include <linux/if_ether.h>
+#endif
 
 /**
  * @addindex
@@ -73,9 +86,313 @@ namespace actions
         static constexpr const char* action_name = "RECVFROM";
         static constexpr const char* callback_prototype = "void (const socket_address&, const char*, size_t)";
     };
+
+    /**
+     * @brief   socket received a batch of datagrams with recvmmsg
+     * 
+     * @details this event will be called once per batch when raw::socket calls recvmmsg(),
+     *          RECVFROM is then called for each datagram of the batch
+     * 
+     * @note    hook prototype: ```void  (const raw::datagram* datagrams, size_t count)```
+     */
+    struct  RECVMMSG
+    {
+        static constexpr const char* action_name = "RECVMMSG";
+        static constexpr const char* callback_prototype = "void (const raw::datagram*, size_t)";
+    };
+
+    /**
+     * @brief   socket read a frame from its packet ring
+     * 
+     * @details this event will be called for each frame of the blocks read by raw::socket_impl::recv_ring(),
+     *          the frame is read in place in the ring, without any copy
+     * 
+     * @note    hook prototype: ```void  (const raw::packet_frame& frame)```
+     */
+    struct  PACKET
+    {
+        static constexpr const char* action_name = "PACKET";
+        static constexpr const char* callback_prototype = "void (const raw::packet_frame&)";
+    };
 } // ******** namespace actions
 
 
+/**
+ * @brief   datagram received by raw::socket_impl::recvmmsg
+ * 
+ * @details message points to the receive batch buffers and is only valid until the end of the hook
+ */
+struct  datagram
+{
+    /**
+     * @brief address the datagram was received from
+     */
+    socket_address  address;
+
+    /**
+     * @brief received bytes
+     */
+    const char*     message = nullptr;
+
+    /**
+     * @brief number of received bytes
+     */
+    size_t          message_len = 0;
+
+    /**
+     * @brief true if the datagram was larger than the batch buffer size and was truncated
+     */
+    bool            truncated = false;
+
+    /**
+     * @brief receive timestamps of the datagram, set if receive timestamps are enabled (see unisock::socket::set_timestamping)
+     */
+    packet_timestamps   timestamps;
+
+    /**
+     * @brief ancillary data of the datagram, set if ancillary data is enabled (see raw::socket_impl::set_ancillary)
+     */
+    ancillary_data      ancillary;
+};
+
+
+/**
+ * @brief   preallocated buffers and addresses for batched receive of datagrams
+ * 
+ * @details uses recvmmsg where available, otherwise falls back to recvfrom in a loop.\n
+ *          when created for GRO (UDP_GRO set on the socket), each received buffer can hold several datagrams
+ *          of the same sender coalesced by the kernel, they are split again using the segment size from ancillary data.
+ * 
+ * @ref raw::socket_impl::set_recv_batch
+ */
+class   recv_batch
+{
+    public:
+        /**
+         * @brief buffer size needed to receive coalesced datagrams with GRO
+         */
+        static constexpr size_t GRO_BUFFER_SIZE = 65535;
+
+        /**
+         * @brief allocates buffers for **size** datagrams of at most **buffer_size** bytes
+         * 
+         * @param size          maximum number of datagrams (or coalesced buffers with GRO) received per batch
+         * @param buffer_size   maximum size of a datagram, should be GRO_BUFFER_SIZE with GRO
+         * @param gro           parses UDP_GRO ancillary data and splits coalesced buffers into datagrams
+         */
+        explicit recv_batch(size_t size, size_t buffer_size, bool gro = false)
+        : buffer_size(buffer_size), buffers(size * buffer_size), messages(size)
+#if defined(UDP_GRO)
+        , gro(gro)
+#endif
+#if defined(__linux__)
+        , headers(size), iov(size)
+#endif
+        {
+#if defined(__linux__)
+            control.resize(size * CONTROL_SIZE);
+            if (this->gro)
+                segments.reserve(size * MAX_GRO_SEGMENTS);
+            for (size_t i = 0; i < size; ++i)
+            {
+                iov[i].iov_base = &buffers[i * buffer_size];
+                iov[i].iov_len = buffer_size;
+                headers[i].msg_hdr.msg_iov = &iov[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+#endif
+            (void)gro;
+            for (size_t i = 0; i < size; ++i)
+                messages[i].message = &buffers[i * buffer_size];
+        }
+
+        /**
+         * @brief returns the maximum number of datagrams (or coalesced buffers with GRO) received per batch
+         */
+        size_t          size() const
+        {
+            return (messages.size());
+        }
+
+        /**
+         * @brief returns true if last receive() filled the batch, the socket may have more datagrams to receive
+         */
+        bool            full() const
+        {
+            return (received_messages == messages.size());
+        }
+
+        /**
+         * @brief returns views on datagrams received by last receive()
+         */
+        const datagram* datagrams() const
+        {
+            return (gro ? segments.data() : messages.data());
+        }
+
+        /**
+         * @brief   receives up to size() datagrams (or coalesced buffers with GRO) on **socket** without blocking
+         * 
+         * @param socket        socket file descriptor
+         * @param timestamps    reads receive timestamps of each datagram from ancillary data
+         * @param ancillary     receives ancillary data of each datagram (see datagram::ancillary)
+         * 
+         * @return number of received datagrams, -1 on error with errno set (EAGAIN if nothing was received)
+         */
+        int             receive(int socket, bool timestamps = false, bool ancillary = false)
+        {
+            const bool  with_control = gro || timestamps || ancillary;
+            received_messages = 0;
+#if defined(__linux__)
+            for (size_t i = 0; i < headers.size(); ++i)
+            {
+                headers[i].msg_hdr.msg_name = messages[i].address.to<sockaddr>();
+                headers[i].msg_hdr.msg_namelen = socket_address::ADDRESS_STORAGE_SIZE;
+                headers[i].msg_hdr.msg_flags = 0;
+                headers[i].msg_hdr.msg_control = with_control ? &control[i * CONTROL_SIZE] : nullptr;
+                headers[i].msg_hdr.msg_controllen = with_control ? CONTROL_SIZE : 0;
+            }
+
+            int n_received = ::recvmmsg(socket, headers.data(), headers.size(), MSG_DONTWAIT, nullptr);
+            for (int i = 0; i < n_received; ++i)
+            {
+                messages[i].address.set_size(headers[i].msg_hdr.msg_namelen);
+                messages[i].message_len = std::min<size_t>(headers[i].msg_len, buffer_size);
+                messages[i].truncated = headers[i].msg_hdr.msg_flags & MSG_TRUNC;
+                messages[i].ancillary = ancillary_data(headers[i].msg_hdr);
+                if (timestamps)
+                    messages[i].ancillary.timestamps(messages[i].timestamps);
+            }
+            if (n_received < 0)
+                return (n_received);
+            received_messages = n_received;
+# if defined(UDP_GRO)
+            if (gro)
+                return (split_segments());
+# endif
+            return (n_received);
+#else
+            (void)with_control;
+            (void)timestamps;
+            int n_received = 0;
+            for (; n_received < static_cast<int>(messages.size()); ++n_received)
+            {
+                datagram&   received = messages[n_received];
+                socklen_t   addr_len = socket_address::ADDRESS_STORAGE_SIZE;
+
+                ssize_t n_bytes = ::recvfrom(socket,
+                                                &buffers[n_received * buffer_size],
+                                                buffer_size,
+                                                MSG_DONTWAIT,
+                                                received.address.to<sockaddr>(),
+                                                &addr_len);
+                if (n_bytes < 0)
+                    break ;
+                received.address.set_size(addr_len);
+                received.message_len = n_bytes;
+                received.truncated = false;
+            }
+            received_messages = n_received;
+            return (n_received > 0 ? n_received : -1);
+#endif
+        }
+
+    private:
+#if defined(__linux__)
+        /**
+         * @brief control buffer size of each message, holds the GRO segment size, timestamps and ancillary data
+         */
+        static constexpr size_t CONTROL_SIZE = control_buffer::CAPACITY;
+
+        /**
+         * @brief usual maximum number of datagrams coalesced by GRO in one buffer, used to preallocate segments
+         */
+        static constexpr size_t MAX_GRO_SEGMENTS = 64;
+#endif
+
+#if defined(UDP_GRO)
+        /**
+         * @brief   splits buffers received with GRO into datagrams of the segment size found in ancillary data
+         * 
+         * @return number of datagrams
+         */
+        int             split_segments()
+        {
+            segments.clear();
+            for (size_t i = 0; i < received_messages; ++i)
+            {
+                const datagram& received = messages[i];
+                size_t          segment_size = received.message_len;
+                uint16_t        gso_size = 0;
+
+                if (received.ancillary.segment_size(gso_size))
+                    segment_size = gso_size;
+
+                if (segment_size == 0 || segment_size >= received.message_len)
+                {
+                    segments.push_back(received);
+                    continue ;
+                }
+                for (size_t offset = 0; offset < received.message_len; offset += segment_size)
+                {
+                    segments.push_back(received);
+                    segments.back().message = received.message + offset;
+                    segments.back().message_len = std::min(segment_size, received.message_len - offset);
+                }
+            }
+            return (static_cast<int>(segments.size()));
+        }
+#endif
+
+        /**
+         * @brief maximum size of a datagram
+         */
+        size_t                  buffer_size;
+
+        /**
+         * @brief buffers of all datagrams, contiguous
+         */
+        std::vector<char>       buffers;
+
+        /**
+         * @brief views on buffers received by last receive(), one per received message
+         */
+        std::vector<datagram>   messages;
+
+        /**
+         * @brief number of messages received by last receive()
+         */
+        size_t                  received_messages = 0;
+
+        /**
+         * @brief true if coalesced buffers are split into segments
+         */
+        bool                    gro = false;
+
+        /**
+         * @brief views on datagrams split from coalesced buffers with GRO
+         */
+        std::vector<datagram>   segments;
+
+#if defined(__linux__)
+        /**
+         * @brief control buffers of all messages, contiguous
+         */
+        std::vector<char>       control;
+
+        /**
+         * @brief recvmmsg headers, one per datagram
+         */
+        std::vector<mmsghdr>    headers;
+
+        /**
+         * @brief iovec of each datagram buffer
+         */
+        std::vector<iovec>      iov;
+#endif
+};
+
+
 /**
  * @brief actions for a raw::socket
  * 
@@ -89,6 +406,12 @@ using   actions_list = unisock::events::actions_list<
 
     unisock::events::action<actions::RECVFROM, 
             std::function< void (const socket_address& address, const char *message, size_t message_len) > >,
+
+    unisock::events::action<actions::RECVMMSG, 
+            std::function< void (const datagram* datagrams, size_t count) > >,
+
+    unisock::events::action<actions::PACKET, 
+            std::function< void (const packet_frame& frame) > >,
     
     _ExtendedActions...
 >;
@@ -225,7 +548,9 @@ class socket_impl<
 
         /**
          * @brief   receives data to be read on this socket, calls back RECVMSG handler with received bytes
-         * @details see [man recvmsg](https://man7.org/linux/man-pages/man2/recvmsg.2.html) for more informations about recvmsg
+         * @details see [man recvmsg](https://man7.org/linux/man-pages/man2/recvmsg.2.html) for more informations about recvmsg\n
+         *          the header passed to RECVMSG holds the ancillary data of the message in msg_control, it can also be read
+         *          with get_ancillary(), and its timestamps with get_timestamps() if enabled (see unisock::socket::set_timestamping)
          * 
          * @return true if bytes were received, false on error 
          */
@@ -233,17 +558,25 @@ class socket_impl<
         {
             assert(this->get_socket() > 0);
 
+            if ((this->timestamping & _lib::TIMESTAMP_TX) && !this->recv_errqueue())
+                return (false);
+
             struct msghdr   header;
             struct iovec    iov[1];
-            char            buffer[base_type::RECV_BUFFER_SIZE] { 0 };
+            char            buffer[base_type::RECV_BUFFER_SIZE];
+            // source address, also given to hooks in header.msg_name
+            socket_address  address;
 
             std::memset(&header, 0, sizeof(header));
             std::memset(iov, 0, sizeof(iov));
 
             iov[0].iov_base = buffer;
             iov[0].iov_len  = sizeof(buffer);
+            header.msg_name    = address.to<sockaddr>();
+            header.msg_namelen = socket_address::ADDRESS_STORAGE_SIZE;
             header.msg_iov     = iov;
             header.msg_iovlen  = 1;
+            this->recv_control.attach_receive(header);
 
             int n_bytes = ::recvmsg(this->get_socket(), &header, MSG_DONTWAIT);
             if (n_bytes < 0)
@@ -252,6 +585,13 @@ class socket_impl<
                 return (false);
             }
 
+            address.set_size(header.msg_namelen);
+
+            this->ancillary = ancillary_data(header);
+            if (this->timestamping & _lib::TIMESTAMP_RX)
+                this->ancillary.timestamps(this->timestamps);
+            if (this->capture)
+                this->capture_packet(address, buffer, n_bytes);
             this->template execute<actions::RECVMSG>(header);
             return (true);
         }
@@ -260,37 +600,589 @@ class socket_impl<
 
         /**
          * @brief   receives data to be read on this socket, calls back RECVFROM handler with received bytes
-         * @details see [man recvfrom](https://man7.org/linux/man-pages/man2/recvfrom.2.html) for more informations about recvfrom
+         * @details see [man recvfrom](https://man7.org/linux/man-pages/man2/recvfrom.2.html) for more informations about recvfrom\n
+         *          when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          recvfrom loops until the socket is flushed (EAGAIN) or until its quota is exhausted.
          * 
-         * @return true if bytes were received, false on error 
+         * @return true if bytes were received, false on error or if socket had nothing to receive
          */
         bool    recvfrom()
         {
             assert(this->get_socket() > 0);
 
-            char        buffer[base_type::RECV_BUFFER_SIZE] { 0 };
+            // keeps a reference to the handler, this socket may be deleted by a hook
+            std::shared_ptr<events::handler> handler = this->handler;
+            const int   socket = this->get_socket();
+            char        buffer[base_type::RECV_BUFFER_SIZE];
+            ssize_t     n_bytes = 0;
+
+            if ((this->timestamping & _lib::TIMESTAMP_TX) && !this->recv_errqueue())
+                return (false);
 
-            // TODO: change this when refractoring socket_address
-            struct sockaddr_storage addr;
-            socklen_t               addr_len = sizeof(addr);
-            memset(&addr, 0, addr_len);
+            do
+            {
+                // received in place, hooks get the address without a copy of the storage
+                socket_address  address;
+                socklen_t       addr_len = socket_address::ADDRESS_STORAGE_SIZE;
 
-            int n_bytes = ::recvfrom(this->get_socket(),
-                                        buffer,
-                                        base_type::RECV_BUFFER_SIZE, 
-                                        MSG_DONTWAIT,
-                                        reinterpret_cast<sockaddr*>(&addr),
-                                        &addr_len);
-            if (n_bytes < 0)
+                if (this->with_ancillary())
+                    n_bytes = this->receive_ancillary(socket,
+                                                        buffer,
+                                                        base_type::RECV_BUFFER_SIZE,
+                                                        address.to<sockaddr>(),
+                                                        &addr_len);
+                else
+                    n_bytes = ::recvfrom(socket,
+                                            buffer,
+                                            base_type::RECV_BUFFER_SIZE, 
+                                            MSG_DONTWAIT,
+                                            address.to<sockaddr>(),
+                                            &addr_len);
+                if (n_bytes < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        this->template execute<basic_actions::ERROR>("recv", errno);
+                    return (false);
+                }
+                address.set_size(addr_len);
+
+                if (this->capture)
+                    this->capture_packet(address, buffer, n_bytes);
+                ushort handler_ref = handler->get_ref();
+                this->template execute<actions::RECVFROM>(address, buffer, n_bytes);
+                // a socket was added or deleted by the hook, this socket may not exist anymore
+                if (handler->ref_has_changed(handler_ref))
+                    return (true);
+            }
+            while (handler->consume(socket, n_bytes));
+            return (true);
+        }
+
+
+        /**
+         * @brief   enables batched receive for recvmmsg()
+         * 
+         * @details allocates buffers and addresses for **batch_size** datagrams once, so that recvmmsg()
+         *          can receive a whole batch with a single syscall.
+         * 
+         * @note    must not be called from a RECVMMSG or RECVFROM hook
+         * 
+         * @param batch_size    maximum number of datagrams received per syscall, 0 disables batched receive
+         * @param buffer_size   maximum size of a datagram, larger datagrams are truncated
+         * @param gro           splits buffers coalesced by UDP_GRO into datagrams (see recv_batch), buffer_size should be recv_batch::GRO_BUFFER_SIZE
+         */
+        void    set_recv_batch(size_t batch_size, size_t buffer_size = base_type::RECV_BUFFER_SIZE, bool gro = false)
+        {
+            if (batch_size == 0)
+                this->batch.reset();
+            else
+                this->batch.reset(new recv_batch(batch_size, buffer_size, gro));
+        }
+
+        /**
+         * @brief   receives a batch of datagrams, calls back RECVMMSG once with the batch then RECVFROM for each datagram
+         * @details see [man recvmmsg](https://man7.org/linux/man-pages/man2/recvmmsg.2.html) for more informations about recvmmsg\n
+         *          datagrams are received in the buffers allocated by set_recv_batch, falls back to recvfrom() if batched receive is not enabled.\n
+         *          when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          each batch counts as one read, recvmmsg loops while batches are full and the quota is not exhausted.
+         * 
+         * @return true if datagrams were received, false on error or if socket had nothing to receive
+         */
+        bool    recvmmsg()
+        {
+            assert(this->get_socket() > 0);
+
+            if (!this->batch)
+                return (this->recvfrom());
+
+            // keeps a reference to the handler, this socket may be deleted by a hook
+            std::shared_ptr<events::handler> handler = this->handler;
+            const int   socket = this->get_socket();
+            recv_batch& batch = *this->batch;
+            size_t      n_bytes = 0;
+            const bool  timestamps = this->timestamping & _lib::TIMESTAMP_RX;
+
+            if ((this->timestamping & _lib::TIMESTAMP_TX) && !this->recv_errqueue())
+                return (false);
+
+            do
+            {
+                int n_received = batch.receive(socket, timestamps, this->ancillary_flags != ANCILLARY_NONE);
+                if (n_received < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        this->template execute<basic_actions::ERROR>("recvmmsg", errno);
+                    return (false);
+                }
+
+                const datagram* datagrams = batch.datagrams();
+                for (int i = 0; this->capture && i < n_received; ++i)
+                    this->capture_packet(datagrams[i].address, datagrams[i].message, datagrams[i].message_len, datagrams[i].timestamps);
+                ushort handler_ref = handler->get_ref();
+                this->template execute<actions::RECVMMSG>(datagrams, static_cast<size_t>(n_received));
+                // a socket was added or deleted by the hook, this socket may not exist anymore
+                if (handler->ref_has_changed(handler_ref))
+                    return (true);
+
+                n_bytes = 0;
+                for (int i = 0; i < n_received; ++i)
+                {
+                    const datagram& received = datagrams[i];
+                    n_bytes += received.message_len;
+                    this->timestamps = received.timestamps;
+                    this->ancillary = received.ancillary;
+                    this->template execute<actions::RECVFROM>(received.address, received.message, received.message_len);
+                    if (handler->ref_has_changed(handler_ref))
+                        return (true);
+                }
+            }
+            // a batch that was not filled flushed the socket
+            while (batch.full() && handler->consume(socket, n_bytes));
+            return (true);
+        }
+
+        /**
+         * @brief   enables ancillary data received with each packet
+         * 
+         * @details receive functions then use recvmsg with a preallocated control buffer, ancillary data of the last
+         *          received packet is read with get_ancillary() in RECVFROM / RECVMSG hooks (RECEIVE for udp::socket),
+         *          and is set in raw::datagram::ancillary for batches.
+         * 
+         * @note    the socket must be opened
+         * 
+         * @param flags ancillary_flag combined with bitwise or, ANCILLARY_NONE disables ancillary data
+         * 
+         * @return true if options were set, false on error, ERROR hook is called with errno of error
+         */
+        bool    set_ancillary(int flags)
+        {
+            sockaddr_storage    bound;
+            socklen_t           bound_len = sizeof(bound);
+            if (0 > ::getsockname(this->get_socket(), reinterpret_cast<sockaddr*>(&bound), &bound_len)
+                || !_lib::set_ancillary_options(this->get_socket(), bound.ss_family, flags))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            this->ancillary_flags = flags;
+            return (true);
+        }
+
+        /**
+         * @brief returns the ancillary data of the last received packet, only valid while a receive hook is executed
+         */
+        const ancillary_data&   get_ancillary() const
+        {
+            return (this->ancillary);
+        }
+
+        /**
+         * @brief   sends **message** of **size** bytes to **address** with ancillary data of **control**
+         * @details see [man sendmsg](https://man7.org/linux/man-pages/man2/sendmsg.2.html) for more informations about sendmsg,
+         *          **control** can set the source address, tos or ttl of the packet (see control_buffer)
+         * 
+         * @param   address the address to send the message to
+         * @param   message message to send as char buffer
+         * @param   size    size of the **message** buffer
+         * @param   control ancillary data to send with the message
+         * @param   flags   flags for sendmsg, 0 by default
+         * 
+         * @return true if message was sent, false on error, ERROR hook is called with errno of error
+         */
+        bool    send_to(const socket_address& address, const char* message, size_t size, const control_buffer& control, int flags = 0)
+        {
+            assert(this->get_socket() > 0);
+
+            msghdr  header;
+            iovec   iov;
+
+            std::memset(&header, 0, sizeof(header));
+            iov.iov_base = const_cast<char*>(message);
+            iov.iov_len = size;
+            header.msg_name = const_cast<sockaddr*>(address.template to<sockaddr>());
+            header.msg_namelen = address.size();
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+            control.attach(header);
+
+            if (0 > ::sendmsg(this->get_socket(), &header, flags))
+            {
+                this->template execute<basic_actions::ERROR>("sendmsg", errno);
+                return (false);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   writes every packet received by this socket to **writer**, before receive hooks are called
+         * 
+         * @details packets are written as seen by the socket: with their link layer header for AF_PACKET SOCK_RAW sockets
+         *          (and frames of the packet ring), with their IP header for IPv4 raw sockets, and with IP and udp headers
+         *          rebuilt from the sender and socket addresses for udp sockets. kernel receive timestamps are used
+         *          if enabled (see unisock::socket::set_timestamping).\n
+         *          a writer can be shared by sockets polled by the same thread.
+         * 
+         * @note    the socket must be opened, IPv6 raw sockets are not supported as they receive packets without IP header
+         * 
+         * @param writer    opened writer, nullptr stops writing packets
+         * 
+         * @return true if capture was set, false on error, ERROR hook is called with errno of error
+         */
+        bool    set_capture(std::shared_ptr<pcapng_writer> writer)
+        {
+            if (!writer)
+            {
+                this->capture.reset();
+                return (true);
+            }
+
+            sockaddr_storage    bound;
+            socklen_t           bound_len = sizeof(bound);
+            int                 type = 0;
+            socklen_t           type_len = sizeof(type);
+            if (0 > ::getsockname(this->get_socket(), reinterpret_cast<sockaddr*>(&bound), &bound_len)
+                || 0 > ::getsockopt(this->get_socket(), SOL_SOCKET, SO_TYPE, &type, &type_len))
+            {
+                this->template execute<basic_actions::ERROR>("getsockopt", errno);
+                return (false);
+            }
+
+#if defined(__linux__)
+            if (bound.ss_family == AF_PACKET)
+                this->capture_link = (type == SOCK_RAW ? pcapng_writer::LINKTYPE_ETHERNET : pcapng_writer::LINKTYPE_RAW);
+            else
+#endif
+            if (type == SOCK_RAW && bound.ss_family == AF_INET)
+                this->capture_link = pcapng_writer::LINKTYPE_RAW;
+            else if (type == SOCK_DGRAM && (bound.ss_family == AF_INET || bound.ss_family == AF_INET6))
+                this->capture_link = LINKTYPE_UDP;
+            else
+            {
+                this->template execute<basic_actions::ERROR>("set_capture", EPROTONOSUPPORT);
+                return (false);
+            }
+            this->capture = std::move(writer);
+            return (true);
+        }
+
+#if defined(__linux__)
+        /**
+         * @brief   attaches a classic BPF program filtering packets received by this socket
+         * 
+         * @details packets rejected by the program are dropped by the kernel before being queued on the socket,
+         *          replaces the program previously attached. see [man socket](https://man7.org/linux/man-pages/man7/socket.7.html)
+         *          for SO_ATTACH_FILTER, and raw::filter_builder to build programs from common predicates.
+         * 
+         * @note    the socket must be opened, packets queued before the program was attached are still received
+         * 
+         * @param code      instructions of the program
+         * @param code_len  number of instructions
+         * 
+         * @return true if program was attached, false on error, ERROR hook is called with errno of error
+         */
+        bool    attach_filter(const sock_filter* code, size_t code_len)
+        {
+            sock_fprog program = { static_cast<unsigned short>(code_len), const_cast<sock_filter*>(code) };
+            if (!this->setsockopt(SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   attaches the program built by **filter**, see attach_filter(const sock_filter*, size_t)
+         * 
+         * @return true if program was attached, false on error, ERROR hook is called with errno of error
+         */
+        bool    attach_filter(const filter_builder& filter)
+        {
+            const std::vector<sock_filter> code = filter.build();
+            return (this->attach_filter(code.data(), code.size()));
+        }
+
+        /**
+         * @brief   removes the program attached with attach_filter, the socket receives all packets again
+         * 
+         * @return true if program was removed, false on error, ERROR hook is called with errno of error
+         */
+        bool    detach_filter()
+        {
+            int unused = 0;
+            if (!this->setsockopt(SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   binds an AF_PACKET socket to the interface named **interface**
+         * @details see [man packet](https://man7.org/linux/man-pages/man7/packet.7.html) for more informations about AF_PACKET sockets
+         * 
+         * @param interface name of the interface ("lo", "eth0", ...), empty to capture on all interfaces
+         * @param protocol  link layer protocol to capture (ETH_P_*), in host byte order
+         * 
+         * @return true if socket was bound, false on error, ERROR hook is called with errno of error
+         */
+        bool    bind_interface(const std::string& interface, uint16_t protocol = ETH_P_ALL)
+        {
+            sockaddr_ll link;
+            std::memset(&link, 0, sizeof(link));
+            link.sll_family = AF_PACKET;
+            link.sll_protocol = htons(protocol);
+            if (!interface.empty())
+            {
+                link.sll_ifindex = static_cast<int>(::if_nametoindex(interface.c_str()));
+                if (link.sll_ifindex == 0)
+                {
+                    this->template execute<basic_actions::ERROR>("if_nametoindex", errno);
+                    return (false);
+                }
+            }
+
+            if (0 > ::bind(this->get_socket(), reinterpret_cast<const sockaddr*>(&link), sizeof(link)))
+            {
+                this->template execute<basic_actions::ERROR>("bind", errno);
+                return (false);
+            }
+            this->address = socket_address(reinterpret_cast<const sockaddr*>(&link), sizeof(link));
+            return (true);
+        }
+
+        /**
+         * @brief   maps a TPACKET_V3 receive ring on this AF_PACKET socket
+         * 
+         * @details the kernel then writes captured packets into the ring instead of queueing them on the socket,
+         *          recv_ring() reads them in place and calls PACKET for each frame, without a syscall per packet.\n
+         *          the direct readable dispatch of the socket is set to recv_ring(), hooking basic_actions::READABLE
+         *          replaces it (the hook should then call recv_ring()).
+         * 
+         * @note    should be called after open() and before bind_interface(), so that no packet is queued outside of the ring
+         * 
+         * @param block_size        size of a block, a multiple of the page size
+         * @param block_count       number of blocks
+         * @param frame_size        maximum size of a frame, larger packets are truncated
+         * @param retire_timeout    time in milliseconds after which a block that is not full is read
+         * 
+         * @return true if ring was mapped, false on error, ERROR hook is called with errno of error
+         */
+        bool    set_packet_ring(size_t block_size = packet_ring::DEFAULT_BLOCK_SIZE,
+                                size_t block_count = packet_ring::DEFAULT_BLOCK_COUNT,
+                                size_t frame_size = packet_ring::DEFAULT_FRAME_SIZE,
+                                unsigned retire_timeout = packet_ring::DEFAULT_RETIRE_TIMEOUT)
+        {
+            std::unique_ptr<packet_ring> mapped(new packet_ring(block_size, block_count, frame_size, retire_timeout));
+            if (!mapped->map(this->get_socket()))
             {
-                this->template execute<basic_actions::ERROR>("recv", errno);
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
                 return (false);
             }
+            this->ring = std::move(mapped);
+            this->set_dispatch(&socket_impl::dispatch_recv_ring, this->get_dispatch().writeable, this->get_dispatch().context);
+            return (true);
+        }
 
-            socket_address address { addr };
-            this->template execute<actions::RECVFROM>(address, buffer, n_bytes);
+        /**
+         * @brief   reads the blocks of the packet ring handed to user space, calls back PACKET for each frame
+         * @details each block is given back to the kernel once all its frames were read.
+         *          hooks may add or delete sockets, reading only stops if this socket was deleted.\n
+         *          when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          each block counts as one read, recv_ring loops until no block is ready or until the quota is exhausted.
+         * 
+         * @return true if a block was read, false if the ring is not set or had no block ready
+         */
+        bool    recv_ring()
+        {
+            if (!this->ring || !this->ring->ready())
+                return (false);
+
+            // keeps a reference to the handler, this socket may be deleted by a hook
+            std::shared_ptr<events::handler> handler = this->handler;
+            const socket_base*  self = this;
+            const int           socket = this->get_socket();
+            ushort              handler_ref = handler->get_ref();
+            size_t              n_bytes = 0;
+            bool                deleted = false;
+
+            do
+            {
+                n_bytes = 0;
+                const bool read = this->ring->consume_block(
+                    [this, &handler, self, socket, &handler_ref, &n_bytes, &deleted](const packet_frame& frame){
+                        n_bytes += frame.length;
+                        if (this->capture)
+                            this->capture->write(frame);
+                        this->template execute<actions::PACKET>(frame);
+                        // a socket was added or deleted by the hook, reading stops only if it was this socket
+                        if (handler->ref_has_changed(handler_ref))
+                        {
+                            deleted = !handler->has_socket(socket, self);
+                            handler_ref = handler->get_ref();
+                        }
+                        return (!deleted);
+                    }
+                );
+                if (deleted || !read)
+                    return (true);
+            }
+            while (this->ring->ready() && handler->consume(socket, n_bytes));
             return (true);
         }
+
+        /**
+         * @brief   returns statistics of the packet ring since the last call
+         * @details the kernel resets the counters each time they are read
+         * 
+         * @param stats set to the statistics of the ring
+         * 
+         * @return true if statistics were read, false on error, ERROR hook is called with errno of error
+         */
+        bool    get_ring_stats(packet_ring_stats& stats)
+        {
+            tpacket_stats_v3    kernel_stats {};
+            socklen_t           stats_len = sizeof(kernel_stats);
+            if (0 > ::getsockopt(this->get_socket(), SOL_PACKET, PACKET_STATISTICS, &kernel_stats, &stats_len))
+            {
+                this->template execute<basic_actions::ERROR>("getsockopt", errno);
+                return (false);
+            }
+            stats.packets = kernel_stats.tp_packets;
+            stats.drops = kernel_stats.tp_drops;
+            stats.freezes = kernel_stats.tp_freeze_q_cnt;
+            return (true);
+        }
+#endif
+
+    protected:
+        /**
+         * @brief capture_link of udp sockets, rebuilds IP and udp headers (see pcapng_writer::write_udp)
+         */
+        static constexpr uint16_t   LINKTYPE_UDP = 0xFFFF;
+
+        /**
+         * @brief   writes a received packet to the writer set with set_capture
+         * 
+         * @param source        address the packet was received from
+         * @param packet        received bytes
+         * @param packet_len    size of **packet**
+         * @param timestamps    receive timestamps of the packet, defaults to the timestamps of the last received packet
+         */
+        void    capture_packet(const socket_address& source, const char* packet, size_t packet_len)
+        {
+            this->capture_packet(source, packet, packet_len,
+                                    (this->timestamping & _lib::TIMESTAMP_RX) ? this->timestamps : packet_timestamps {});
+        }
+
+        /**
+         * @brief   writes a received packet with **timestamps** to the writer set with set_capture
+         */
+        void    capture_packet(const socket_address& source, const char* packet, size_t packet_len, const packet_timestamps& timestamps)
+        {
+            if (this->capture_link == LINKTYPE_UDP)
+                this->capture->write_udp(source, this->address, packet, packet_len, timestamps);
+            else if (this->capture_link == pcapng_writer::LINKTYPE_RAW)
+                this->capture->write_ip(packet, packet_len, timestamps);
+            else
+                this->capture->write(this->capture_link, packet, packet_len, packet_len, pcapng_writer::timestamp(timestamps));
+        }
+
+#if defined(__linux__)
+        /**
+         * @brief direct readable dispatch of raw::socket when a packet ring is set, see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready raw::socket
+         * @param context   unused
+         */
+        static void dispatch_recv_ring(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<socket_impl*>(socket)->recv_ring();
+        }
+#endif
+
+        /**
+         * @brief returns true if receive functions need the ancillary data of packets (timestamps or set_ancillary)
+         */
+        bool    with_ancillary() const
+        {
+            return ((this->timestamping & _lib::TIMESTAMP_RX) || this->ancillary_flags != ANCILLARY_NONE);
+        }
+
+        /**
+         * @brief   receives a packet with recvmsg in the control buffer of the socket, sets ancillary and timestamps
+         * 
+         * @param socket        socket file descriptor
+         * @param buffer        buffer to receive the packet
+         * @param buffer_len    size of **buffer**
+         * @param address       filled with the sender address if not nullptr
+         * @param address_len   size of **address**, set to the size of the sender address
+         * 
+         * @return number of received bytes, -1 on error with errno set
+         */
+        ssize_t receive_ancillary(int socket, char* buffer, size_t buffer_len, sockaddr* address, socklen_t* address_len)
+        {
+            msghdr  header;
+            iovec   iov;
+
+            std::memset(&header, 0, sizeof(header));
+            iov.iov_base = buffer;
+            iov.iov_len = buffer_len;
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+            header.msg_name = address;
+            header.msg_namelen = address_len != nullptr ? *address_len : 0;
+            this->recv_control.attach_receive(header);
+
+            ssize_t n_bytes = ::recvmsg(socket, &header, MSG_DONTWAIT);
+            if (n_bytes < 0)
+                return (n_bytes);
+            if (address_len != nullptr)
+                *address_len = header.msg_namelen;
+            this->ancillary = ancillary_data(header);
+            if (this->timestamping & _lib::TIMESTAMP_RX)
+                this->ancillary.timestamps(this->timestamps);
+            return (n_bytes);
+        }
+
+        /**
+         * @brief buffers for batched receive, nullptr if not enabled (see set_recv_batch)
+         */
+        std::unique_ptr<recv_batch>  batch;
+
+        /**
+         * @brief control buffer reused by recvmsg() and receive_ancillary()
+         */
+        control_buffer  recv_control;
+
+        /**
+         * @brief ancillary data of the last received packet
+         */
+        ancillary_data  ancillary;
+
+        /**
+         * @brief ancillary_flag enabled on the socket (see set_ancillary)
+         */
+        int             ancillary_flags = ANCILLARY_NONE;
+
+        /**
+         * @brief writer of received packets, nullptr if not set (see set_capture)
+         */
+        std::shared_ptr<pcapng_writer>  capture;
+
+        /**
+         * @brief link type of packets written to capture, LINKTYPE_UDP for udp sockets
+         */
+        uint16_t        capture_link = 0;
+
+#if defined(__linux__)
+        /**
+         * @brief receive ring of an AF_PACKET socket, nullptr if not set (see set_packet_ring)
+         */
+        std::unique_ptr<packet_ring>    ring;
+#endif
 };
 
 
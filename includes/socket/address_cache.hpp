@@ -0,0 +1,214 @@
+/**
+ * @file address_cache.hpp
+ * @author ROBINO Luca
+ * @brief  process wide cache of hostname resolutions used by socket_address::addrinfo
+ * @version 1.0
+ * @date 2024-02-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "socket/socket_address.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @brief   cache of resolved hostnames, keyed by hostname and family
+ *
+ * @details socket_address::addrinfo and socket_address::addrinfo_all look hostnames up in address_cache::instance()
+ *          before calling getaddrinfo, so that reconnects do not resolve the same name again.\n
+ *          getaddrinfo does not report the TTL of DNS records, successful resolutions are kept for the ttl of the cache
+ *          and names that do not exist (EAI_NONAME, EAI_NODATA) for its negative ttl, other failures are not cached
+ *          since they are transient (EAI_AGAIN, EAI_MEMORY, EAI_SYSTEM) or depend on the request (EAI_FAMILY).\n
+ *          lookups only take a shared lock, entries are evicted in least recently used order when the cache is full.
+ *
+ * @code
+ *  address_cache::instance().set_ttl(std::chrono::seconds(60));
+ *  address_cache::instance().set_capacity(4096);
+ * @endcode
+ *
+ * @ref socket_address::addrinfo_all
+ */
+class   address_cache
+{
+    public:
+        /**
+         * @brief clock of cache entries expiration
+         */
+        using clock_type = std::chrono::steady_clock;
+
+        /**
+         * @brief default time successful resolutions are kept
+         */
+        static constexpr std::chrono::seconds::rep  DEFAULT_TTL = 30;
+
+        /**
+         * @brief default time failed resolutions are kept
+         */
+        static constexpr std::chrono::seconds::rep  DEFAULT_NEGATIVE_TTL = 5;
+
+        /**
+         * @brief default maximum number of entries
+         */
+        static constexpr size_t                     DEFAULT_CAPACITY = 1024;
+
+        /**
+         * @brief creates an empty cache with default ttls and capacity
+         */
+        explicit address_cache();
+
+        address_cache(const address_cache& copy) = delete;
+
+        /**
+         * @brief returns the cache used by socket_address::addrinfo
+         */
+        static address_cache&   instance();
+
+        /**
+         * @brief   looks **hostname** of **family** up
+         *
+         * @param addresses   set to the cached addresses if the entry is a successful resolution
+         * @param result      set to the cached result, errno is set to the errno of the cached resolution
+         * @param gai_error   set to the getaddrinfo error code (EAI_*) of the cached resolution, 0 on success
+         *
+         * @return true if a valid entry was found
+         */
+        bool    find(const std::string& hostname, sa_family_t family, std::vector<socket_address>& addresses, addrinfo_result& result, int& gai_error) const;
+
+        /**
+         * @brief   stores the resolution of **hostname** of **family**
+         *
+         * @details only addrinfo_result::SUCCESS results and addrinfo_result::ERROR results of **gai_error** EAI_NONAME
+         *          or EAI_NODATA are stored, **error** is the errno and **gai_error** the getaddrinfo error code
+         *          returned by find() on a hit
+         */
+        void    store(const std::string& hostname, sa_family_t family, const std::vector<socket_address>& addresses, addrinfo_result result, int error, int gai_error);
+
+        /**
+         * @brief returns true if a resolution that failed with **gai_error** may be cached
+         */
+        static bool is_negative_cacheable(int gai_error);
+
+        /**
+         * @brief removes the entry of **hostname** of **family**
+         */
+        void    erase(const std::string& hostname, sa_family_t family);
+
+        /**
+         * @brief removes all entries
+         */
+        void    clear();
+
+        /**
+         * @brief sets the time successful resolutions are kept, 0 disables caching of successful resolutions
+         */
+        void    set_ttl(clock_type::duration ttl);
+
+        /**
+         * @brief sets the time failed resolutions are kept, 0 disables negative caching
+         */
+        void    set_negative_ttl(clock_type::duration ttl);
+
+        /**
+         * @brief sets the maximum number of entries, 0 disables the cache
+         */
+        void    set_capacity(size_t capacity);
+
+        /**
+         * @brief returns the number of entries, including expired entries not evicted yet
+         */
+        size_t  size() const;
+
+    private:
+        /**
+         * @brief cached resolution
+         */
+        struct  entry
+        {
+            /**
+             * @brief resolved addresses, empty for failed resolutions
+             */
+            std::vector<socket_address>     addresses;
+
+            /**
+             * @brief result of the resolution
+             */
+            addrinfo_result                 result;
+
+            /**
+             * @brief errno of the resolution
+             */
+            int                             error;
+
+            /**
+             * @brief getaddrinfo error code (EAI_*) of the resolution, 0 on success
+             */
+            int                             gai_error;
+
+            /**
+             * @brief time after which the entry is not used anymore
+             */
+            clock_type::time_point          expires;
+
+            /**
+             * @brief tick of the last lookup, used for least recently used eviction
+             */
+            mutable std::atomic<uint64_t>   last_used;
+        };
+
+        /**
+         * @brief returns the key of **hostname** of **family**
+         */
+        static std::string  make_key(const std::string& hostname, sa_family_t family);
+
+        /**
+         * @brief removes expired entries, then the least recently used one if the cache is still full, lock must be held
+         */
+        void    evict();
+
+        /**
+         * @brief protects entries and settings, shared by lookups
+         */
+        mutable std::shared_timed_mutex                         mutex;
+
+        /**
+         * @brief entries by key
+         */
+        std::unordered_map<std::string, std::unique_ptr<entry>> entries;
+
+        /**
+         * @brief incremented on each hit, orders entries by last use
+         */
+        mutable std::atomic<uint64_t>                           tick;
+
+        /**
+         * @brief time successful resolutions are kept
+         */
+        clock_type::duration                                    ttl;
+
+        /**
+         * @brief time failed resolutions are kept
+         */
+        clock_type::duration                                    negative_ttl;
+
+        /**
+         * @brief maximum number of entries
+         */
+        size_t                                                  capacity;
+};
+
+} // ******** namespace unisock
@@ -0,0 +1,597 @@
+/**
+ * @file ancillary.hpp
+ * @author ROBINO Luca
+ * @brief  typed builder and parser of ancillary data (cmsg) for sendmsg and recvmsg, and file descriptor passing
+ * @version 1.0
+ * @date 2024-02-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "socket/socket_address.hpp"
+#include "socket/timestamping.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @brief   ancillary data to receive with each packet, see raw::socket_impl::set_ancillary
+ *
+ * @details flags can be combined with bitwise or
+ */
+enum  ancillary_flag
+{
+    /**
+     * @brief no ancillary data
+     */
+    ANCILLARY_NONE =    0b0000,
+
+    /**
+     * @brief destination address and interface of the packet (IP_PKTINFO, IPV6_RECVPKTINFO)
+     */
+    ANCILLARY_PKTINFO = 0b0001,
+
+    /**
+     * @brief type of service / traffic class of the packet (IP_RECVTOS, IPV6_RECVTCLASS)
+     */
+    ANCILLARY_TOS =     0b0010,
+
+    /**
+     * @brief time to live / hop limit of the packet (IP_RECVTTL, IPV6_RECVHOPLIMIT)
+     */
+    ANCILLARY_TTL =     0b0100,
+};
+
+
+/**
+ * @brief   preallocated buffer to build ancillary data sent with sendmsg, or to receive ancillary data with recvmsg
+ *
+ * @details the buffer has a fixed capacity and never allocates, it is meant to be kept and reused for each message:
+ *          clear() it, add() control messages, then attach() it to the msghdr of sendmsg.
+ *
+ * @ref ancillary_data
+ */
+class   control_buffer
+{
+    public:
+        /**
+         * @brief capacity of the buffer, enough for packet info, tos, ttl, timestamps and segment size together
+         */
+        static constexpr size_t CAPACITY = 256;
+
+        /**
+         * @brief maximum number of file descriptors passed in one message, leaves room for timestamps
+         */
+        static constexpr size_t MAX_FDS = 16;
+
+        explicit control_buffer() = default;
+
+        /**
+         * @brief removes all control messages
+         */
+        void        clear()
+        {
+            used = 0;
+        }
+
+        /**
+         * @brief returns the size of control messages added to the buffer
+         */
+        size_t      size() const
+        {
+            return (used);
+        }
+
+        /**
+         * @brief returns true if no control message was added
+         */
+        bool        empty() const
+        {
+            return (used == 0);
+        }
+
+        /**
+         * @brief   adds a control message of **level** and **type** with **data_len** bytes of **data**
+         *
+         * @return true if message was added, false if the buffer is full
+         */
+        bool        add(int level, int type, const void* data, size_t data_len)
+        {
+            if (used + CMSG_SPACE(data_len) > CAPACITY)
+                return (false);
+
+            cmsghdr* cmsg = reinterpret_cast<cmsghdr*>(storage.bytes + used);
+            std::memset(cmsg, 0, CMSG_SPACE(data_len));
+            cmsg->cmsg_level = level;
+            cmsg->cmsg_type = type;
+            cmsg->cmsg_len = CMSG_LEN(data_len);
+            std::memcpy(CMSG_DATA(cmsg), data, data_len);
+            used += CMSG_SPACE(data_len);
+            return (true);
+        }
+
+        /**
+         * @brief adds a control message of **level** and **type** holding **value**
+         */
+        template<typename _Type>
+        bool        add(int level, int type, const _Type& value)
+        {
+            return (this->add(level, type, &value, sizeof(value)));
+        }
+
+        /**
+         * @brief   sets the source address of the packet to send (IP_PKTINFO, IPV6_PKTINFO)
+         *
+         * @details a server bound to a wildcard address on a multi-homed host replies from the address the request
+         *          was received on, see ancillary_data::destination
+         *
+         * @param source    local address to send from, the port is ignored
+         * @param interface index of the interface to send on, 0 to let the kernel route the packet
+         *
+         * @return true if message was added, false if the buffer is full or the family is not supported
+         */
+        bool        add_source(const socket_address& source, int interface = 0)
+        {
+#if defined(IP_PKTINFO)
+            if (source.family() == AF_INET)
+            {
+                in_pktinfo info;
+                std::memset(&info, 0, sizeof(info));
+                info.ipi_ifindex = interface;
+                info.ipi_spec_dst = source.to<sockaddr_in>()->sin_addr;
+                return (this->add(IPPROTO_IP, IP_PKTINFO, info));
+            }
+#endif
+#if defined(IPV6_PKTINFO)
+            if (source.family() == AF_INET6)
+            {
+                in6_pktinfo info;
+                std::memset(&info, 0, sizeof(info));
+                info.ipi6_ifindex = interface;
+                info.ipi6_addr = source.to<sockaddr_in6>()->sin6_addr;
+                return (this->add(IPPROTO_IPV6, IPV6_PKTINFO, info));
+            }
+#endif
+            (void)source;
+            (void)interface;
+            return (false);
+        }
+
+        /**
+         * @brief sets the type of service (AF_INET) or traffic class (AF_INET6) of the packet to send
+         */
+        bool        add_tos(int tos, sa_family_t family = AF_INET)
+        {
+            if (family == AF_INET6)
+                return (this->add(IPPROTO_IPV6, IPV6_TCLASS, tos));
+            return (this->add(IPPROTO_IP, IP_TOS, tos));
+        }
+
+        /**
+         * @brief sets the time to live (AF_INET) or hop limit (AF_INET6) of the packet to send
+         */
+        bool        add_ttl(int ttl, sa_family_t family = AF_INET)
+        {
+            if (family == AF_INET6)
+                return (this->add(IPPROTO_IPV6, IPV6_HOPLIMIT, ttl));
+            return (this->add(IPPROTO_IP, IP_TTL, ttl));
+        }
+
+        /**
+         * @brief   sets the segment size of the buffer to send with UDP_SEGMENT, see udp::socket_impl::send_segments
+         *
+         * @return true if message was added, false if the buffer is full or UDP_SEGMENT is not supported
+         */
+        bool        add_segment_size(uint16_t segment_size)
+        {
+#if defined(UDP_SEGMENT)
+            return (this->add(SOL_UDP, UDP_SEGMENT, segment_size));
+#else
+            (void)segment_size;
+            return (false);
+#endif
+        }
+
+        /**
+         * @brief   passes **n_fds** file descriptors of **fds** with the message to send (SCM_RIGHTS), AF_UNIX sockets only
+         *
+         * @details the receiver gets duplicates of the file descriptors, see ancillary_data::fds
+         *
+         * @return true if message was added, false if the buffer is full or **n_fds** is 0 or more than MAX_FDS
+         */
+        bool        add_fds(const int* fds, size_t n_fds)
+        {
+            if (n_fds == 0 || n_fds > MAX_FDS)
+                return (false);
+            return (this->add(SOL_SOCKET, SCM_RIGHTS, fds, n_fds * sizeof(int)));
+        }
+
+        /**
+         * @brief sets the control messages of the buffer as ancillary data of **header** for sendmsg
+         */
+        void        attach(msghdr& header) const
+        {
+            header.msg_control = used > 0 ? const_cast<char*>(storage.bytes) : nullptr;
+            header.msg_controllen = used;
+        }
+
+        /**
+         * @brief   sets the whole buffer as ancillary data of **header** for recvmsg
+         *
+         * @details the buffer is cleared, received control messages are read with ancillary_data(header)
+         */
+        void        attach_receive(msghdr& header)
+        {
+            used = 0;
+            header.msg_control = storage.bytes;
+            header.msg_controllen = CAPACITY;
+        }
+
+    private:
+        /**
+         * @brief control messages, aligned as cmsghdr for CMSG_* macros
+         */
+        union
+        {
+            char        bytes[CAPACITY];
+            size_t      align;
+        }   storage;
+
+        /**
+         * @brief size of added control messages
+         */
+        size_t      used = 0;
+};
+
+
+/**
+ * @brief   read-only view on ancillary data received with recvmsg or recvmmsg
+ *
+ * @details the view does not copy control messages, it is only valid as long as the received header and
+ *          its control buffer are, for sockets of the library: until the end of the receive hook.
+ *
+ * @ref raw::socket_impl::get_ancillary
+ */
+class   ancillary_data
+{
+    public:
+        /**
+         * @brief empty view
+         */
+        ancillary_data()
+        {
+            std::memset(&header, 0, sizeof(header));
+        }
+
+        /**
+         * @brief view on ancillary data of **received**, filled by recvmsg or recvmmsg
+         */
+        explicit ancillary_data(const msghdr& received)
+        {
+            std::memset(&header, 0, sizeof(header));
+            header.msg_control = received.msg_control;
+            header.msg_controllen = received.msg_controllen;
+            header.msg_flags = received.msg_flags;
+        }
+
+        /**
+         * @brief returns true if no control message was received
+         */
+        bool        empty() const
+        {
+            return (header.msg_control == nullptr || header.msg_controllen == 0);
+        }
+
+        /**
+         * @brief returns true if control messages were dropped because the control buffer was too small
+         */
+        bool        truncated() const
+        {
+            return (header.msg_flags & MSG_CTRUNC);
+        }
+
+        /**
+         * @brief returns the header holding only the ancillary data, for parsing with CMSG_* macros
+         */
+        const msghdr&   get_header() const
+        {
+            return (header);
+        }
+
+        /**
+         * @brief   finds control message of **level** and **type**
+         *
+         * @return pointer to the control message, nullptr if not found
+         */
+        const cmsghdr*  find(int level, int type) const
+        {
+            if (this->empty())
+                return (nullptr);
+            msghdr* view = const_cast<msghdr*>(&header);
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(view); cmsg != nullptr; cmsg = CMSG_NXTHDR(view, cmsg))
+            {
+                if (cmsg->cmsg_level == level && cmsg->cmsg_type == type)
+                    return (cmsg);
+            }
+            return (nullptr);
+        }
+
+        /**
+         * @brief   copies the data of control message of **level** and **type** in **value**
+         *
+         * @details if the message holds less bytes than **value**, the remaining bytes are set to 0
+         *
+         * @return true if message was found
+         */
+        template<typename _Type>
+        bool        get(int level, int type, _Type& value) const
+        {
+            const cmsghdr* cmsg = this->find(level, type);
+            if (cmsg == nullptr)
+                return (false);
+
+            const size_t data_len = cmsg->cmsg_len - CMSG_LEN(0);
+            std::memset(&value, 0, sizeof(value));
+            std::memcpy(&value, CMSG_DATA(cmsg), std::min(data_len, sizeof(value)));
+            return (true);
+        }
+
+        /**
+         * @brief   reads the destination address and interface of the packet (needs ANCILLARY_PKTINFO)
+         *
+         * @param destination   set to the local address the packet was sent to, port is 0
+         * @param interface     set to the index of the interface the packet was received on
+         *
+         * @return true if packet info was received
+         */
+        bool        destination(socket_address& destination, int& interface) const
+        {
+#if defined(IP_PKTINFO)
+            in_pktinfo  info;
+            if (this->get(IPPROTO_IP, IP_PKTINFO, info))
+            {
+                sockaddr_in address;
+                std::memset(&address, 0, sizeof(address));
+                address.sin_family = AF_INET;
+                address.sin_addr = info.ipi_addr;
+                destination = socket_address(reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+                interface = info.ipi_ifindex;
+                return (true);
+            }
+#endif
+#if defined(IPV6_PKTINFO)
+            in6_pktinfo info6;
+            if (this->get(IPPROTO_IPV6, IPV6_PKTINFO, info6))
+            {
+                sockaddr_in6 address;
+                std::memset(&address, 0, sizeof(address));
+                address.sin6_family = AF_INET6;
+                address.sin6_addr = info6.ipi6_addr;
+                destination = socket_address(reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+                interface = info6.ipi6_ifindex;
+                return (true);
+            }
+#endif
+            (void)destination;
+            (void)interface;
+            return (false);
+        }
+
+        /**
+         * @brief reads the type of service or traffic class of the packet (needs ANCILLARY_TOS)
+         *
+         * @return true if tos was received
+         */
+        bool        tos(int& tos) const
+        {
+            // IP_TOS is received as a single byte, IPV6_TCLASS as an int
+            unsigned char byte = 0;
+            if (this->get(IPPROTO_IP, IP_TOS, byte))
+            {
+                tos = byte;
+                return (true);
+            }
+            return (this->get(IPPROTO_IPV6, IPV6_TCLASS, tos));
+        }
+
+        /**
+         * @brief reads the time to live or hop limit of the packet (needs ANCILLARY_TTL)
+         *
+         * @return true if ttl was received
+         */
+        bool        ttl(int& ttl) const
+        {
+            return (this->get(IPPROTO_IP, IP_TTL, ttl) || this->get(IPPROTO_IPV6, IPV6_HOPLIMIT, ttl));
+        }
+
+        /**
+         * @brief reads the timestamps of the packet (needs unisock::socket::set_timestamping)
+         *
+         * @return true if a timestamp was received
+         */
+        bool        timestamps(packet_timestamps& timestamps) const
+        {
+            return (_lib::parse_timestamps(header, timestamps));
+        }
+
+        /**
+         * @brief   appends the file descriptors passed with the message (SCM_RIGHTS) to **fds**
+         *
+         * @details the received file descriptors are owned by the caller and must be closed,
+         *          file descriptors that did not fit in the control buffer were closed by the kernel (see truncated())
+         *
+         * @return number of file descriptors appended
+         */
+        size_t      fds(std::vector<int>& fds) const
+        {
+            if (this->empty())
+                return (0);
+
+            size_t  n_fds = 0;
+            msghdr* view = const_cast<msghdr*>(&header);
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(view); cmsg != nullptr; cmsg = CMSG_NXTHDR(view, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                    continue ;
+                const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    int fd;
+                    std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+                    fds.push_back(fd);
+                }
+                n_fds += count;
+            }
+            return (n_fds);
+        }
+
+        /**
+         * @brief reads the size of the datagrams coalesced in the packet by UDP_GRO (needs udp::socket_impl::set_gro)
+         *
+         * @return true if segment size was received
+         */
+        bool        segment_size(uint16_t& segment_size) const
+        {
+#if defined(UDP_GRO)
+            int size = 0;
+            if (!this->get(SOL_UDP, UDP_GRO, size) || size <= 0)
+                return (false);
+            segment_size = static_cast<uint16_t>(size);
+            return (true);
+#else
+            (void)segment_size;
+            return (false);
+#endif
+        }
+
+    private:
+        /**
+         * @brief header holding the control buffer of the received message
+         */
+        msghdr      header;
+};
+
+
+/**
+ * @addindex
+ */
+namespace _lib {
+
+/**
+ * @brief   sets the socket options to receive **flags** ancillary data on **socket** of family **family**
+ *
+ * @return true if options were set, false on error with errno set
+ */
+inline bool set_ancillary_options(int socket, sa_family_t family, int flags)
+{
+    struct option { int level; int name; int flag; };
+    const option    options[] = {
+#if defined(IP_PKTINFO)
+        { IPPROTO_IP, IP_PKTINFO, ANCILLARY_PKTINFO },
+#endif
+#if defined(IP_RECVTOS)
+        { IPPROTO_IP, IP_RECVTOS, ANCILLARY_TOS },
+#endif
+#if defined(IP_RECVTTL)
+        { IPPROTO_IP, IP_RECVTTL, ANCILLARY_TTL },
+#endif
+#if defined(IPV6_RECVPKTINFO)
+        { IPPROTO_IPV6, IPV6_RECVPKTINFO, ANCILLARY_PKTINFO },
+#endif
+#if defined(IPV6_RECVTCLASS)
+        { IPPROTO_IPV6, IPV6_RECVTCLASS, ANCILLARY_TOS },
+#endif
+#if defined(IPV6_RECVHOPLIMIT)
+        { IPPROTO_IPV6, IPV6_RECVHOPLIMIT, ANCILLARY_TTL },
+#endif
+    };
+
+    for (const option& current : options)
+    {
+        // IPv4 options are also set on IPv6 sockets, for IPv4 packets received on dual stack sockets
+        if (current.level == IPPROTO_IPV6 && family != AF_INET6)
+            continue ;
+        int enable = (flags & current.flag) ? 1 : 0;
+        if (0 > ::setsockopt(socket, current.level, current.name, &enable, sizeof(enable)))
+        {
+            if (current.level == IPPROTO_IP && family == AF_INET6)
+                continue ;
+            return (false);
+        }
+    }
+    return (true);
+}
+
+/**
+ * @brief   sends **size** bytes of **data** with **n_fds** file descriptors of **fds** on the AF_UNIX **socket**
+ *
+ * @details at least one byte must be sent, the file descriptors are received with the first byte of **data**
+ *
+ * @return the result of sendmsg, -1 with errno EINVAL if **size** is 0 or **n_fds** is more than control_buffer::MAX_FDS
+ */
+inline ssize_t  send_fds(int socket, const int* fds, size_t n_fds, const void* data, size_t size, int flags)
+{
+    control_buffer  control;
+    if (size == 0 || (n_fds > 0 && !control.add_fds(fds, n_fds)))
+    {
+        errno = EINVAL;
+        return (-1);
+    }
+
+    iovec   vector { const_cast<void*>(data), size };
+    msghdr  header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    control.attach(header);
+    return (::sendmsg(socket, &header, flags));
+}
+
+/**
+ * @brief   receives at most **size** bytes in **data** from the AF_UNIX **socket**, appends passed file descriptors to **fds**
+ *
+ * @details received file descriptors are close-on-exec when supported (MSG_CMSG_CLOEXEC),
+ *          **timestamps** is set if not null and timestamps are enabled on **socket**
+ *
+ * @return the result of recvmsg
+ */
+inline ssize_t  recv_fds(int socket, void* data, size_t size, int flags, std::vector<int>& fds, packet_timestamps* timestamps = nullptr)
+{
+    control_buffer  control;
+    iovec           vector { data, size };
+    msghdr          header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    control.attach_receive(header);
+
+#if defined(MSG_CMSG_CLOEXEC)
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    const ssize_t n_bytes = ::recvmsg(socket, &header, flags);
+    if (n_bytes < 0)
+        return (n_bytes);
+
+    const ancillary_data    received { header };
+    received.fds(fds);
+    if (timestamps != nullptr)
+        received.timestamps(*timestamps);
+    return (n_bytes);
+}
+
+} // ******** namespace _lib
+
+} // ******** namespace unisock
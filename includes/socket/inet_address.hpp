@@ -0,0 +1,243 @@
+/**
+ * @file inet_address.hpp
+ * @author ROBINO Luca
+ * @brief  compact IPv4 / IPv6 endpoint (family, address, port) for hash tables and hot paths
+ * @version 1.0
+ * @date 2024-02-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "socket/socket_address.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @brief   IPv4 or IPv6 endpoint stored in 20 bytes instead of the 128 bytes of socket_address
+ *
+ * @details holds the family, the 16 bytes of the address (IPv4 addresses use the first 4 bytes) and the port
+ *          in network byte order, it is trivially copyable and can key hash tables (see std::hash<inet_address>).\n
+ *          addresses of other families only keep their family, they all compare equal.\n
+ *          it is only used as the key of udp::session_table: the receive paths (RECEIVE, RECVFROM, recv_batch)
+ *          and tcp accept still fill a socket_address, since their hooks are public and may carry
+ *          AF_UNIX or AF_PACKET addresses that inet_address cannot hold.
+ *
+ * @ref udp::session_table
+ */
+class   inet_address
+{
+    public:
+        /**
+         * @brief creates an empty address of family AF_UNSPEC
+         */
+        inet_address()
+        : _bytes {}, _port(0), _family(AF_UNSPEC)
+        {}
+
+        /**
+         * @brief   creates the endpoint of **address**
+         *
+         * @param address   sockaddr_in or sockaddr_in6, other families only keep their family
+         */
+        explicit inet_address(const sockaddr* address)
+        : inet_address()
+        {
+            _family = address->sa_family;
+            if (_family == AF_INET)
+            {
+                const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(address);
+                std::memcpy(_bytes, &in->sin_addr, sizeof(in->sin_addr));
+                _port = in->sin_port;
+            }
+            else if (_family == AF_INET6)
+            {
+                const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(address);
+                std::memcpy(_bytes, &in6->sin6_addr, sizeof(in6->sin6_addr));
+                _port = in6->sin6_port;
+            }
+        }
+
+        /**
+         * @brief creates the endpoint of **address**, see inet_address(const sockaddr*)
+         */
+        explicit inet_address(const socket_address& address)
+        : inet_address(address.to<sockaddr>())
+        {}
+
+        /**
+         * @brief   writes the endpoint to **storage** as a sockaddr_in or sockaddr_in6
+         *
+         * @return size of the written address, 0 if the family is not AF_INET or AF_INET6
+         */
+        socklen_t       to_sockaddr(sockaddr_storage& storage) const
+        {
+            std::memset(&storage, 0, sizeof(sockaddr_in6));
+            if (_family == AF_INET)
+            {
+                sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&storage);
+#if defined(SIN6_LEN)
+                in->sin_len = sizeof(sockaddr_in);
+#endif
+                in->sin_family = AF_INET;
+                in->sin_port = _port;
+                std::memcpy(&in->sin_addr, _bytes, sizeof(in->sin_addr));
+                return (sizeof(sockaddr_in));
+            }
+            if (_family == AF_INET6)
+            {
+                sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(&storage);
+#if defined(SIN6_LEN)
+                in6->sin6_len = sizeof(sockaddr_in6);
+#endif
+                in6->sin6_family = AF_INET6;
+                in6->sin6_port = _port;
+                std::memcpy(&in6->sin6_addr, _bytes, sizeof(in6->sin6_addr));
+                return (sizeof(sockaddr_in6));
+            }
+            return (0);
+        }
+
+        /**
+         * @brief returns the endpoint as a socket_address, empty if the family is not AF_INET or AF_INET6
+         */
+        socket_address  to_socket_address() const
+        {
+            sockaddr_storage    storage;
+            const socklen_t     size = this->to_sockaddr(storage);
+            if (size == 0)
+                return (socket_address {});
+            return (socket_address { reinterpret_cast<const sockaddr*>(&storage), size });
+        }
+
+        /**
+         * @brief   writes the endpoint as "ip:port", or "[ip]:port" for IPv6, without allocation nor lookup
+         *
+         * @param buffer        buffer of at least socket_address::FORMAT_BUFFER_SIZE bytes
+         * @param buffer_size   size of **buffer**
+         *
+         * @return length of the null terminated string, 0 if the family is not AF_INET or AF_INET6 or **buffer** is too small
+         */
+        size_t          format(char* buffer, size_t buffer_size) const
+        {
+            sockaddr_storage storage;
+            if (0 == this->to_sockaddr(storage))
+            {
+                if (buffer_size > 0)
+                    buffer[0] = '\0';
+                return (0);
+            }
+            return (socket_address::format(reinterpret_cast<const sockaddr*>(&storage), buffer, buffer_size));
+        }
+
+        /**
+         * @brief returns the family of the address
+         */
+        sa_family_t     family() const
+        {
+            return (static_cast<sa_family_t>(_family));
+        }
+
+        /**
+         * @brief returns the port in host byte order
+         */
+        uint16_t        port() const
+        {
+            return (ntohs(_port));
+        }
+
+        /**
+         * @brief returns the 16 bytes of the address, IPv4 addresses use the first 4 bytes
+         */
+        const uint8_t*  bytes() const
+        {
+            return (_bytes);
+        }
+
+        /**
+         * @brief returns a hash of the family, address and port
+         */
+        size_t          hash() const
+        {
+            uint64_t    high;
+            uint64_t    low;
+
+            std::memcpy(&high, _bytes, sizeof(high));
+            std::memcpy(&low, _bytes + sizeof(high), sizeof(low));
+            return (mix(high ^ mix(low ^ (static_cast<uint64_t>(_port) << 32) ^ (static_cast<uint64_t>(_family) << 48))));
+        }
+
+        /**
+         * @brief returns true if both endpoints have the same family, address and port
+         */
+        bool            operator==(const inet_address& other) const
+        {
+            return (0 == std::memcmp(this, &other, sizeof(inet_address)));
+        }
+
+        /**
+         * @brief opposite of operator==
+         */
+        bool            operator!=(const inet_address& other) const
+        {
+            return (!(*this == other));
+        }
+
+    private:
+        /**
+         * @brief mixes the bits of **key** (splitmix64 finalizer)
+         */
+        static uint64_t mix(uint64_t key)
+        {
+            key ^= key >> 30;
+            key *= 0xbf58476d1ce4e5b9ULL;
+            key ^= key >> 27;
+            key *= 0x94d049bb133111ebULL;
+            key ^= key >> 31;
+            return (key);
+        }
+
+        /**
+         * @brief address bytes in network byte order, zero padded for IPv4
+         */
+        uint8_t     _bytes[16];
+
+        /**
+         * @brief port in network byte order
+         */
+        in_port_t   _port;
+
+        /**
+         * @brief address family, 16 bits on every platform so that the object has no padding
+         */
+        uint16_t    _family;
+};
+
+static_assert(sizeof(inet_address) == 20, "inet_address must not contain padding, operator== compares its bytes");
+
+} // ******** namespace unisock
+
+
+namespace std {
+
+/**
+ * @brief std::hash specialization so that unisock::inet_address can key std::unordered_map
+ */
+template<>
+struct hash<unisock::inet_address>
+{
+    size_t  operator()(const unisock::inet_address& address) const
+    {
+        return (address.hash());
+    }
+};
+
+} // ******** namespace std
@@ -0,0 +1,422 @@
+/**
+ * @file resolver.hpp
+ * @author ROBINO Luca
+ * @brief  asynchronous hostname resolution on a thread pool, completed into an events::handler
+ * @version 1.0
+ * @date 2024-02-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "socket/socket.hpp"
+#include "socket/socket_address.hpp"
+#include "events/events.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @brief   resolves hostnames on helper threads and calls back the results from events::poll
+ *
+ * @details socket_address::addrinfo blocks in getaddrinfo, for seconds when resolvers are slow, which freezes
+ *          every socket of the handler. the resolver runs lookups on its own threads and wakes the handler through
+ *          a socket pair, callbacks are then called by events::poll on the thread polling the handler, like hooks.\n
+ *          the wake socket is only added to the handler while lookups are pending, so that events::poll
+ *          still returns false once the handler has nothing left to do.\n
+ *          threads are detached, destroying the resolver does not wait for lookups running in getaddrinfo:
+ *          their results are dropped and each thread exits once its lookup returns.
+ *
+ * @code
+ *  unisock::resolver resolver { handler };
+ *  resolver.resolve("example.com", AF_INET, [](addrinfo_result result, const socket_address& address, int gai_error){ ... });
+ *  while (events::poll(handler))
+ *      ;
+ * @endcode
+ *
+ * @ref tcp::client_impl::async_connect
+ * @ref tcp::client_impl::connect_any
+ * @ref tcp::server_impl::async_listen
+ * @ref udp::socket_impl::async_bind
+ */
+class   resolver
+{
+    public:
+        /**
+         * @brief   callback of a lookup, called from events::poll
+         *
+         * @details **result** is addrinfo_result::SUCCESS if **address** was resolved, **gai_error** is the getaddrinfo
+         *          error code (EAI_*) of the lookup, 0 on success, and errno is set to the errno of the lookup
+         */
+        using callback_type = std::function<void (addrinfo_result result, const socket_address& address, int gai_error)>;
+
+        /**
+         * @brief   function resolving a hostname, called from the resolver threads
+         *
+         * @details defaults to socket_address::addrinfo, can be replaced by a stub to test callers without a DNS server.
+         *          failures of a stub are reported with EAI_SYSTEM if it set errno, EAI_FAIL otherwise
+         */
+        using lookup_function = std::function<addrinfo_result (socket_address& address, const std::string& hostname, sa_family_t family)>;
+
+        /**
+         * @brief   callback of resolve_all(), called from events::poll
+         *
+         * @details **result** is addrinfo_result::SUCCESS if **addresses** holds at least an address, **gai_error** is the
+         *          getaddrinfo error code (EAI_*) of the lookup, 0 on success, and errno is set to the errno of the lookup
+         */
+        using callback_all_type = std::function<void (addrinfo_result result, const std::vector<socket_address>& addresses, int gai_error)>;
+
+        /**
+         * @brief default number of resolver threads
+         */
+        static constexpr size_t DEFAULT_THREADS = 2;
+
+        /**
+         * @brief   creates a resolver completing lookups into **handler**
+         *
+         * @param handler   handler polled by the thread that receives the callbacks
+         * @param n_threads number of lookups run concurrently
+         * @param lookup    function resolving a hostname, socket_address::addrinfo by default
+         *
+         * @throw std::system_error if the wake socket pair or the threads could not be created
+         */
+        explicit resolver(std::shared_ptr<events::handler> handler, size_t n_threads = DEFAULT_THREADS, lookup_function lookup = nullptr)
+        : resolver(handler, n_threads, lookup, resolver::open_wake_pair())
+        {}
+
+        resolver(const resolver& copy) = delete;
+
+        /**
+         * @brief   stops the threads, lookups not completed yet are dropped without calling their callback
+         *
+         * @details does not wait for lookups already running, threads drop their result and exit once getaddrinfo returns
+         *
+         * @note    must not be called from a callback of this resolver
+         */
+        ~resolver()
+        {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->stopping = true;
+                state->requests.clear();
+                state->completions.clear();
+            }
+            state->condition.notify_all();
+
+            if (n_pending > 0)
+                handler->delete_socket(wake.get_socket());
+            wake.socket_base::close();
+        }
+
+        /**
+         * @brief   resolves **hostname** to an address of **family** on a resolver thread
+         *
+         * @details **callback** is called from events::poll on the handler of the resolver once the lookup is done
+         *
+         * @param hostname  hostname to resolve or numeric address
+         * @param family    expected address family
+         * @param callback  called with the result of the lookup
+         */
+        void    resolve(const std::string& hostname, sa_family_t family, callback_type callback)
+        {
+            std::unique_ptr<request> lookup_request(new request);
+            lookup_request->hostname = hostname;
+            lookup_request->family = family;
+            lookup_request->callback = std::move(callback);
+            this->queue(std::move(lookup_request));
+        }
+
+        /**
+         * @brief   resolves all addresses of **hostname** of **family** on a resolver thread, see socket_address::addrinfo_all
+         *
+         * @details **callback** is called from events::poll on the handler of the resolver once the lookup is done.
+         *          when the resolver was created with a lookup function, it is used and resolves a single address
+         *
+         * @param hostname  hostname to resolve or numeric address
+         * @param family    expected address family, AF_UNSPEC for both IPv4 and IPv6
+         * @param callback  called with the result of the lookup
+         */
+        void    resolve_all(const std::string& hostname, sa_family_t family, callback_all_type callback)
+        {
+            std::unique_ptr<request> lookup_request(new request);
+            lookup_request->hostname = hostname;
+            lookup_request->family = family;
+            lookup_request->callback_all = std::move(callback);
+            this->queue(std::move(lookup_request));
+        }
+
+        /**
+         * @brief returns the number of lookups whose callback was not called yet
+         */
+        size_t  pending() const
+        {
+            return (n_pending);
+        }
+
+    private:
+        /**
+         * @brief socket type of the wake socket, only used to be polled by the handler
+         */
+        using wake_socket = unisock::socket<events::actions_list<>, entity_model<>>;
+
+        /**
+         * @brief lookup queued to the threads, then completed to the handler
+         */
+        struct  request
+        {
+            std::string                 hostname;
+            sa_family_t                 family = AF_UNSPEC;
+            callback_type               callback;
+            callback_all_type           callback_all;
+            addrinfo_result             result = addrinfo_result::ERROR;
+            socket_address              address;
+            std::vector<socket_address> addresses;
+            int                         error = 0;
+            int                         gai_error = 0;
+        };
+
+        /**
+         * @brief   state shared by the resolver and its threads
+         *
+         * @details threads keep it alive after the resolver is destroyed, until their running lookup returns,
+         *          the write end of the wake socket pair is closed with it
+         */
+        struct  shared_state
+        {
+            /**
+             * @brief function resolving a hostname to one address, sets its gai_error argument
+             */
+            std::function<addrinfo_result (socket_address&, const std::string&, sa_family_t, int&)>                lookup;
+
+            /**
+             * @brief function resolving all addresses of a hostname, for resolve_all(), sets its gai_error argument
+             */
+            std::function<addrinfo_result (std::vector<socket_address>&, const std::string&, sa_family_t, int&)>   lookup_all;
+
+            /**
+             * @brief write end of the socket pair, written by threads when lookups complete
+             */
+            int                                     wake_writer = -1;
+
+            /**
+             * @brief protects requests, completions and stopping
+             */
+            std::mutex                              mutex;
+
+            /**
+             * @brief wakes threads when a request is queued or when the resolver is destroyed
+             */
+            std::condition_variable                 condition;
+
+            /**
+             * @brief lookups waiting for a thread
+             */
+            std::deque<std::unique_ptr<request>>    requests;
+
+            /**
+             * @brief lookups done, waiting for their callback
+             */
+            std::deque<std::unique_ptr<request>>    completions;
+
+            /**
+             * @brief set by the destructor of the resolver, threads exit and drop their result
+             */
+            bool                                    stopping = false;
+
+            ~shared_state()
+            {
+                if (wake_writer >= 0)
+                    ::close(wake_writer);
+            }
+        };
+
+        /**
+         * @brief queues **lookup_request** to the threads
+         */
+        void    queue(std::unique_ptr<request> lookup_request)
+        {
+            // the wake socket is polled while callbacks are expected
+            if (n_pending++ == 0)
+                handler->add_socket(wake.get_socket(), &wake);
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->requests.push_back(std::move(lookup_request));
+            }
+            state->condition.notify_one();
+        }
+
+        /**
+         * @brief creates the resolver on the wake socket pair **wake_pair**, see public constructor
+         */
+        resolver(std::shared_ptr<events::handler> handler, size_t n_threads, lookup_function lookup, std::pair<int, int> wake_pair)
+        : handler(handler), wake(handler, wake_pair.first), state(std::make_shared<shared_state>())
+        {
+            state->wake_writer = wake_pair.second;
+            if (!lookup)
+            {
+                state->lookup = [](socket_address& address, const std::string& hostname, sa_family_t family, int& gai_error){
+                    std::vector<socket_address> addresses;
+                    addrinfo_result result = socket_address::addrinfo_all(addresses, hostname, family, &gai_error);
+                    if (result == addrinfo_result::SUCCESS)
+                        address = addresses.front();
+                    return (result);
+                };
+                state->lookup_all = [](std::vector<socket_address>& addresses, const std::string& hostname, sa_family_t family, int& gai_error){
+                    return (socket_address::addrinfo_all(addresses, hostname, family, &gai_error));
+                };
+            }
+            else
+            {
+                state->lookup = [lookup](socket_address& address, const std::string& hostname, sa_family_t family, int& gai_error){
+                    errno = 0;
+                    addrinfo_result result = lookup(address, hostname, family);
+                    gai_error = (result == addrinfo_result::SUCCESS ? 0 : (errno != 0 ? EAI_SYSTEM : EAI_FAIL));
+                    return (result);
+                };
+                // a custom lookup resolves a single address
+                state->lookup_all = [lookup = state->lookup](std::vector<socket_address>& addresses, const std::string& hostname, sa_family_t family, int& gai_error){
+                    socket_address  address;
+                    addrinfo_result result = lookup(address, hostname, family, gai_error);
+                    if (result == addrinfo_result::SUCCESS)
+                        addresses.push_back(address);
+                    return (result);
+                };
+            }
+            wake.set_dispatch(&resolver::dispatch_completions, &socket_base::dispatch_writeable, this);
+
+            // threads only use the shared state, they are never joined (see ~resolver)
+            for (size_t index = 0; index < std::max<size_t>(n_threads, 1); ++index)
+                std::thread([state = this->state](){ resolver::run(state); }).detach();
+        }
+
+        /**
+         * @brief   creates the non blocking socket pair used to wake the handler
+         *
+         * @throw std::system_error if socketpair fails
+         */
+        static std::pair<int, int>  open_wake_pair()
+        {
+            int pair[2];
+            if (0 > ::socketpair(AF_UNIX, SOCK_STREAM, 0, pair))
+                throw std::system_error(errno, std::generic_category(), "socketpair");
+            for (int fd : pair)
+            {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            return (std::make_pair(pair[0], pair[1]));
+        }
+
+        /**
+         * @brief   loop of resolver threads, runs lookups until the resolver is destroyed
+         *
+         * @param state state shared with the resolver, kept alive by the thread
+         */
+        static void run(std::shared_ptr<shared_state> state)
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            while (true)
+            {
+                state->condition.wait(lock, [&state](){ return (state->stopping || !state->requests.empty()); });
+                if (state->stopping)
+                    return ;
+
+                std::unique_ptr<request> lookup_request = std::move(state->requests.front());
+                state->requests.pop_front();
+                lock.unlock();
+
+                errno = 0;
+                if (lookup_request->callback_all)
+                    lookup_request->result = state->lookup_all(lookup_request->addresses, lookup_request->hostname,
+                                                                lookup_request->family, lookup_request->gai_error);
+                else
+                    lookup_request->result = state->lookup(lookup_request->address, lookup_request->hostname,
+                                                            lookup_request->family, lookup_request->gai_error);
+                lookup_request->error = errno;
+
+                lock.lock();
+                // the resolver was destroyed during the lookup, nobody waits for the result
+                if (state->stopping)
+                    return ;
+                const bool was_empty = state->completions.empty();
+                state->completions.push_back(std::move(lookup_request));
+                // one byte wakes the handler for all completions queued until it drains them
+                if (was_empty)
+                {
+                    const char byte = 0;
+                    (void)::write(state->wake_writer, &byte, sizeof(byte));
+                }
+            }
+        }
+
+        /**
+         * @brief   calls back completed lookups, readable dispatch of the wake socket
+         *
+         * @param socket    the wake socket
+         * @param context   the resolver
+         */
+        static void dispatch_completions(socket_base* socket, void* context)
+        {
+            resolver*   self = static_cast<resolver*>(context);
+            char        bytes[64];
+
+            while (::read(socket->get_socket(), bytes, sizeof(bytes)) > 0)
+                ;
+
+            std::deque<std::unique_ptr<request>> completed;
+            {
+                std::lock_guard<std::mutex> lock(self->state->mutex);
+                completed.swap(self->state->completions);
+            }
+
+            self->n_pending -= completed.size();
+            if (self->n_pending == 0)
+                self->handler->delete_socket(self->wake.get_socket());
+
+            for (std::unique_ptr<request>& completed_request : completed)
+            {
+                errno = completed_request->error;
+                if (completed_request->callback_all)
+                    completed_request->callback_all(completed_request->result, completed_request->addresses, completed_request->gai_error);
+                else
+                    completed_request->callback(completed_request->result, completed_request->address, completed_request->gai_error);
+            }
+        }
+
+        /**
+         * @brief handler receiving the callbacks
+         */
+        std::shared_ptr<events::handler>        handler;
+
+        /**
+         * @brief read end of the socket pair, added to the handler while lookups are pending
+         */
+        wake_socket                             wake;
+
+        /**
+         * @brief state shared with the threads
+         */
+        std::shared_ptr<shared_state>           state;
+
+        /**
+         * @brief lookups whose callback was not called yet, only used by the thread polling the handler
+         */
+        size_t                                  n_pending = 0;
+};
+
+} // ******** namespace unisock
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "socket/socket_base.hpp"
+#include "socket/timestamping.hpp"
 #include "events/action_hanlder.hpp"
 #include "events/pollable_entity.hpp"
 
@@ -113,6 +114,22 @@ namespace basic_actions
         static constexpr const char* action_name = "ERROR";
         static constexpr const char* callback_prototype = "void (const std::string&, int)";
     };
+
+
+
+    /**
+     * @brief   timestamps of a sent packet were read from the error queue
+     * 
+     * @details called by recv_errqueue() for each timestamp when TX timestamps are enabled (see unisock::socket::set_timestamping),
+     *          the sent packet is identified by packet_timestamps::key
+     * 
+     * @note    hook prototype: ```void  (const packet_timestamps& timestamps)```
+     */
+    struct  TX_TIMESTAMP
+    {
+        static constexpr const char* action_name = "TX_TIMESTAMP";
+        static constexpr const char* callback_prototype = "void (const packet_timestamps&)";
+    };
 };
 
 
@@ -127,6 +144,7 @@ using basic_actions_list = std::tuple<
     events::action<basic_actions::WRITEABLE, std::function< void (void) > >,
     events::action<basic_actions::CLOSED, std::function< void (void) > >,
     events::action<basic_actions::ERROR, std::function< void (const std::string&, int) > >,
+    events::action<basic_actions::TX_TIMESTAMP, std::function< void (const packet_timestamps&) > >,
     _Actions...
 >;
 
@@ -260,6 +278,100 @@ class socket<
             return (true);
         }
 
+        /**
+         * @brief   enables kernel or hardware timestamps of received and sent packets
+         * 
+         * @details receive timestamps are read from ancillary data by the receive functions of the socket
+         *          (recvfrom, recvmsg, recvmmsg, recv), and can be read with get_timestamps() in RECEIVE / RECVFROM / RECV hooks.\n
+         *          send timestamps are queued by the kernel on the error queue of the socket, they are read by recv_errqueue(),
+         *          called by the receive functions, and reported with basic_actions::TX_TIMESTAMP.\n
+         *          TIMESTAMP_RX_SOFTWARE alone uses SO_TIMESTAMPNS, other flags use SO_TIMESTAMPING.
+         * 
+         * @note    the socket must be opened, hardware timestamps need the network card to be configured with SIOCSHWTSTAMP,
+         *          timestamps are only available on Linux
+         * 
+         * @param flags timestamp_flag combined with bitwise or, TIMESTAMP_NONE disables timestamps
+         * 
+         * @return true if timestamps were set, false on error, ERROR hook is called with errno of error
+         */
+        bool    set_timestamping(int flags)
+        {
+#if defined(__linux__)
+            int enable = (flags == TIMESTAMP_RX_SOFTWARE ? 1 : 0);
+            int options = (flags == TIMESTAMP_RX_SOFTWARE ? 0 : _lib::timestamping_options(flags));
+            if (!this->setsockopt(SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable))
+                || !this->setsockopt(SOL_SOCKET, SO_TIMESTAMPING, &options, sizeof(options)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            this->timestamping = flags;
+            return (true);
+#else
+            if (flags == TIMESTAMP_NONE)
+                return (true);
+            this->template execute<basic_actions::ERROR>("setsockopt", ENOPROTOOPT);
+            return (false);
+#endif
+        }
+
+        /**
+         * @brief returns timestamp_flag enabled with set_timestamping
+         */
+        int     get_timestamping() const
+        {
+            return (this->timestamping);
+        }
+
+        /**
+         * @brief returns the timestamps of the last received packet, only valid while a receive hook is executed
+         */
+        const packet_timestamps&    get_timestamps() const
+        {
+            return (this->timestamps);
+        }
+
+        /**
+         * @brief   reads send timestamps queued on the error queue of the socket, calls TX_TIMESTAMP for each of them
+         * 
+         * @details the error queue makes the socket readable (POLLERR), receive functions call recv_errqueue() before receiving
+         *          when TX timestamps are enabled, so that it does not need to be called by the user.
+         * 
+         * @return true if all timestamps were read, false on error (ERROR hook is called) or if the socket was deleted by a hook
+         */
+        bool    recv_errqueue()
+        {
+#if defined(__linux__)
+            std::shared_ptr<events::handler> handler = this->handler;
+            const int   socket = this->get_socket();
+            char        buffer[64];
+
+            while (true)
+            {
+                packet_timestamps   sent;
+                ssize_t n_bytes = _lib::recv_timestamped(socket, buffer, sizeof(buffer), MSG_ERRQUEUE | MSG_DONTWAIT,
+                                                            nullptr, nullptr, sent);
+                if (n_bytes < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        return (true);
+                    this->template execute<basic_actions::ERROR>("recvmsg", errno);
+                    return (false);
+                }
+                if (sent.empty())
+                    continue ;
+
+                ushort handler_ref = handler->get_ref();
+                this->template execute<basic_actions::TX_TIMESTAMP>(sent);
+                // a socket was added or deleted by the hook, this socket may not exist anymore
+                if (handler->ref_has_changed(handler_ref))
+                    return (false);
+            }
+#else
+            return (true);
+#endif
+        }
+
         /**
          * @brief set/unset write flag for socket that will be evaluated on events::poll
          * 
@@ -280,6 +392,30 @@ class socket<
             this->handler->socket_want_read(get_socket(), want_read);
         }
 
+        /**
+         * @brief   sets the direct dispatch called by events::poll for this socket
+         *
+         * @details events::poll will call **readable** and **writeable** with this socket and **context** instead of
+         *          on_readable() / on_writeable(), which lets a socket route readiness events to its concrete path
+         *          (recv(), accept(), ...) without a virtual call and without walking the std::function list of the action.\n
+         *          if a hook is later added on basic_actions::READABLE or basic_actions::WRITEABLE with on(), the corresponding
+         *          entry is reset to the default dispatch, so that every hook of the action is executed again.
+         *
+         * @note    the direct dispatch should do the same work as the hooks that were set on basic_actions::READABLE / WRITEABLE
+         *
+         * @param readable  function called when socket is readable
+         * @param writeable function called when socket is writeable
+         * @param context   pointer passed back to **readable** and **writeable**
+         *
+         * @ref socket_base::dispatch_table
+         */
+        void    set_dispatch(dispatch_function readable, dispatch_function writeable, void* context = nullptr)
+        {
+            this->_dispatch = dispatch_table { readable, writeable, context };
+            if (get_socket() >= 0)
+                this->handler->socket_set_dispatch(get_socket(), this->_dispatch);
+        }
+
         /**
          * @brief   called by events::poll when socket is readable
          */
@@ -297,6 +433,37 @@ class socket<
         }
 
 
+    protected:
+        /**
+         * @brief   resets the direct dispatch of the event when basic_actions::READABLE or basic_actions::WRITEABLE is hooked
+         *
+         * @details called by events::action_handler::on, so that the reset also happens when the hook is added
+         *          through an events::action_handler reference (see set_dispatch)
+         *
+         * @param action    type of the tag of the hooked action
+         */
+        void    action_hooked(const std::type_info& action) override
+        {
+            if (action == typeid(basic_actions::READABLE)
+                && this->_dispatch.readable != &socket_base::dispatch_readable)
+                set_dispatch(&socket_base::dispatch_readable, this->_dispatch.writeable, this->_dispatch.context);
+
+            if (action == typeid(basic_actions::WRITEABLE)
+                && this->_dispatch.writeable != &socket_base::dispatch_writeable)
+                set_dispatch(this->_dispatch.readable, &socket_base::dispatch_writeable, this->_dispatch.context);
+        }
+
+        /**
+         * @brief timestamp_flag enabled on the socket (see set_timestamping)
+         */
+        int                 timestamping = TIMESTAMP_NONE;
+
+        /**
+         * @brief timestamps of the last received packet
+         */
+        packet_timestamps   timestamps;
+
+    public:
         /**
          * @brief data class for socket
          * @details merge all types of Data parameter pack by inheriting them publicly
@@ -20,8 +20,10 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <string>
+#include <vector>
 #include <iostream>
 
 /**
@@ -110,6 +112,13 @@ class socket_address
          */
         static constexpr size_t IP_ADDRESS_BUFFER_SIZE = 128;
 
+        /**
+         * @brief   buffer size enough for any address formatted by socket_address::format
+         * 
+         * @details longest IPv6 address with brackets, colon, port and null terminator
+         */
+        static constexpr size_t FORMAT_BUFFER_SIZE = 64;
+
         /**
          * @brief maximum size for getnameinfo buffer for retrieving host name
          * 
@@ -189,11 +198,24 @@ class socket_address
         socket_address&   operator=(const socket_address& other);
 
         /**
-         * @brief returns the size of the address
+         * @brief   returns the size of the address, passed to bind, connect, sendto...
+         * 
+         * @details the size is stored with the address, so that variable length addresses (like abstract AF_UNIX names)
+         *          keep their exact length on every platform. addresses written through to<sockaddr>() without set_size()
+         *          use the size of their family struct (pathnames for AF_UNIX).
          * 
-         * @return size_t   value pointed by sa_len when reinterpreted as sockaddr
+         * @return size_t   size of the address struct
          */
         size_t              size() const;
+
+        /**
+         * @brief   sets the size of the address, after its struct was written through to<sockaddr>()
+         * 
+         * @details to call with the length returned by recvfrom, accept, getsockname... 0 restores the size of the family struct
+         * 
+         * @param size  size of the address struct, at most ADDRESS_STORAGE_SIZE
+         */
+        void                set_size(size_t size);
  
         /**
          * @brief returns the familly of the address
@@ -202,6 +224,41 @@ class socket_address
          */
         sa_family_t         family() const;
 
+        /**
+         * @brief returns the port of the address in host byte order
+         * 
+         * @return uint16_t port for AF_INET and AF_INET6, 0 for other families
+         */
+        uint16_t            port() const;
+
+        /**
+         * @brief   returns a hash of the address
+         * 
+         * @details only the family, ip address and port are hashed for AF_INET and AF_INET6,
+         *          so that two addresses that compare equal with operator== have the same hash
+         * 
+         * @return size_t hash of the address
+         */
+        size_t              hash() const;
+
+        /**
+         * @brief   compares family, ip address and port of two addresses
+         * 
+         * @note    other families compare the whole address of size()
+         * 
+         * @param other address to compare with
+         * @return true if both addresses designate the same endpoint
+         */
+        bool                operator==(const socket_address& other) const;
+
+        /**
+         * @brief   opposite of operator==
+         * 
+         * @param other address to compare with
+         * @return true if addresses designate different endpoints
+         */
+        bool                operator!=(const socket_address& other) const;
+
 
 
         /**
@@ -215,19 +272,7 @@ class socket_address
                 using type = sockaddr;
             };
 
-        /**
-         * @brief specialization of address_type_of for AF_INET
-         */
-        template<>
-        struct address_type_of<AF_INET>
-            { using type = sockaddr_in; };
-
-        /**
-         * @brief specialization of address_type_of for AF_INET6
-         */        template<>
-        struct address_type_of<AF_INET6>
-            { using type = sockaddr_in6; };
-
+        // specializations are defined after the class (explicit specializations must be at namespace scope)
         // TODO: implement more sockaddr structs
 
         /**
@@ -253,30 +298,7 @@ class socket_address
                 static constexpr sa_family_t value = AF_UNSPEC;
             };
 
-        /**
-         * @brief specialization of address_family_of for sockaddr_in
-         */
-        template<>
-        struct address_family_of<sockaddr_in>
-            {
-                /**
-                 * @brief value of AF_INET
-                 */
-                static constexpr sa_family_t value = AF_INET; 
-            };
-
-        /**
-         * @brief specialization of address_family_of for sockaddr_in6
-         */ 
-        template<>
-        struct address_family_of<sockaddr_in6>
-            {
-                /**
-                 * @brief value of AF_INET
-                 */
-                static constexpr sa_family_t value = AF_INET6;
-            };
-
+        // specializations are defined after the class (explicit specializations must be at namespace scope)
         // TODO: implement more sockaddr structs
 
         /**
@@ -331,42 +353,6 @@ class socket_address
             return (reinterpret_cast<const _AddressType*>(&_address));
         }
 
-        /**
-         * @brief   specialization for _AddressType=struct sockaddr
-         * 
-         * @details deletes the check for family, even if addr is all zeroed or incoherent,
-         *          getnameinfo should return an appropriate error,
-         *          it also applies to other callers like callers like bind, recvfrom, sendto, etc...
-         * 
-         * @tparam  _AddressType type of address struct to reinterpret to
-         * 
-         * @note    since all addresses families can be represented as sockaddr, this call never returns nullptr
-         * 
-         * @return  a reinterpreted pointer of type struct sockaddr
-         */
-        template<>
-        struct sockaddr*        to<struct sockaddr>()
-        {
-            return (reinterpret_cast<struct sockaddr*>(&_address));
-        }
-
-        /**
-         * @brief   specialization for _AddressType=struct sockaddr
-         * 
-         * @details deletes the check for family, even if addr is all zeroed or incoherent,
-         *          getnameinfo should return an appropriate error,
-         *          it also applies to other callers like callers like bind, recvfrom, sendto, etc...
-         * 
-         * @tparam  _AddressType type of address struct to reinterpret to
-         * 
-         * @note    since all addresses families can be represented as sockaddr, this call never returns nullptr
-         * 
-         * @return  a reinterpreted pointer of type struct sockaddr
-         */        template<>
-        const struct sockaddr*  to<struct sockaddr>() const
-        {
-            return (reinterpret_cast<const struct sockaddr*>(&_address));
-        }
 
 
 
@@ -376,7 +362,7 @@ class socket_address
          * 
          * @note        this call will throw is not used on IPv4/IPv6 addresses
          * 
-         * @details     uses inet_ntop to parse the ip string from the address struct, may fail if buffer size is too small
+         * @details     uses inet_ntop to parse the ip string from the address struct, see format_ip to avoid the allocation of the string
          * 
          * @param address   socket_address to retrieve ip from
          * 
@@ -390,12 +376,48 @@ class socket_address
 
 
      
+        /**
+         * @brief       writes the numeric ip of the address to **buffer**, without allocation nor lookup
+         * 
+         * @param buffer        buffer of at least INET6_ADDRSTRLEN bytes (see FORMAT_BUFFER_SIZE)
+         * @param buffer_size   size of **buffer**
+         * 
+         * @return length of the null terminated ip, 0 if the address is not IPv4/IPv6 or **buffer** is too small
+         */
+        size_t              format_ip(char* buffer, size_t buffer_size) const;
+
+        /**
+         * @brief       writes the address as "ip:port", or "[ip]:port" for IPv6, to **buffer**, without allocation nor lookup
+         * 
+         * @details     AF_UNIX addresses are written as their path, or "@name" for abstract addresses,
+         *              unnamed AF_UNIX addresses (like accepted clients) are written as an empty string
+         * 
+         * @param buffer        buffer of at least FORMAT_BUFFER_SIZE bytes, or sizeof(sockaddr_un::sun_path) + 1 bytes for AF_UNIX paths
+         * @param buffer_size   size of **buffer**
+         * 
+         * @return length of the null terminated string, 0 if the address is not IPv4/IPv6/AF_UNIX or **buffer** is too small
+         */
+        size_t              format(char* buffer, size_t buffer_size) const;
+
+        /**
+         * @brief       same as format(char*, size_t), for an address struct that is not in a socket_address
+         * 
+         * @param address       IPv4, IPv6 or AF_UNIX address struct
+         * @param buffer        buffer of at least FORMAT_BUFFER_SIZE bytes
+         * @param buffer_size   size of **buffer**
+         * 
+         * @return length of the null terminated string, 0 if **address** is not IPv4/IPv6/AF_UNIX or **buffer** is too small
+         */
+        static size_t       format(const sockaddr* address, char* buffer, size_t buffer_size);
+
+
         /**
          * @brief       retrieves the address depending on **hostname** and **family**
          * 
          * @details     uses getaddrinfo to retrieve address informations of **hostname** with **family**,
          *              on success, the retrieved address structure is written to the storage referenced by **address** \n 
-         *              this call might fail for many reasons that are described in addrinfo_result.
+         *              this call might fail for many reasons that are described in addrinfo_result.\n
+         *              resolutions are cached in address_cache::instance(), see socket_address::addrinfo_all
          * 
          * @param address   sockaddr_storage reference to write retrieved address to
          * @param hostname  hostname to be resolved
@@ -420,6 +442,70 @@ class socket_address
          */
         static addrinfo_result  addrinfo(socket_address& address, const std::string& hostname, const sa_family_t family = AF_INET);
 
+        /**
+         * @brief       allocation free overload of addrinfo for a hostname that is not null terminated
+         * 
+         * @details     numeric addresses are parsed in place without getaddrinfo nor allocation,
+         *              other hostnames are resolved like socket_address::addrinfo \n 
+         *              **family** has no default value so that calls with a string literal keep using the std::string overload
+         * 
+         * @param address       sockaddr_storage reference to write retrieved address to
+         * @param hostname      hostname to be resolved or numeric address
+         * @param hostname_len  length of **hostname**
+         * @param family        expected return address family
+         * 
+         * @return see results in addrinfo_result
+         */
+        static addrinfo_result  addrinfo(struct sockaddr_storage& address, const char* hostname, size_t hostname_len, const sa_family_t family);
+
+        /**
+         * @brief       overload of addrinfo(sockaddr_storage&, const char*, size_t, sa_family_t) for socket_address
+         * 
+         * @param address       address reference to write retrieved address to
+         * @param hostname      hostname to be resolved or numeric address
+         * @param hostname_len  length of **hostname**
+         * @param family        expected return address family
+         * 
+         * @return see results in addrinfo_result
+         */
+        static addrinfo_result  addrinfo(socket_address& address, const char* hostname, size_t hostname_len, const sa_family_t family);
+
+        /**
+         * @brief       parses a numeric IPv4 or IPv6 address with inet_pton
+         * 
+         * @details     used by addrinfo before resolving names, forms only accepted by getaddrinfo
+         *              (like "127.1" or scoped IPv6 addresses) are not parsed and are left to getaddrinfo
+         * 
+         * @param address       sockaddr_storage reference to write the address to, port is set to 0
+         * @param hostname      numeric address, does not need to be null terminated
+         * @param hostname_len  length of **hostname**
+         * @param family        AF_INET, AF_INET6 or AF_UNSPEC to accept both
+         * 
+         * @return true if **hostname** is a numeric address of **family**
+         */
+        static bool             parse_numeric(struct sockaddr_storage& address, const char* hostname, size_t hostname_len, const sa_family_t family);
+
+        /**
+         * @brief       retrieves all the addresses of **hostname** with **family**
+         * 
+         * @details     numeric addresses are parsed with parse_numeric(), other hostnames are looked up in
+         *              address_cache::instance() first, then resolved with getaddrinfo and the result is cached,
+         *              addresses are listed in the order of getaddrinfo without duplicates \n 
+         *              on failure **addresses** is cleared and errno is set to the errno of the resolution
+         * 
+         * @param addresses set to the retrieved addresses
+         * @param hostname  hostname to be resolved
+         * @param family    expected return address family (from getaddrinfo), AF_UNSPEC for all families
+         * @param gai_error if not null, set to the getaddrinfo error code (EAI_*) of the resolution, cached or not,
+         *                  0 on success
+         * 
+         * @return see results in addrinfo_result
+         * 
+         * @ref address_cache
+         * @ref MAX_HOST_RESOLVE_RETRIES
+         */
+        static addrinfo_result  addrinfo_all(std::vector<socket_address>& addresses, const std::string& hostname, const sa_family_t family = AF_INET, int* gai_error = nullptr);
+
 
         /**
          * @brief       retrieves the host name depending on **addr** and **family**
@@ -493,6 +579,49 @@ class socket_address
         static socket_address from(const std::string& hostname, const in_port_t port, const sa_family_t family = AF_INET);
         
 
+        /**
+         * @brief   allocation free overload of from(const std::string&, in_port_t, sa_family_t) for a hostname that is not null terminated
+         * 
+         * @param hostname      the host name to resolve or ip address to create the address from
+         * @param hostname_len  length of **hostname**
+         * @param port          the port to set the resolved on
+         * @param family        family of the address
+         * 
+         * @return an inet address created from the resolved hostname, port and family
+         *
+         * @throws std::logic_error if socket_address::addrinfo failed to retrieve the hostname
+         */
+        static socket_address from(const char* hostname, size_t hostname_len, const in_port_t port, const sa_family_t family);
+
+
+        /**
+         * @brief   sets **address** to the AF_UNIX address of **path**
+         * 
+         * @details abstract addresses (linux only) are not bound to a file, **path** is then the name of the address
+         *          without the leading null byte, see unix(7)
+         * 
+         * @param address   address reference to write the AF_UNIX address to
+         * @param path      path of the socket file, or name of the abstract address
+         * @param abstract  use the abstract namespace instead of the filesystem
+         * 
+         * @return false if **path** is empty or does not fit in sockaddr_un::sun_path (errno is EINVAL / ENAMETOOLONG),
+         *         or if abstract addresses are not supported (errno is EAFNOSUPPORT)
+         */
+        static bool           unix_address(socket_address& address, const std::string& path, bool abstract = false);
+
+        /**
+         * @brief   creates an AF_UNIX socket_address from **path**, see unix_address
+         * 
+         * @param path      path of the socket file, or name of the abstract address
+         * @param abstract  use the abstract namespace instead of the filesystem
+         * 
+         * @return an AF_UNIX address of **path**
+         * 
+         * @throws std::logic_error if the address could not be created
+         */
+        static socket_address from_unix(const std::string& path, bool abstract = false);
+        
+
         /**
          * @brief returns a string describing the address structure
          * 
@@ -511,18 +640,6 @@ class socket_address
         template<sa_family_t _AddressFamily>
         std::string     _to_string() const;
 
-        /**
-         * @brief   specialization of _to_string for AF_INET
-         * @tparam  AF_INET
-         * @return  std::string string describing the inner address structure as sockaddr_in
-         */
-        template<>  std::string _to_string<AF_INET>() const;
-        /**
-         * @brief   specialization of _to_string for AF_INET6
-         * @tparam  AF_INET6
-         * @return  std::string string describing the inner address structure as sockaddr_in6
-         */
-        template<>  std::string _to_string<AF_INET6>() const;
 
     protected:
         /**
@@ -530,6 +647,133 @@ class socket_address
          * @note    this type will later be replaced by byte_string to adjust address size depending on af
          */
         struct sockaddr_storage _address;
+
+        /**
+         * @brief   size of the address, 0 to use the size of the family struct (see size())
+         */
+        socklen_t               _size;
+};
+
+
+/**
+ * @brief specialization of address_type_of for AF_INET
+ */
+template<>
+struct socket_address::address_type_of<AF_INET>
+    { using type = sockaddr_in; };
+
+/**
+ * @brief specialization of address_type_of for AF_INET6
+ */
+template<>
+struct socket_address::address_type_of<AF_INET6>
+    { using type = sockaddr_in6; };
+
+/**
+ * @brief specialization of address_type_of for AF_UNIX
+ */
+template<>
+struct socket_address::address_type_of<AF_UNIX>
+    { using type = sockaddr_un; };
+
+
+/**
+ * @brief specialization of address_family_of for sockaddr_in
+ */
+template<>
+struct socket_address::address_family_of<sockaddr_in>
+    {
+        /**
+         * @brief value of AF_INET
+         */
+        static constexpr sa_family_t value = AF_INET; 
+    };
+
+/**
+ * @brief specialization of address_family_of for sockaddr_in6
+ */ 
+template<>
+struct socket_address::address_family_of<sockaddr_in6>
+    {
+        /**
+         * @brief value of AF_INET6
+         */
+        static constexpr sa_family_t value = AF_INET6;
+    };
+
+/**
+ * @brief specialization of address_family_of for sockaddr_un
+ */
+template<>
+struct socket_address::address_family_of<sockaddr_un>
+    {
+        /**
+         * @brief value of AF_UNIX
+         */
+        static constexpr sa_family_t value = AF_UNIX;
+    };
+
+
+/**
+ * @brief   specialization of socket_address::to for _AddressType=struct sockaddr
+ * 
+ * @details deletes the check for family, even if addr is all zeroed or incoherent,
+ *          getnameinfo should return an appropriate error,
+ *          it also applies to other callers like callers like bind, recvfrom, sendto, etc...
+ * 
+ * @note    since all addresses families can be represented as sockaddr, this call never returns nullptr
+ * 
+ * @return  a reinterpreted pointer of type struct sockaddr
+ */
+template<>
+inline struct sockaddr*         socket_address::to<struct sockaddr>()
+{
+    return (reinterpret_cast<struct sockaddr*>(&_address));
+}
+
+/**
+ * @brief   specialization of socket_address::to for _AddressType=struct sockaddr
+ * 
+ * @details same as the non const version
+ * 
+ * @return  a reinterpreted pointer of type struct sockaddr
+ */
+template<>
+inline const struct sockaddr*   socket_address::to<struct sockaddr>() const
+{
+    return (reinterpret_cast<const struct sockaddr*>(&_address));
+}
+
+
+/**
+ * @brief   specialization of _to_string for AF_INET
+ * @tparam  AF_INET
+ * @return  std::string string describing the inner address structure as sockaddr_in
+ */
+template<>  std::string socket_address::_to_string<AF_INET>() const;
+/**
+ * @brief   specialization of _to_string for AF_INET6
+ * @tparam  AF_INET6
+ * @return  std::string string describing the inner address structure as sockaddr_in6
+ */
+template<>  std::string socket_address::_to_string<AF_INET6>() const;
+/**
+ * @brief   specialization of _to_string for AF_UNIX
+ * @tparam  AF_UNIX
+ * @return  std::string string describing the inner address structure as sockaddr_un
+ */
+template<>  std::string socket_address::_to_string<AF_UNIX>() const;
+
+
+/**
+ * @brief   hash functor of socket_address for unordered containers, see socket_address::hash
+ */
+struct socket_address_hash
+{
+    size_t  operator()(const socket_address& address) const
+    {
+        return (address.hash());
+    }
 };
 
 } // ******** namespace unisock
\ No newline at end of file
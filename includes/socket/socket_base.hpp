@@ -34,6 +34,40 @@ namespace unisock {
 class socket_base
 {
     public:
+        /**
+         * @brief   readiness dispatch function, called directly by events::poll with the ready socket and its dispatch context
+         *
+         * @ref     socket_base::dispatch_table
+         */
+        using dispatch_function = void (*)(socket_base* socket, void* context);
+
+        /**
+         * @brief   direct readiness dispatch of a socket
+         *
+         * @details this table is copied beside the pollfd of the socket when it is added to an events::handler,
+         *          events::poll then calls **readable** / **writeable** directly with the socket and **context**,
+         *          bypassing the virtual on_readable() / on_writeable() members and the std::function list of
+         *          basic_actions::READABLE and basic_actions::WRITEABLE.\n
+         *          by default, both entries are set to trampolines calling on_readable() and on_writeable().
+         *
+         * @ref     unisock::socket::set_dispatch
+         */
+        struct dispatch_table
+        {
+            /**
+             * @brief function called when socket is readable
+             */
+            dispatch_function   readable;
+            /**
+             * @brief function called when socket is writeable
+             */
+            dispatch_function   writeable;
+            /**
+             * @brief context pointer passed to readable and writeable
+             */
+            void*               context;
+        };
+
         /**
          * @brief default constructor default
          */
@@ -120,6 +154,35 @@ class socket_base
         virtual void    on_writeable() = 0;
 
 
+        /**
+         * @brief returns the direct dispatch table of this socket
+         *
+         * @return the dispatch table copied by events::handler when socket is added to it
+         */
+        const dispatch_table&   get_dispatch() const;
+
+        /**
+         * @brief   default readable dispatch, calls socket->on_readable()
+         *
+         * @param socket    the ready socket
+         * @param context   unused
+         */
+        static void     dispatch_readable(socket_base* socket, void* context);
+
+        /**
+         * @brief   default writeable dispatch, calls socket->on_writeable()
+         *
+         * @param socket    the ready socket
+         * @param context   unused
+         */
+        static void     dispatch_writeable(socket_base* socket, void* context);
+
+    protected:
+        /**
+         * @brief direct dispatch of this socket, defaults to dispatch_readable / dispatch_writeable
+         */
+        dispatch_table  _dispatch;
+
     private:
         /**
          * @brief socket file descriptor
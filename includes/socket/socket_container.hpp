@@ -14,6 +14,10 @@
 
 #include "events/pollable_entity.hpp"
 
+#include <cassert>
+#include <map>
+#include <vector>
+
 /**
  * @addindex
  */
@@ -87,6 +91,18 @@ class   socket_container : public events::pollable_entity
         }
 
 
+        /**
+         * @brief returns the file descriptors of the sockets of this container
+         */
+        std::vector<int>    get_sockets() const
+        {
+            std::vector<int> sockets;
+            sockets.reserve(this->sockets.size());
+            for (const auto& socket : this->sockets)
+                sockets.push_back(socket.first);
+            return (sockets);
+        }
+
         /**
          * @brief closes call sockets of this container
          * 
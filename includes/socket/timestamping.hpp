@@ -0,0 +1,253 @@
+/**
+ * @file timestamping.hpp
+ * @author ROBINO Luca
+ * @brief  kernel and hardware packet timestamps (SO_TIMESTAMPNS, SO_TIMESTAMPING)
+ * @version 1.0
+ * @date 2024-02-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+# include <linux/errqueue.h>
+# include <linux/net_tstamp.h>
+# include <netinet/in.h>
+#endif
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @brief   timestamps to enable on a socket, see unisock::socket::set_timestamping
+ *
+ * @details flags can be combined with bitwise or
+ */
+enum  timestamp_flag
+{
+    /**
+     * @brief no timestamps
+     */
+    TIMESTAMP_NONE =        0b0000,
+
+    /**
+     * @brief timestamp set by the kernel when the packet is received
+     */
+    TIMESTAMP_RX_SOFTWARE = 0b0001,
+
+    /**
+     * @brief timestamp set by the network card when the packet is received, the card must be configured with SIOCSHWTSTAMP
+     */
+    TIMESTAMP_RX_HARDWARE = 0b0010,
+
+    /**
+     * @brief timestamp set by the kernel when the packet leaves the network stack, reported on the error queue
+     */
+    TIMESTAMP_TX_SOFTWARE = 0b0100,
+
+    /**
+     * @brief timestamp set by the network card when the packet is sent, reported on the error queue
+     */
+    TIMESTAMP_TX_HARDWARE = 0b1000,
+};
+
+
+/**
+ * @brief   timestamps of a received packet, or of a sent packet reported on the error queue
+ *
+ * @ref unisock::socket::get_timestamps
+ * @ref basic_actions::TX_TIMESTAMP
+ */
+struct  packet_timestamps
+{
+    /**
+     * @brief kernel timestamp, valid if has_software is true
+     */
+    timespec    software {};
+
+    /**
+     * @brief network card timestamp, valid if has_hardware is true
+     */
+    timespec    hardware {};
+
+    /**
+     * @brief   for TX timestamps, identifies the sent packet
+     *
+     * @details index of the datagram counted from 0 since TX timestamps were enabled,
+     *          for stream sockets offset of the last byte of the send counted the same way
+     */
+    uint32_t    key = 0;
+
+    /**
+     * @brief true if software was set
+     */
+    bool        has_software = false;
+
+    /**
+     * @brief true if hardware was set
+     */
+    bool        has_hardware = false;
+
+    /**
+     * @brief returns true if no timestamp was set
+     */
+    bool        empty() const
+    {
+        return (!has_software && !has_hardware);
+    }
+};
+
+
+/**
+ * @addindex
+ */
+namespace _lib {
+
+/**
+ * @brief mask of receive timestamps in timestamp_flag
+ */
+constexpr int   TIMESTAMP_RX = TIMESTAMP_RX_SOFTWARE | TIMESTAMP_RX_HARDWARE;
+
+/**
+ * @brief mask of send timestamps in timestamp_flag
+ */
+constexpr int   TIMESTAMP_TX = TIMESTAMP_TX_SOFTWARE | TIMESTAMP_TX_HARDWARE;
+
+#if defined(__linux__)
+/**
+ * @brief control buffer size needed for timestamps of a packet, and extended error of error queue messages
+ */
+constexpr size_t    TIMESTAMP_CONTROL_SIZE = CMSG_SPACE(sizeof(scm_timestamping))
+                                            + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6));
+
+/**
+ * @brief returns SO_TIMESTAMPING options for timestamp_flag **flags**
+ */
+inline int  timestamping_options(int flags)
+{
+    int options = 0;
+    if (flags & TIMESTAMP_RX_SOFTWARE)
+        options |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (flags & TIMESTAMP_RX_HARDWARE)
+        options |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (flags & TIMESTAMP_TX_SOFTWARE)
+        options |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (flags & TIMESTAMP_TX_HARDWARE)
+        options |= SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    // numbers sent packets and reports only the timestamps on the error queue, not a copy of the packet
+    if (flags & TIMESTAMP_TX)
+        options |= SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    return (options);
+}
+#else
+/**
+ * @brief no timestamps control messages outside of linux
+ */
+constexpr size_t    TIMESTAMP_CONTROL_SIZE = 0;
+#endif
+
+/**
+ * @brief   reads timestamps in ancillary data of **message**
+ *
+ * @param message       header filled by recvmsg or recvmmsg
+ * @param timestamps    set to the timestamps found, cleared if none
+ *
+ * @return true if a timestamp was found
+ */
+inline bool parse_timestamps(const msghdr& message, packet_timestamps& timestamps)
+{
+    timestamps = packet_timestamps {};
+#if defined(__linux__)
+    msghdr* header = const_cast<msghdr*>(&message);
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(header); cmsg != nullptr; cmsg = CMSG_NXTHDR(header, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            std::memcpy(&timestamps.software, CMSG_DATA(cmsg), sizeof(timestamps.software));
+            timestamps.has_software = true;
+        }
+        else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+        {
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            // ts[0] is the software timestamp, ts[1] is deprecated, ts[2] is the raw hardware timestamp
+            timestamps.software = stamps.ts[0];
+            timestamps.has_software = stamps.ts[0].tv_sec != 0 || stamps.ts[0].tv_nsec != 0;
+            timestamps.hardware = stamps.ts[2];
+            timestamps.has_hardware = stamps.ts[2].tv_sec != 0 || stamps.ts[2].tv_nsec != 0;
+        }
+        else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+        {
+            sock_extended_err error;
+            std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+            if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+                timestamps.key = error.ee_data;
+        }
+    }
+#else
+    (void)message;
+#endif
+    return (!timestamps.empty());
+}
+
+/**
+ * @brief   receives a message with recvmsg and reads its timestamps, same as recvfrom otherwise
+ *
+ * @param socket        socket file descriptor
+ * @param buffer        buffer to receive the message
+ * @param buffer_len    size of **buffer**
+ * @param flags         flags for recvmsg
+ * @param address       filled with the sender address if not nullptr
+ * @param address_len   size of **address**, set to the size of the sender address
+ * @param timestamps    set to the timestamps of the message
+ *
+ * @return number of received bytes, -1 on error with errno set
+ */
+inline ssize_t  recv_timestamped(int socket, void* buffer, size_t buffer_len, int flags,
+                                    sockaddr* address, socklen_t* address_len, packet_timestamps& timestamps)
+{
+    msghdr  header;
+    iovec   iov;
+#if defined(__linux__)
+    // aligned as cmsghdr for CMSG_* macros
+    union
+    {
+        char        buffer[TIMESTAMP_CONTROL_SIZE];
+        size_t      align;
+    }   control;
+#endif
+
+    std::memset(&header, 0, sizeof(header));
+    iov.iov_base = buffer;
+    iov.iov_len = buffer_len;
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_name = address;
+    header.msg_namelen = address_len != nullptr ? *address_len : 0;
+#if defined(__linux__)
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+#endif
+
+    ssize_t n_bytes = ::recvmsg(socket, &header, flags);
+    if (n_bytes < 0)
+        return (n_bytes);
+    if (address_len != nullptr)
+        *address_len = header.msg_namelen;
+    parse_timestamps(header, timestamps);
+    return (n_bytes);
+}
+
+} // ******** namespace _lib
+
+} // ******** namespace unisock
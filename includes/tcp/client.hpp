@@ -10,6 +10,13 @@
  */
 
 #include "tcp/connection.hpp"
+#include "socket/resolver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <vector>
+#include <fcntl.h>
 
 /**
  * @addindex
@@ -197,27 +204,270 @@ class client_impl   <
          */
         bool    connect(const std::string& hostname, ushort port, bool use_IPv6 = false)
         {
-            connection_type* conn = this->container.make_socket(use_IPv6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+            connection_type* conn = this->open_connection(use_IPv6);
             if (conn == nullptr)
+                return false;
+
+            if (addrinfo_result::SUCCESS != socket_address::addrinfo(conn->address, hostname, use_IPv6 ? AF_INET6 : AF_INET))
             {
-                this->template execute<basic_actions::ERROR>("socket", errno);
+                this->template execute<basic_actions::ERROR>("getaddrinfo", errno);
+                conn->close();
+                // this->delete_socket(conn->get_socket());
+                return false;
+            }
+            return (this->connect_resolved(conn, port, use_IPv6));
+        }
+
+
+        /**
+         * @brief   connects to the unix domain socket **path**
+         * 
+         * @details the connection is received and sent like a tcp connection with the same actions, without the TCP/IP stack,
+         *          client_actions::CONNECT is executed on success
+         * 
+         * @param path      path of the socket file, or name of the abstract address
+         * @param abstract  use the abstract namespace (linux only) instead of the filesystem
+         * @param type      SOCK_STREAM, or SOCK_SEQPACKET to keep message boundaries (not supported on macOS)
+         * 
+         * @return true if connection succeeded, false otherwise, error can be retrieved in basic_actions::ERROR hook
+         */
+        bool    connect_unix(const std::string& path, bool abstract = false, int type = SOCK_STREAM)
+        {
+            connection_type* conn = this->open_connection(AF_UNIX, type);
+            if (conn == nullptr)
+                return false;
+
+            if (!socket_address::unix_address(conn->address, path, abstract))
+            {
+                this->template execute<basic_actions::ERROR>("unix_address", errno);
+                conn->close();
+                return false;
+            }
+            if (!conn->connect())
+            {
+                this->template execute<basic_actions::ERROR>("connect", errno);
+                conn->close();
                 return false;
             }
 
+            this->start_connection(conn);
+            return (true);
+        }
+
+
+        /**
+         * @brief   same as connect(), but resolves **hostname** on the resolver of this client instead of blocking events::poll
+         * 
+         * @details once **hostname** is resolved, a non-blocking connection is started from events::poll on the handler
+         *          of this client and completed when its socket becomes writeable, like an attempt of connect_any().
+         *          client_actions::CONNECT is then executed on success, basic_actions::ERROR with "getaddrinfo" and the
+         *          getaddrinfo error code (EAI_*, see gai_strerror) if the lookup failed, with "connect" if the connection failed.
+         * 
+         * @param hostname  hostname to connect to
+         * @param port      port to connect to
+         * @param use_IPv6  use IPv6
+         * 
+         * @ref unisock::resolver
+         */
+        void    async_connect(const std::string& hostname, ushort port, bool use_IPv6 = false)
+        {
+            // a race on a single address, without timeout like connect()
+            races.emplace_back();
+            connect_race* race = &races.back();
+            race->client = this;
+            race->port = port;
+            race->attempt_delay = std::chrono::milliseconds(DEFAULT_ATTEMPT_DELAY);
+
+            this->get_resolver()->resolve(hostname, use_IPv6 ? AF_INET6 : AF_INET,
+                [this, race](addrinfo_result result, const socket_address& address, int gai_error)
+                {
+                    if (!this->has_race(race))
+                        return ;
+                    if (result != addrinfo_result::SUCCESS)
+                    {
+                        this->end_race(race, nullptr, 0);
+                        this->template execute<basic_actions::ERROR>("getaddrinfo", gai_error);
+                        return ;
+                    }
+
+                    race->addresses.push_back(address);
+                    this->start_race(race);
+                }
+            );
+        }
+
+
+        /**
+         * @brief default delay between two connection attempts of connect_any(), recommended by RFC 8305
+         */
+        static constexpr std::chrono::milliseconds::rep DEFAULT_ATTEMPT_DELAY = 250;
+
+        /**
+         * @brief default maximum duration of connect_any(), from the lookup to the established connection
+         */
+        static constexpr std::chrono::milliseconds::rep DEFAULT_CONNECT_TIMEOUT = 10000;
+
+        /**
+         * @brief   connects to **hostname** on **port** over IPv4 or IPv6, racing the addresses of **hostname** (happy eyeballs)
+         * 
+         * @details all addresses of **hostname** are resolved on the resolver of this client (see resolver::resolve_all) and
+         *          ordered alternating families, starting with the family of the first address (RFC 8305). a non-blocking
+         *          connection attempt is started on the first address, then on the next one every **attempt_delay** or as
+         *          soon as an attempt fails, until one attempt succeeds. other attempts are then closed, the winner becomes a
+         *          connection of this client and client_actions::CONNECT is executed like with connect().\n
+         *          attempts are sockets of the handler of this client and their delays are timers of the handler
+         *          (see events::handler::add_timer), the race runs from events::poll without blocking other sockets.
+         * 
+         * @note    basic_actions::ERROR is executed with "getaddrinfo" and the getaddrinfo error code (EAI_*, see gai_strerror)
+         *          if the lookup failed, with "connect" and the error of
+         *          the last attempt if every attempt failed, or ETIMEDOUT if **timeout** expired first
+         * 
+         * @param hostname      hostname to connect to
+         * @param port          port to connect to
+         * @param attempt_delay delay before starting the next attempt while previous ones are pending
+         * @param timeout       maximum duration of the whole race, including the lookup, 0 to wait for the kernel connect timeout of every attempt
+         */
+        void    connect_any(const std::string& hostname, ushort port,
+                            std::chrono::milliseconds attempt_delay = std::chrono::milliseconds(DEFAULT_ATTEMPT_DELAY),
+                            std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_CONNECT_TIMEOUT))
+        {
+            races.emplace_back();
+            connect_race* race = &races.back();
+            race->client = this;
+            race->port = port;
+            race->attempt_delay = attempt_delay;
+
+            if (timeout.count() > 0)
+            {
+                race->timeout_timer = get_handler()->add_timer(events::handler::timer_clock::now() + timeout,
+                    [this, race](){
+                        race->timeout_timer = 0;
+                        this->end_race(race, nullptr, ETIMEDOUT);
+                    }
+                );
+            }
+
+            this->get_resolver()->resolve_all(hostname, AF_UNSPEC,
+                [this, race](addrinfo_result result, const std::vector<socket_address>& addresses, int gai_error)
+                {
+                    // the race timed out during the lookup
+                    if (!this->has_race(race))
+                        return ;
+                    if (result != addrinfo_result::SUCCESS)
+                    {
+                        this->end_race(race, nullptr, 0);
+                        this->template execute<basic_actions::ERROR>("getaddrinfo", gai_error);
+                        return ;
+                    }
+
+                    race->addresses = addresses;
+                    client_impl::interleave_families(race->addresses);
+                    this->start_race(race);
+                }
+            );
+        }
+
+        /**
+         * @brief   cancels pending async_connect() and connect_any() races, their attempts are closed
+         */
+        ~client_impl()
+        {
+            while (!races.empty())
+                this->end_race(&races.front(), nullptr, 0);
+        }
+
+
+        /**
+         * @brief   sets the resolver used by async_connect()
+         * 
+         * @note    a resolver shared between entities must not call back an entity that was destroyed,
+         *          entities must outlive their pending lookups
+         */
+        void    set_resolver(std::shared_ptr<unisock::resolver> resolver)
+        {
+            this->async_resolver = resolver;
+        }
+
+
+        /**
+         * @brief returns the resolver used by async_connect(), creates one on the handler of this client if none was set
+         */
+        std::shared_ptr<unisock::resolver>  get_resolver()
+        {
+            if (!this->async_resolver)
+                this->async_resolver = std::make_shared<unisock::resolver>(get_handler());
+            return (this->async_resolver);
+        }
+
+
+        /**
+         * @brief   send a message to all connections of this client
+         * 
+         * @param message       message to send
+         * @param message_len   message size
+         * 
+         */
+        void    send(const char* message, size_t message_len)
+        {
+            // TODO: error check on global send
+            for (connection_type* connection : this->sockets)
+            {
+                connection->send(message, message_len);
+            }
+        }
+
+
+    protected:
+        /**
+         * @brief   opens a new connection socket, executes basic_actions::ERROR on failure
+         * 
+         * @return the connection, nullptr if the socket could not be opened
+         */
+        connection_type*    open_connection(bool use_IPv6)
+        {
+            return (this->open_connection(use_IPv6 ? AF_INET6 : AF_INET, SOCK_STREAM));
+        }
+
+
+        /**
+         * @brief   opens a new connection socket of **domain** and **type**, executes basic_actions::ERROR on failure
+         * 
+         * @return the connection, nullptr if the socket could not be opened
+         */
+        connection_type*    open_connection(int domain, int type)
+        {
+            connection_type* conn = this->container.make_socket(domain, type, 0);
+            if (conn == nullptr)
+            {
+                this->template execute<basic_actions::ERROR>("socket", errno);
+                return nullptr;
+            }
+            this->track_connection(conn);
+            return (conn);
+        }
+
+
+        /**
+         * @brief executes common_actions::CLOSED when **conn** is closed
+         */
+        void    track_connection(connection_type* conn)
+        {
             conn->template on<unisock::basic_actions::CLOSED>(
                 [this, conn]()
                 {
                     this->template execute<common_actions::CLOSED>(reinterpret_cast<connection*>(conn));
                 }
             );
+        }
 
-            if (addrinfo_result::SUCCESS != socket_address::addrinfo(conn->address, hostname, use_IPv6 ? AF_INET6 : AF_INET))
-            {
-                this->template execute<basic_actions::ERROR>("getaddrinfo", errno);
-                conn->close();
-                // this->delete_socket(conn->get_socket());
-                return false;
-            }
+
+        /**
+         * @brief   connects **conn** to its resolved address on **port**, and starts receiving on it
+         * 
+         * @return true if connection succeeded, false otherwise and **conn** is closed
+         */
+        bool    connect_resolved(connection_type* conn, ushort port, bool use_IPv6)
+        {
             if (!use_IPv6)
                 conn->address.template to<sockaddr_in>()->sin_port = htons(port);
             else
@@ -231,6 +481,16 @@ class client_impl   <
                 return false;
             }
 
+            this->start_connection(conn);
+            return (true);
+        }
+
+
+        /**
+         * @brief starts receiving on connected **conn** and executes client_actions::CONNECT
+         */
+        void    start_connection(connection_type* conn)
+        {
             // receive events with this action handler 
             conn->template on<unisock::basic_actions::READABLE>(
                 [conn]()
@@ -238,6 +498,7 @@ class client_impl   <
                     conn->recv();
                 }
             );
+            conn->set_dispatch(&connection_type::dispatch_recv, &socket_base::dispatch_writeable);
 
             conn->template on<tcp::connection_actions::RECV>(
                 [this, conn](const char* message, size_t message_len)
@@ -247,29 +508,241 @@ class client_impl   <
             );
 
             this->template execute<client_actions::CONNECT>(reinterpret_cast<connection*>(conn));
-            return (true);
         }
 
 
         /**
-         * @brief   send a message to all connections of this client
+         * @brief   reorders **addresses** alternating families, starting with the family of the first address (RFC 8305)
+         */
+        static void interleave_families(std::vector<socket_address>& addresses)
+        {
+            if (addresses.empty())
+                return ;
+
+            const sa_family_t           first = addresses.front().family();
+            std::vector<socket_address> preferred;
+            std::vector<socket_address> others;
+            for (const socket_address& address : addresses)
+                (address.family() == first ? preferred : others).push_back(address);
+
+            addresses.clear();
+            for (size_t i = 0; i < preferred.size() || i < others.size(); ++i)
+            {
+                if (i < preferred.size())
+                    addresses.push_back(preferred[i]);
+                if (i < others.size())
+                    addresses.push_back(others[i]);
+            }
+        }
+
+
+        /**
+         * @brief   state of a connect_any() race, or of an async_connect() with a single address
+         */
+        struct  connect_race
+        {
+            /**
+             * @brief client running the race, context of the dispatch of attempts
+             */
+            client_impl*                        client = nullptr;
+
+            /**
+             * @brief port to connect to
+             */
+            ushort                              port = 0;
+
+            /**
+             * @brief delay before starting the next attempt
+             */
+            std::chrono::milliseconds           attempt_delay;
+
+            /**
+             * @brief resolved addresses, ordered alternating families
+             */
+            std::vector<socket_address>         addresses;
+
+            /**
+             * @brief index of the next address to try
+             */
+            size_t                              next = 0;
+
+            /**
+             * @brief pending attempts, sockets of the container not tracked as connections yet
+             */
+            std::vector<connection_type*>       attempts;
+
+            /**
+             * @brief error of the last failed attempt
+             */
+            int                                 error = ECONNREFUSED;
+
+            /**
+             * @brief timer starting the next attempt, 0 if none
+             */
+            events::handler::timer_id           attempt_timer = 0;
+
+            /**
+             * @brief timer ending the race, 0 if none
+             */
+            events::handler::timer_id           timeout_timer = 0;
+        };
+
+        /**
+         * @brief returns true if **race** is still running
+         */
+        bool    has_race(const connect_race* race) const
+        {
+            for (const connect_race& running : races)
+            {
+                if (&running == race)
+                    return (true);
+            }
+            return (false);
+        }
+
+        /**
+         * @brief sets the port of the resolved addresses of **race** and starts its first attempt
+         */
+        void    start_race(connect_race* race)
+        {
+            for (socket_address& address : race->addresses)
+            {
+                if (address.family() == AF_INET)
+                    address.template to<sockaddr_in>()->sin_port = htons(race->port);
+                else
+                    address.template to<sockaddr_in6>()->sin6_port = htons(race->port);
+            }
+            this->next_attempt(race);
+        }
+
+        /**
+         * @brief   starts attempts on the next addresses of **race** until one is pending, the race fails if none is left
+         */
+        void    next_attempt(connect_race* race)
+        {
+            while (race->next < race->addresses.size())
+            {
+                const socket_address& address = race->addresses[race->next++];
+                connection_type* conn = this->container.make_socket(address.family(), SOCK_STREAM, 0);
+                if (conn == nullptr)
+                {
+                    race->error = errno;
+                    continue ;
+                }
+                conn->address = address;
+                ::fcntl(conn->get_socket(), F_SETFL, ::fcntl(conn->get_socket(), F_GETFL) | O_NONBLOCK);
+
+                if (0 == ::connect(conn->get_socket(), address.template to<sockaddr>(), address.size()))
+                {
+                    this->end_race(race, conn, 0);
+                    return ;
+                }
+                if (errno != EINPROGRESS)
+                {
+                    race->error = errno;
+                    conn->close();
+                    continue ;
+                }
+
+                // readable on error (POLLERR), writeable once connected
+                conn->set_dispatch(&client_impl::dispatch_attempt, &client_impl::dispatch_attempt, race);
+                conn->set_want_read(false);
+                conn->set_want_write(true);
+                race->attempts.push_back(conn);
+                if (race->next < race->addresses.size())
+                {
+                    race->attempt_timer = get_handler()->add_timer(events::handler::timer_clock::now() + race->attempt_delay,
+                        [this, race](){
+                            race->attempt_timer = 0;
+                            this->next_attempt(race);
+                        }
+                    );
+                }
+                return ;
+            }
+
+            if (race->attempts.empty())
+                this->end_race(race, nullptr, race->error);
+        }
+
+        /**
+         * @brief   completes an attempt of a race, dispatch of attempt sockets
          * 
-         * @param message       message to send
-         * @param message_len   message size
+         * @param socket    the attempt
+         * @param context   the race
+         */
+        static void dispatch_attempt(socket_base* socket, void* context)
+        {
+            connect_race*       race = static_cast<connect_race*>(context);
+            connection_type*    conn = static_cast<connection_type*>(socket);
+
+            int         error = 0;
+            socklen_t   error_size = sizeof(error);
+            if (0 > ::getsockopt(conn->get_socket(), SOL_SOCKET, SO_ERROR, &error, &error_size))
+                error = errno;
+            if (error == 0)
+            {
+                race->client->end_race(race, conn, 0);
+                return ;
+            }
+
+            // a failed attempt lets the next one start right away
+            race->error = error;
+            race->attempts.erase(std::find(race->attempts.begin(), race->attempts.end(), conn));
+            conn->close();
+            if (race->attempt_timer != 0)
+                race->client->get_handler()->cancel_timer(race->attempt_timer);
+            race->attempt_timer = 0;
+            race->client->next_attempt(race);
+        }
+
+        /**
+         * @brief   ends **race**, its timers are cancelled and its attempts other than **winner** are closed
          * 
+         * @details the winner becomes a connection of this client, otherwise basic_actions::ERROR is executed with "connect"
+         *          and **error** if not 0
          */
-        void    send(const char* message, size_t message_len)
+        void    end_race(connect_race* race, connection_type* winner, int error)
         {
-            // TODO: error check on global send
-            for (connection_type* connection : this->sockets)
+            if (race->attempt_timer != 0)
+                get_handler()->cancel_timer(race->attempt_timer);
+            if (race->timeout_timer != 0)
+                get_handler()->cancel_timer(race->timeout_timer);
+            for (connection_type* attempt : race->attempts)
             {
-                connection->send(message, message_len);
+                if (attempt != winner)
+                    attempt->close();
+            }
+            races.remove_if([race](const connect_race& running){ return (&running == race); });
+
+            if (winner != nullptr)
+            {
+                // connections are blocking like the ones made by connect()
+                ::fcntl(winner->get_socket(), F_SETFL, ::fcntl(winner->get_socket(), F_GETFL) & ~O_NONBLOCK);
+                winner->set_want_write(false);
+                winner->set_want_read(true);
+                this->track_connection(winner);
+                this->start_connection(winner);
+            }
+            else if (error != 0)
+            {
+                errno = error;
+                this->template execute<basic_actions::ERROR>("connect", error);
             }
         }
 
 
-    protected:
         container_type  container;
+
+        /**
+         * @brief resolver of async_connect(), created on first use
+         */
+        std::shared_ptr<unisock::resolver>  async_resolver;
+
+        /**
+         * @brief races of async_connect() and connect_any() still running, a list so that timers and attempts keep pointers to them
+         */
+        std::list<connect_race>             races;
 };
 
 
@@ -12,8 +12,10 @@
 
 #include "socket/socket.hpp"
 #include "socket/socket_container.hpp"
+#include "socket/ancillary.hpp"
 #include "events/events.hpp"
 #include <queue>
+#include <vector>
 
 /**
  * @addindex
@@ -215,6 +217,14 @@ class connection_base
         : base_type(handler, socket)
         {}
 
+        /**
+         * @brief closes received file descriptors that were not taken with take_fds()
+         */
+        ~connection_base()
+        {
+            this->close_received_fds();
+        }
+
 
         /**
          * @brief   send a message using this connection socket
@@ -249,6 +259,77 @@ class connection_base
             }
             return (true);
         }
+
+        /**
+         * @brief   sends **message** with **n_fds** file descriptors of **fds**, unix domain connections only (SCM_RIGHTS)
+         * 
+         * @details the receiving process gets duplicates of the file descriptors with the first byte of **message**
+         *          (see set_receive_fds), they stay open in this process. like send(), the leftover of a partial send
+         *          is sent later by send_flush, without the file descriptors which were sent with the first bytes.
+         * 
+         * @note    file descriptors can not be sent while leftovers of previous sends are queued, false is then returned
+         *          with errno set to EAGAIN and basic_actions::ERROR is not called
+         * 
+         * @param fds           file descriptors to pass, at most control_buffer::MAX_FDS
+         * @param n_fds         number of file descriptors in **fds**
+         * @param message       message to send with the file descriptors, at least one byte
+         * @param message_len   size of the message to send
+         * 
+         * @return false on send error, otherwise true
+         */
+        bool    send_fds(const int* fds, size_t n_fds, const char* message, size_t message_len)
+        {
+            if (!send_buffer.empty())
+            {
+                errno = EAGAIN;
+                return false;
+            }
+
+            ssize_t n_bytes = _lib::send_fds(this->get_socket(), fds, n_fds, message, message_len, 0);
+            if (n_bytes < 0)
+            {
+                this->template execute<basic_actions::ERROR>("sendmsg", errno);
+                return false;
+            }
+            if (static_cast<size_t>(n_bytes) < message_len)
+            {
+                send_buffer.push(std::string(message + n_bytes, message_len - n_bytes));
+                this->handler->socket_want_write(this->get_socket(), true);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   enables receiving file descriptors passed with received messages, unix domain connections only
+         * 
+         * @details when disabled (default), file descriptors passed to this connection are closed by the kernel.
+         *          when enabled, recv() uses recvmsg and received file descriptors can be read with get_fds()
+         *          or taken with take_fds() in RECEIVE hooks.
+         */
+        void    set_receive_fds(bool enable)
+        {
+            this->receive_fds = enable;
+        }
+
+        /**
+         * @brief   returns the file descriptors received with the last message, only valid while a receive hook is executed
+         * 
+         * @details file descriptors that are not taken with take_fds() are closed before the next receive
+         */
+        const std::vector<int>& get_fds() const
+        {
+            return (this->received_fds);
+        }
+
+        /**
+         * @brief   takes the file descriptors received with the last message, the caller then owns them and must close them
+         */
+        std::vector<int>        take_fds()
+        {
+            std::vector<int> fds;
+            fds.swap(this->received_fds);
+            return (fds);
+        }
     
         /**
          * @brief  tries to listen using current socket
@@ -281,62 +362,143 @@ class connection_base
         /**
          * @brief   tries to recv on current socket
          * 
-         * @return the result of recv: 
+         * @details when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          recv loops until the socket is flushed (EAGAIN) or until its quota is exhausted.
+         * 
+         * @return the result of the last recv: 
          *         >0 : number of bytes received
          *          0 : disconnected
-         *         <0 : recv error
+         *         <0 : recv error, or socket was flushed (errno is EAGAIN, ERROR hook is not called)
          */
         ssize_t recv()
         {
-            char    buffer[base_type::RECV_BUFFER_SIZE] { 0 };
-            int n_bytes = ::recv(this->get_socket(), buffer, base_type::RECV_BUFFER_SIZE, 0);
-            if (n_bytes < 0)
-            {
-                this->template execute<basic_actions::ERROR>("recv", errno);
-                return n_bytes;
-            }
-            if (n_bytes == 0)
+            // keeps a reference to the handler, this connection may be deleted by a hook
+            std::shared_ptr<events::handler> handler = this->handler;
+            const int   socket = this->get_socket();
+            char        buffer[base_type::RECV_BUFFER_SIZE] { 0 };
+            ssize_t     n_bytes = 0;
+
+            if ((this->timestamping & _lib::TIMESTAMP_TX) && !this->recv_errqueue())
+                return (-1);
+
+            do
             {
-                this->close();//template execute<basic_actions::CLOSED>();
-                return n_bytes;
+                // timestamps of a tcp recv are the timestamps of the last segment received
+                if (this->receive_fds)
+                {
+                    this->close_received_fds();
+                    n_bytes = _lib::recv_fds(socket, buffer, base_type::RECV_BUFFER_SIZE, MSG_DONTWAIT, this->received_fds,
+                                             (this->timestamping & _lib::TIMESTAMP_RX) ? &this->timestamps : nullptr);
+                }
+                else if (this->timestamping & _lib::TIMESTAMP_RX)
+                    n_bytes = _lib::recv_timestamped(socket, buffer, base_type::RECV_BUFFER_SIZE, MSG_DONTWAIT, nullptr, nullptr, this->timestamps);
+                else
+                    n_bytes = ::recv(socket, buffer, base_type::RECV_BUFFER_SIZE, MSG_DONTWAIT);
+                if (n_bytes < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        this->template execute<basic_actions::ERROR>("recv", errno);
+                    return n_bytes;
+                }
+                if (n_bytes == 0)
+                {
+                    this->close();//template execute<basic_actions::CLOSED>();
+                    return n_bytes;
+                }
+
+                ushort handler_ref = handler->get_ref();
+                this->template execute<connection_actions::RECV>(buffer, n_bytes);
+                // a socket was added or deleted by the hook, this connection may not exist anymore
+                if (handler->ref_has_changed(handler_ref))
+                    return n_bytes;
             }
-            this->template execute<connection_actions::RECV>(buffer, n_bytes);
+            while (handler->consume(socket, n_bytes));
             return n_bytes;
         }
 
+        /**
+         * @brief direct readable dispatch calling recv(), see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready connection
+         * @param context   unused
+         */
+        static void dispatch_recv(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<connection_base*>(socket)->recv();
+        }
+
+        /**
+         * @brief direct writeable dispatch calling send_flush(), see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready connection
+         * @param context   unused
+         */
+        static void dispatch_send_flush(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<connection_base*>(socket)->send_flush();
+        }
+
         /**
          * @brief sends contents stored to the send buffer, usually called when send failed to send the whole message
          * 
+         * @details when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          send_flush loops until the send buffer is empty, the socket is full, or its quota is exhausted.
          * 
          * @ref tcp::connection_base<_EntityData>::send
          */
         void    send_flush()
         {
-            if (send_buffer.empty())
-                return ;
-            
-            int n_bytes = ::send(this->get_socket(), send_buffer.front().c_str(), send_buffer.front().size(), 0);
-            if (n_bytes < 0)
-            {
-                this->template execute<basic_actions::ERROR>("send", errno);
-                return ;
-            }
-            if (static_cast<size_t>(n_bytes) < send_buffer.front().size())
+            while (!send_buffer.empty())
             {
-                send_buffer.front().substr(n_bytes);
-                return ;
+                ssize_t n_bytes = ::send(this->get_socket(), send_buffer.front().c_str(), send_buffer.front().size(), MSG_DONTWAIT);
+                if (n_bytes < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        this->template execute<basic_actions::ERROR>("send", errno);
+                    return ;
+                }
+                if (static_cast<size_t>(n_bytes) < send_buffer.front().size())
+                {
+                    // socket is full, leftover is sent next time socket is writeable
+                    send_buffer.front().erase(0, n_bytes);
+                    return ;
+                }
+                send_buffer.pop();
+                if (!this->handler->consume(this->get_socket(), n_bytes))
+                    break ;
             }
-            send_buffer.pop();
-            this->handler->socket_want_write(this->get_socket(), false);
+            if (send_buffer.empty())
+                this->handler->socket_want_write(this->get_socket(), false);
         }
         
     private:
+        /**
+         * @brief closes received file descriptors that were not taken
+         */
+        void    close_received_fds()
+        {
+            for (int fd : this->received_fds)
+                ::close(fd);
+            this->received_fds.clear();
+        }
 
         /**
          * @brief send buffer, gets filled when send was not able to send the whole message once
          * 
          */
         std::queue<std::string> send_buffer;
+
+        /**
+         * @brief receive file descriptors passed with messages (see set_receive_fds)
+         */
+        bool                    receive_fds = false;
+
+        /**
+         * @brief file descriptors received with the last message
+         */
+        std::vector<int>        received_fds;
 };
 
 
@@ -386,6 +548,36 @@ class connection : private tcp::connection_base<_EntityData...>
          */
         using base_type::send;
 
+        /**
+         * @brief move of set_timestamping() member to public
+         */
+        using base_type::set_timestamping;
+
+        /**
+         * @brief move of get_timestamps() member to public
+         */
+        using base_type::get_timestamps;
+
+        /**
+         * @brief move of send_fds() member to public
+         */
+        using base_type::send_fds;
+
+        /**
+         * @brief move of set_receive_fds() member to public
+         */
+        using base_type::set_receive_fds;
+
+        /**
+         * @brief move of get_fds() member to public
+         */
+        using base_type::get_fds;
+
+        /**
+         * @brief move of take_fds() member to public
+         */
+        using base_type::take_fds;
+
         /**
          * @brief move of data field to public
          */
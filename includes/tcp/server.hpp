@@ -11,6 +11,12 @@
 #pragma once
 
 #include "tcp/connection.hpp"
+#include "socket/resolver.hpp"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <cassert>
 
 /**
  * @addindex
@@ -76,6 +82,20 @@ namespace server_actions
         static constexpr const char* action_name = "TCP::DISCONNECT";
         static constexpr const char* callback_prototype = "void (connection*)";
     };
+
+    /**
+     * @brief   sockets of the server were handed to a replacement process
+     * 
+     * @details this event will be called when a replacement process adopted the sockets of tcp::server
+     *          (see tcp::server_impl::enable_handoff), after they were closed in this process
+     * 
+     * @note    hook prototype: ```void  (size_t n_sockets)```
+     */
+    struct  HANDOFF
+    {
+        static constexpr const char* action_name = "TCP::HANDOFF";
+        static constexpr const char* callback_prototype = "void (size_t)";
+    };
 } // ******** namespace server_actions
 
 
@@ -108,6 +128,9 @@ using   server_actions_list = unisock::events::actions_list<
     events::action<server_actions::DISCONNECT,
         std::function<void (_ClientConnection*)> >,
 
+    events::action<server_actions::HANDOFF,
+        std::function<void (size_t)> >,
+
     _ExtendedActions...
 >;
 
@@ -210,12 +233,22 @@ class server_impl   <
 
 
         /**
-         * @brief calls both listener and accepted clients containers to close()
+         * @brief closes the handoff socket, see disable_handoff()
+         */
+        ~server_impl()
+        {
+            this->disable_handoff();
+        }
+
+
+        /**
+         * @brief calls both listener and accepted clients containers to close(), and disables the handoff
          * 
          * @ref socket_container<_SocketType>::close
          */
         void    close()
         {
+            this->disable_handoff();
             this->clients_container.close();
             this->listeners_container.close();
         }
@@ -232,58 +265,267 @@ class server_impl   <
          */
         bool    listen(const std::string& hostname, ushort port, bool use_IPv6 = false)
         {
-            server_connection_type* socket { this->listeners_container.make_socket(use_IPv6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0) };
+            server_connection_type* socket = this->open_listener(use_IPv6);
             if (socket == nullptr)
+                return false;
+
+            if (addrinfo_result::SUCCESS != socket_address::addrinfo(socket->address, hostname, use_IPv6 ? AF_INET6 : AF_INET))
             {
-                this->template execute<basic_actions::ERROR>("socket", errno);
+                this->template execute<basic_actions::ERROR>("getaddrinfo", errno);
+                socket->close();
+                // this->server_container_type::delete_socket(socket->get_socket());
                 return false;
             }
+            return (this->listen_resolved(socket, port, use_IPv6));
+        }
 
-            // setting on closed action here so that common_actions::CLOSED hook is called on listen failure
-            socket->template on<unisock::basic_actions::CLOSED>(
-                [this, socket]() {
-                    this->template execute<common_actions::CLOSED>(reinterpret_cast<server_connection*>(socket));
+
+        /**
+         * @brief   makes the server start to listen on the unix domain socket **path**
+         * 
+         * @details connections are accepted and received like tcp connections with the same actions, without the TCP/IP stack.
+         *          a stale socket file left at **path** by a server that is not running anymore is removed before binding,
+         *          the socket file is not removed when the listener is closed (it may have been handed to another process).
+         * 
+         * @param path      path of the socket file, or name of the abstract address
+         * @param abstract  use the abstract namespace (linux only) instead of the filesystem
+         * @param type      SOCK_STREAM, or SOCK_SEQPACKET to keep message boundaries (not supported on macOS)
+         * 
+         * @return false if server was not able to listen on address (error is called in tcp::basic_actions::ERROR hook of tcp::server)
+         */
+        bool    listen_unix(const std::string& path, bool abstract = false, int type = SOCK_STREAM)
+        {
+            server_connection_type* socket = this->open_listener(AF_UNIX, type);
+            if (socket == nullptr)
+                return false;
+
+            if (!socket_address::unix_address(socket->address, path, abstract))
+            {
+                this->template execute<basic_actions::ERROR>("unix_address", errno);
+                socket->close();
+                return false;
+            }
+            if (!abstract)
+                server_impl::remove_stale_socket(socket->address, type);
+            return (this->start_listening(socket));
+        }
+
+
+        /**
+         * @brief   same as listen(), but resolves **hostname** on the resolver of this server instead of blocking events::poll
+         * 
+         * @details the listener is opened once **hostname** is resolved, from events::poll on the handler of this server.
+         *          server_actions::LISTEN is then executed on success, basic_actions::ERROR with "getaddrinfo" and the
+         *          getaddrinfo error code (EAI_*, see gai_strerror) if the lookup failed.
+         * 
+         * @param hostname  the host to listen on
+         * @param port      the port to listen on
+         * @param use_IPv6  use IPv6
+         * 
+         * @ref unisock::resolver
+         */
+        void    async_listen(const std::string& hostname, ushort port, bool use_IPv6 = false)
+        {
+            this->get_resolver()->resolve(hostname, use_IPv6 ? AF_INET6 : AF_INET,
+                [this, port, use_IPv6](addrinfo_result result, const socket_address& address, int gai_error)
+                {
+                    if (result != addrinfo_result::SUCCESS)
+                    {
+                        this->template execute<basic_actions::ERROR>("getaddrinfo", gai_error);
+                        return ;
+                    }
+
+                    server_connection_type* socket = this->open_listener(use_IPv6);
+                    if (socket == nullptr)
+                        return ;
+                    socket->address = address;
+                    this->listen_resolved(socket, port, use_IPv6);
                 }
             );
+        }
 
 
-            if (addrinfo_result::SUCCESS != socket_address::addrinfo(socket->address, hostname, use_IPv6 ? AF_INET6 : AF_INET))
+        /**
+         * @brief   sets the resolver used by async_listen()
+         * 
+         * @note    a resolver shared between entities must not call back an entity that was destroyed,
+         *          entities must outlive their pending lookups
+         */
+        void    set_resolver(std::shared_ptr<unisock::resolver> resolver)
+        {
+            this->async_resolver = resolver;
+        }
+
+
+        /**
+         * @brief returns the resolver used by async_listen(), creates one on the handler of this server if none was set
+         */
+        std::shared_ptr<unisock::resolver>  get_resolver()
+        {
+            if (!this->async_resolver)
+                this->async_resolver = std::make_shared<unisock::resolver>(get_handler());
+            return (this->async_resolver);
+        }
+
+
+        /**
+         * @brief maximum time a handoff waits for the other process, in seconds
+         */
+        static constexpr time_t HANDOFF_TIMEOUT = 5;
+
+        /**
+         * @brief   lets a replacement process take over the listeners of this server with adopt() (hot restart)
+         * 
+         * @details opens a unix domain socket on **path**, polled by the handler of this server. when the replacement process
+         *          connects with adopt(), the listeners (and the accepted clients if **include_clients** is set) are passed
+         *          to it with SCM_RIGHTS. once the replacement acknowledged them, they are closed in this process
+         *          (common_actions::CLOSED and server_actions::DISCONNECT are executed for them), the handoff socket is closed
+         *          and server_actions::HANDOFF is executed. connections waiting in the accept queue are accepted by the replacement.\n
+         *          if the transfer fails, basic_actions::ERROR is executed and this server keeps its sockets and waits for another replacement.
+         * 
+         * @note    the handoff is done synchronously from events::poll and waits at most HANDOFF_TIMEOUT for the replacement,
+         *          messages queued in send buffers of handed clients are dropped
+         * 
+         * @param path              path of the handoff socket file, or name of the abstract address
+         * @param abstract          use the abstract namespace (linux only) instead of the filesystem
+         * @param include_clients   also hand accepted clients
+         * 
+         * @return false if the handoff socket could not be opened (error is called in basic_actions::ERROR hook)
+         */
+        bool    enable_handoff(const std::string& path, bool abstract = false, bool include_clients = false)
+        {
+            this->disable_handoff();
+
+            socket_address  address;
+            if (!socket_address::unix_address(address, path, abstract))
             {
-                this->template execute<basic_actions::ERROR>("getaddrinfo", errno);
-                socket->close();
-                // this->server_container_type::delete_socket(socket->get_socket());
+                this->template execute<basic_actions::ERROR>("unix_address", errno);
                 return false;
             }
-            if (!use_IPv6)
-                socket->address.template to<sockaddr_in>()->sin_port = htons(port);
-            else
-                socket->address.template to<sockaddr_in6>()->sin6_port = htons(port);
+            if (!abstract)
+                server_impl::remove_stale_socket(address, SOCK_STREAM);
 
-            if (!socket->bind())
+            const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (socket < 0)
+            {
+                this->template execute<basic_actions::ERROR>("socket", errno);
+                return false;
+            }
+            ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+            if (0 > ::bind(socket, address.to<sockaddr>(), address.size()) || 0 > ::listen(socket, 1))
             {
                 this->template execute<basic_actions::ERROR>("bind", errno);
-                socket->close();
-                // this->server_container_type::delete_socket(socket->get_socket());
+                ::close(socket);
                 return false;
             }
 
-            if (!socket->listen())
+            this->handoff_listener.reset(new handoff_socket_type(get_handler(), socket));
+            this->handoff_listener->set_dispatch(&server_impl::dispatch_handoff, &socket_base::dispatch_writeable, this);
+            get_handler()->add_socket(socket, this->handoff_listener.get());
+            this->handoff_path = abstract ? std::string() : path;
+            this->handoff_clients = include_clients;
+            return (true);
+        }
+
+        /**
+         * @brief closes the handoff socket opened by enable_handoff(), and removes its socket file
+         */
+        void    disable_handoff()
+        {
+            if (!this->handoff_listener)
+                return ;
+
+            get_handler()->delete_socket(this->handoff_listener->get_socket());
+            this->handoff_listener->socket_base::close();
+            this->handoff_listener.reset();
+            if (!this->handoff_path.empty())
+                ::unlink(this->handoff_path.c_str());
+            this->handoff_path.clear();
+        }
+
+        /**
+         * @brief   takes over the listeners (and clients) of a server running in another process, see enable_handoff()
+         * 
+         * @details connects to the handoff socket **path** of the running server and receives its sockets.
+         *          server_actions::LISTEN is executed for each adopted listener and server_actions::ACCEPT for each adopted client,
+         *          like for sockets opened by this server. sockets are only adopted once the running server closed its copies.
+         * 
+         * @note    blocks until the sockets are received, at most HANDOFF_TIMEOUT for each step of the transfer
+         * 
+         * @param path      path of the handoff socket file, or name of the abstract address
+         * @param abstract  use the abstract namespace (linux only) instead of the filesystem
+         * 
+         * @return false if the sockets could not be adopted (error is called in basic_actions::ERROR hook),
+         *         the running server then keeps its sockets
+         */
+        bool    adopt(const std::string& path, bool abstract = false)
+        {
+            socket_address  address;
+            if (!socket_address::unix_address(address, path, abstract))
             {
-                this->template execute<basic_actions::ERROR>("listen", errno);
-                socket->close();
-                // this->server_container_type::delete_socket(socket->get_socket());
+                this->template execute<basic_actions::ERROR>("unix_address", errno);
                 return false;
             }
 
-            // receive events with accept 
-            socket->template on<unisock::basic_actions::READABLE>(
-                [this, socket]() {
-                    this->accept(socket);
+            const int peer = server_impl::open_handoff_peer(::socket(AF_UNIX, SOCK_STREAM, 0));
+            if (peer < 0)
+            {
+                this->template execute<basic_actions::ERROR>("socket", errno);
+                return false;
+            }
+            if (0 > ::connect(peer, address.to<sockaddr>(), address.size()))
+            {
+                this->template execute<basic_actions::ERROR>("connect", errno);
+                ::close(peer);
+                return false;
+            }
+
+            std::vector<int>    listeners;
+            std::vector<int>    clients;
+            handoff_record      record { HANDOFF_END, 0 };
+            bool                received = false;
+            do
+            {
+                std::vector<int>    fds;
+                const ssize_t       n_bytes = _lib::recv_fds(peer, &record, sizeof(record), MSG_WAITALL, fds);
+                std::vector<int>&   adopted = (record.kind == HANDOFF_CLIENTS ? clients : listeners);
+                adopted.insert(adopted.end(), fds.begin(), fds.end());
+                if (n_bytes != sizeof(record) || fds.size() != record.count
+                    || (record.kind != HANDOFF_LISTENERS && record.kind != HANDOFF_CLIENTS && record.kind != HANDOFF_END))
+                {
+                    errno = (n_bytes < 0 ? errno : EPROTO);
+                    break ;
                 }
-            );
+                received = (record.kind == HANDOFF_END);
+            }
+            while (!received);
 
-            // execute handler on listen
-            this->template execute<server_actions::LISTEN>(reinterpret_cast<server_connection*>(socket));
+            // acknowledges the sockets, then waits for the running server to close its copies
+            if (received)
+            {
+                const handoff_record    ack { HANDOFF_END, 0 };
+                char                    eof;
+                received = (sizeof(ack) == ::send(peer, &ack, sizeof(ack), HANDOFF_SEND_FLAGS)
+                            && 0 == ::recv(peer, &eof, sizeof(eof), 0));
+                if (!received && errno == 0)
+                    errno = EPROTO;
+            }
+            if (!received)
+            {
+                this->template execute<basic_actions::ERROR>("adopt", errno);
+                for (int fd : listeners)
+                    ::close(fd);
+                for (int fd : clients)
+                    ::close(fd);
+                ::close(peer);
+                return false;
+            }
+            ::close(peer);
+
+            for (int fd : listeners)
+                this->adopt_listener(fd);
+            for (int fd : clients)
+                this->adopt_client(fd);
             return (true);
         }
 
@@ -298,10 +540,10 @@ class server_impl   <
             assert(connection != nullptr);
             assert(connection->get_socket() >= 0);
 
-            socket_address  address;
-            // address size is only needded for accept here since real address size will also be written to address._address.sa_len
-            socklen_t       address_size = socket_address::ADDRESS_STORAGE_SIZE;
-            int socket = ::accept(connection->get_socket(), address.to<sockaddr>(), &address_size);
+            // not cleared, only the address_size bytes written by accept are copied to the connection
+            sockaddr_storage    address;
+            socklen_t           address_size = socket_address::ADDRESS_STORAGE_SIZE;
+            int socket = ::accept(connection->get_socket(), reinterpret_cast<sockaddr*>(&address), &address_size);
             if (socket < 0)
             {
                 this->template execute<basic_actions::ERROR>("accept", errno);
@@ -316,7 +558,174 @@ class server_impl   <
                 return ;
             }
             
-            client->address = address;
+            // address of a new connection is zeroed, copies only the accepted address instead of the whole storage
+            std::memcpy(client->address.template to<sockaddr>(), &address, std::min<size_t>(address_size, sizeof(address)));
+            client->address.set_size(address_size);
+            this->start_client(client);
+        }
+
+
+    protected:
+        /**
+         * @brief type of the handoff socket, only used to be polled by the handler
+         */
+        using handoff_socket_type = unisock::socket<events::actions_list<>, entity_model<>>;
+
+        /**
+         * @brief   message of the handoff protocol, followed by **count** file descriptors of **kind**
+         * 
+         * @details the running server sends records of HANDOFF_LISTENERS then HANDOFF_CLIENTS, and a HANDOFF_END record,
+         *          the replacement acknowledges with a HANDOFF_END record, then the running server closes the connection
+         */
+        struct  handoff_record
+        {
+            uint32_t    kind;
+            uint32_t    count;
+        };
+
+        static constexpr uint32_t   HANDOFF_END = 0;
+        static constexpr uint32_t   HANDOFF_LISTENERS = 1;
+        static constexpr uint32_t   HANDOFF_CLIENTS = 2;
+
+#if defined(MSG_NOSIGNAL)
+        static constexpr int        HANDOFF_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        static constexpr int        HANDOFF_SEND_FLAGS = 0;
+#endif
+
+        /**
+         * @brief   sets the options of a handoff connection: blocking, close on exec, HANDOFF_TIMEOUT and no SIGPIPE
+         * 
+         * @return **socket**, -1 if **socket** is -1
+         */
+        static int  open_handoff_peer(int socket)
+        {
+            if (socket < 0)
+                return (-1);
+
+            const timeval   timeout { HANDOFF_TIMEOUT, 0 };
+            ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL) & ~O_NONBLOCK);
+            ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+            ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+            int enable = 1;
+            ::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+            return (socket);
+        }
+
+        /**
+         * @brief   sends **fds** in records of **kind**, at most control_buffer::MAX_FDS per record
+         * 
+         * @return false on send error
+         */
+        static bool send_handoff_fds(int peer, uint32_t kind, const std::vector<int>& fds)
+        {
+            for (size_t sent = 0; sent < fds.size(); )
+            {
+                const size_t            count = std::min(fds.size() - sent, control_buffer::MAX_FDS);
+                const handoff_record    record { kind, static_cast<uint32_t>(count) };
+                if (sizeof(record) != _lib::send_fds(peer, fds.data() + sent, count, &record, sizeof(record), HANDOFF_SEND_FLAGS))
+                    return (false);
+                sent += count;
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   hands the sockets of this server to the replacement process connecting to the handoff socket
+         */
+        void    handoff()
+        {
+            const int peer = server_impl::open_handoff_peer(::accept(this->handoff_listener->get_socket(), nullptr, nullptr));
+            if (peer < 0)
+            {
+                this->template execute<basic_actions::ERROR>("accept", errno);
+                return ;
+            }
+
+            const std::vector<int>  listeners = this->listeners_container.get_sockets();
+            const std::vector<int>  clients = this->handoff_clients ? this->clients_container.get_sockets() : std::vector<int>();
+            const handoff_record    end { HANDOFF_END, 0 };
+            handoff_record          ack { HANDOFF_LISTENERS, 0 };
+
+            errno = 0;
+            if (!server_impl::send_handoff_fds(peer, HANDOFF_LISTENERS, listeners)
+                || !server_impl::send_handoff_fds(peer, HANDOFF_CLIENTS, clients)
+                || sizeof(end) != _lib::send_fds(peer, nullptr, 0, &end, sizeof(end), HANDOFF_SEND_FLAGS)
+                || sizeof(ack) != ::recv(peer, &ack, sizeof(ack), MSG_WAITALL)
+                || ack.kind != HANDOFF_END)
+            {
+                // the replacement did not take the sockets, this server keeps serving
+                this->template execute<basic_actions::ERROR>("handoff", errno != 0 ? errno : EPROTO);
+                ::close(peer);
+                return ;
+            }
+
+            // the replacement waits for this close to start using the sockets
+            this->disable_handoff();
+            if (this->handoff_clients)
+                this->clients_container.close();
+            this->listeners_container.close();
+            ::close(peer);
+
+            this->template execute<server_actions::HANDOFF>(listeners.size() + clients.size());
+        }
+
+        /**
+         * @brief readable dispatch of the handoff socket, see enable_handoff
+         */
+        static void dispatch_handoff(socket_base* socket, void* context)
+        {
+            (void)socket;
+            static_cast<server_impl*>(context)->handoff();
+        }
+
+        /**
+         * @brief   makes the listening socket **fd** received by adopt() a listener of this server
+         */
+        void    adopt_listener(int fd)
+        {
+            server_connection_type* socket = this->listeners_container.make_socket(fd);
+            if (socket == nullptr)
+            {
+                ::close(fd);
+                this->template execute<basic_actions::ERROR>("insert", 0);
+                return ;
+            }
+
+            socklen_t address_size = socket_address::ADDRESS_STORAGE_SIZE;
+            if (0 == ::getsockname(fd, socket->address.template to<sockaddr>(), &address_size))
+                socket->address.set_size(address_size);
+            this->track_listener(socket);
+            this->start_accepting(socket);
+        }
+
+        /**
+         * @brief   makes the connected socket **fd** received by adopt() a client of this server
+         */
+        void    adopt_client(int fd)
+        {
+            client_connection_type* client = this->clients_container.make_socket(fd);
+            if (client == nullptr)
+            {
+                ::close(fd);
+                this->template execute<basic_actions::ERROR>("insert", 0);
+                return ;
+            }
+
+            socklen_t address_size = socket_address::ADDRESS_STORAGE_SIZE;
+            if (0 == ::getpeername(fd, client->address.template to<sockaddr>(), &address_size))
+                client->address.set_size(address_size);
+            this->start_client(client);
+        }
+
+        /**
+         * @brief sets the hooks of the accepted **client**, and executes server_actions::ACCEPT
+         */
+        void    start_client(client_connection_type* client)
+        {
             client->template on<unisock::basic_actions::READABLE>(
                 [client]() {
                     client->recv();
@@ -328,6 +737,7 @@ class server_impl   <
                     client->send_flush();
                 }
             );
+            client->set_dispatch(&client_connection_type::dispatch_recv, &client_connection_type::dispatch_send_flush);
 
             client->template on<unisock::basic_actions::CLOSED>(
                 [this, client]() {
@@ -345,9 +755,171 @@ class server_impl   <
         }
 
 
+        /**
+         * @brief   opens a new listener socket, executes basic_actions::ERROR on failure
+         * 
+         * @return the listener, nullptr if the socket could not be opened
+         */
+        server_connection_type* open_listener(bool use_IPv6)
+        {
+            return (this->open_listener(use_IPv6 ? AF_INET6 : AF_INET, SOCK_STREAM));
+        }
+
+
+        /**
+         * @brief   opens a new listener socket of **domain** and **type**, executes basic_actions::ERROR on failure
+         * 
+         * @return the listener, nullptr if the socket could not be opened
+         */
+        server_connection_type* open_listener(int domain, int type)
+        {
+            server_connection_type* socket { this->listeners_container.make_socket(domain, type, 0) };
+            if (socket == nullptr)
+            {
+                this->template execute<basic_actions::ERROR>("socket", errno);
+                return nullptr;
+            }
+
+            // setting on closed action here so that common_actions::CLOSED hook is called on listen failure
+            this->track_listener(socket);
+            return (socket);
+        }
+
+
+        /**
+         * @brief executes common_actions::CLOSED when the listener **socket** is closed
+         */
+        void    track_listener(server_connection_type* socket)
+        {
+            socket->template on<unisock::basic_actions::CLOSED>(
+                [this, socket]() {
+                    this->template execute<common_actions::CLOSED>(reinterpret_cast<server_connection*>(socket));
+                }
+            );
+        }
+
+
+        /**
+         * @brief   binds **socket** to its resolved address on **port**, and starts listening on it
+         * 
+         * @return false if server was not able to listen on address, **socket** is then closed
+         */
+        bool    listen_resolved(server_connection_type* socket, ushort port, bool use_IPv6)
+        {
+            if (!use_IPv6)
+                socket->address.template to<sockaddr_in>()->sin_port = htons(port);
+            else
+                socket->address.template to<sockaddr_in6>()->sin6_port = htons(port);
+
+            return (this->start_listening(socket));
+        }
+
+
+        /**
+         * @brief   binds **socket** to its address, and starts listening on it
+         * 
+         * @return false if server was not able to listen on address, **socket** is then closed
+         */
+        bool    start_listening(server_connection_type* socket)
+        {
+            if (!socket->bind())
+            {
+                this->template execute<basic_actions::ERROR>("bind", errno);
+                socket->close();
+                // this->server_container_type::delete_socket(socket->get_socket());
+                return false;
+            }
+
+            if (!socket->listen())
+            {
+                this->template execute<basic_actions::ERROR>("listen", errno);
+                socket->close();
+                // this->server_container_type::delete_socket(socket->get_socket());
+                return false;
+            }
+
+            this->start_accepting(socket);
+            return (true);
+        }
+
+
+        /**
+         * @brief sets the hooks of the listening **socket**, and executes server_actions::LISTEN
+         */
+        void    start_accepting(server_connection_type* socket)
+        {
+            // receive events with accept 
+            socket->template on<unisock::basic_actions::READABLE>(
+                [this, socket]() {
+                    this->accept(socket);
+                }
+            );
+            socket->set_dispatch(&server_impl::dispatch_accept, &socket_base::dispatch_writeable, this);
+
+            // execute handler on listen
+            this->template execute<server_actions::LISTEN>(reinterpret_cast<server_connection*>(socket));
+        }
+
+
+        /**
+         * @brief   removes the socket file of **address** if no server accepts connections on it anymore
+         * 
+         * @details bind fails with EADDRINUSE on a socket file left by a server that exited without removing it,
+         *          the file is only removed if connecting to it is refused, so that a running server is never taken over.\n
+         *          the probe uses the **type** of the listener, connecting with another type is refused even if a server is running
+         */
+        static void remove_stale_socket(const socket_address& address, int type)
+        {
+            const char* path = address.template to<sockaddr_un>()->sun_path;
+            struct stat file;
+            if (0 > ::lstat(path, &file) || !S_ISSOCK(file.st_mode))
+                return ;
+
+            const int   probe = ::socket(AF_UNIX, type, 0);
+            if (probe < 0)
+                return ;
+            const int   connected = ::connect(probe, address.template to<sockaddr>(), address.size());
+            const int   error = errno;
+            ::close(probe);
+            if (connected < 0 && error == ECONNREFUSED)
+                ::unlink(path);
+        }
+
+
+        /**
+         * @brief direct readable dispatch of listeners sockets, see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready listener
+         * @param context   the server_impl owning the listener
+         */
+        static void dispatch_accept(socket_base* socket, void* context)
+        {
+            static_cast<server_impl*>(context)->accept(static_cast<server_connection_type*>(socket));
+        }
+
     private:
         server_container_type   listeners_container;
         client_container_type   clients_container;
+
+        /**
+         * @brief resolver of async_listen(), created on first use
+         */
+        std::shared_ptr<unisock::resolver>  async_resolver;
+
+        /**
+         * @brief handoff socket opened by enable_handoff()
+         */
+        std::unique_ptr<handoff_socket_type>    handoff_listener;
+
+        /**
+         * @brief path of the handoff socket file, removed by disable_handoff(), empty for abstract addresses
+         */
+        std::string                             handoff_path;
+
+        /**
+         * @brief hand accepted clients with the listeners
+         */
+        bool                                    handoff_clients = false;
 };
 
 
@@ -0,0 +1,647 @@
+/**
+ * @file sessions.hpp
+ * @author ROBINO Luca
+ * @brief  per-peer sessions for udp servers
+ * @version 1.0
+ * @date 2024-02-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "udp/socket.hpp"
+#include "socket/inet_address.hpp"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace udp {
+
+/**
+ * @brief   actions tags to hook udp::session_server action_handler events
+ *
+ * @details defines structs as tags for actions of action_handler,
+ *          this tags can be used on the on() and execute() members
+ *          of udp::session_server
+ *
+ * @ref udp::session_server
+ * @ref udp::session_server_impl
+ *
+ * @ref events::action_handler
+ *
+ * @addindex
+ */
+namespace session_actions
+{
+    /**
+     * @brief   a datagram was received from a peer that has no session, a session was created
+     *
+     * @details this event is called before RECEIVE for the first datagram of the peer
+     *
+     * @note    hook prototype: ```void (udp::session_server::session_type* session)```
+     */
+    struct  NEW_PEER
+    {
+        static constexpr const char* action_name = "udp::NEW_PEER";
+        static constexpr const char* callback_prototype = "void (session*)";
+    };
+
+    /**
+     * @brief   a datagram was received from the peer of a session
+     *
+     * @note    hook prototype: ```void (udp::session_server::session_type* session, const char* message, size_t message_len)```
+     */
+    struct  RECEIVE
+    {
+        static constexpr const char* action_name = "udp::SESSION_RECEIVE";
+        static constexpr const char* callback_prototype = "void (session*, const char*, size_t)";
+    };
+
+    /**
+     * @brief   a session was idle for longer than the idle timeout and is deleted after this call
+     *
+     * @note    hook prototype: ```void (udp::session_server::session_type* session)```
+     */
+    struct  PEER_EXPIRED
+    {
+        static constexpr const char* action_name = "udp::PEER_EXPIRED";
+        static constexpr const char* callback_prototype = "void (session*)";
+    };
+} // ******** namespace session_actions
+
+
+/**
+ * @brief   actions of udp::session_server, added to udp::socket actions
+ *
+ * @tparam _Session             session type
+ * @tparam _ExtendedActions     additional actions
+ */
+template<typename _Session, typename ..._ExtendedActions>
+using session_actions_list = unisock::events::actions_list<
+    events::action<session_actions::NEW_PEER,
+        std::function<void (_Session*)> >,
+
+    events::action<session_actions::RECEIVE,
+        std::function<void (_Session*, const char*, size_t)> >,
+
+    events::action<session_actions::PEER_EXPIRED,
+        std::function<void (_Session*)> >,
+
+    _ExtendedActions...
+>;
+
+
+template<typename _Session>
+class session_table;
+
+
+/**
+ * @brief   state of a peer of a udp::session_server
+ *
+ * @tparam _SessionData data types to merge in session::data, like unisock::socket data
+ */
+template<typename ..._SessionData>
+class session
+{
+    public:
+        /**
+         * @brief creates a session for **address**
+         */
+        explicit session(const socket_address& address)
+        : key(address), address(address)
+        {}
+
+        session(const session& copy) = delete;
+
+        /**
+         * @brief compact address of the peer, compared by session_table lookups
+         */
+        const inet_address      key;
+
+        /**
+         * @brief address of the peer
+         */
+        const socket_address    address;
+
+        /**
+         * @brief time of the last datagram received from the peer
+         */
+        std::chrono::steady_clock::time_point   last_activity;
+
+        /**
+         * @brief data class for session
+         * @details merge all types of _SessionData parameter pack by inheriting them publicly
+         */
+        class : public _SessionData... {}
+        /**
+         * @brief data field of the session
+         */
+        data;
+
+    private:
+        /**
+         * @brief hash of key, cached for session_table
+         */
+        size_t      hash = 0;
+
+        /**
+         * @brief previous session in session_table activity order
+         */
+        session*    previous = nullptr;
+
+        /**
+         * @brief next session in session_table activity order
+         */
+        session*    next = nullptr;
+
+        /**
+         * @brief friend with session_table to manage hash and activity list
+         */
+        friend class session_table<session>;
+};
+
+
+/**
+ * @brief   hash table of sessions keyed by inet_address
+ *
+ * @details open addressing with linear probing and backward shift deletion, capacity is a power of two.
+ *          lookups compare the 20 bytes inet_address of sessions instead of their socket_address.
+ *          sessions are allocated once and keep their address until erased, so that hooks can keep pointers to them.
+ *          sessions are also linked in activity order (see touch) to find idle sessions without scanning the table.
+ *
+ * @tparam _Session session type, see udp::session
+ */
+template<typename _Session>
+class session_table
+{
+    public:
+        /**
+         * @brief minimum number of slots of the table
+         */
+        static constexpr size_t MIN_CAPACITY = 16;
+
+        /**
+         * @brief creates an empty table
+         *
+         * @param capacity  initial number of slots, rounded up to a power of two
+         */
+        explicit session_table(size_t capacity = MIN_CAPACITY)
+        : slots(round_capacity(capacity))
+        {}
+
+        session_table(const session_table& copy) = delete;
+
+        /**
+         * @brief deletes all sessions
+         */
+        ~session_table()
+        {
+            clear();
+        }
+
+        /**
+         * @brief returns the number of sessions
+         */
+        size_t      size() const
+        {
+            return (count);
+        }
+
+        /**
+         * @brief   returns the session of **key**
+         *
+         * @param key   compact address of the peer
+         * @param hash  key.hash(), same as socket_address::hash() of the peer
+         *
+         * @return the session or nullptr if **key** has no session
+         */
+        _Session*   find(const inet_address& key, size_t hash) const
+        {
+            const size_t mask = slots.size() - 1;
+            for (size_t index = hash & mask; slots[index].session != nullptr; index = (index + 1) & mask)
+            {
+                if (slots[index].hash == hash && slots[index].session->key == key)
+                    return (slots[index].session);
+            }
+            return (nullptr);
+        }
+
+        /**
+         * @brief returns the session of **address** or nullptr
+         */
+        _Session*   find(const socket_address& address) const
+        {
+            const inet_address key { address };
+            return (find(key, key.hash()));
+        }
+
+        /**
+         * @brief   creates the session of **address**, **address** must not have a session
+         *
+         * @param address   address of the peer
+         * @param hash      address.hash(), same as inet_address(address).hash()
+         *
+         * @return the new session, most recently active
+         */
+        _Session*   insert(const socket_address& address, size_t hash)
+        {
+            // keeps load factor under 3/4
+            if ((count + 1) * 4 > slots.size() * 3)
+                resize(slots.size() * 2);
+
+            _Session* session = new _Session(address);
+            session->hash = hash;
+            place(session);
+            link_back(session);
+            ++count;
+            return (session);
+        }
+
+        /**
+         * @brief   removes **session** from the table without deleting it
+         *
+         * @return  **session**, owned by the caller
+         */
+        _Session*   release(_Session* session)
+        {
+            const size_t mask = slots.size() - 1;
+            size_t index = session->hash & mask;
+            while (slots[index].session != session)
+                index = (index + 1) & mask;
+
+            // backward shift: moves following entries of the probe sequence into the hole
+            for (size_t next = (index + 1) & mask; slots[next].session != nullptr; next = (next + 1) & mask)
+            {
+                const size_t ideal = slots[next].hash & mask;
+                if (((next - ideal) & mask) >= ((next - index) & mask))
+                {
+                    slots[index] = slots[next];
+                    index = next;
+                }
+            }
+            slots[index] = slot {};
+
+            unlink(session);
+            --count;
+            return (session);
+        }
+
+        /**
+         * @brief removes and deletes **session**
+         */
+        void        erase(_Session* session)
+        {
+            delete release(session);
+        }
+
+        /**
+         * @brief deletes all sessions
+         */
+        void        clear()
+        {
+            while (oldest != nullptr)
+                erase(oldest);
+        }
+
+        /**
+         * @brief sets the last activity of **session** to **now**, making it the most recently active session
+         */
+        void        touch(_Session* session, std::chrono::steady_clock::time_point now)
+        {
+            session->last_activity = now;
+            if (session != newest)
+            {
+                unlink(session);
+                link_back(session);
+            }
+        }
+
+        /**
+         * @brief returns the least recently active session, nullptr if table is empty
+         */
+        _Session*   least_recent() const
+        {
+            return (oldest);
+        }
+
+    private:
+        /**
+         * @brief slot of the table, empty when session is nullptr
+         */
+        struct slot
+        {
+            size_t      hash = 0;
+            _Session*   session = nullptr;
+        };
+
+        /**
+         * @brief returns the smallest power of two greater or equal to **capacity** and MIN_CAPACITY
+         */
+        static size_t   round_capacity(size_t capacity)
+        {
+            size_t rounded = MIN_CAPACITY;
+            while (rounded < capacity)
+                rounded *= 2;
+            return (rounded);
+        }
+
+        /**
+         * @brief puts **session** in the first free slot of its probe sequence
+         */
+        void        place(_Session* session)
+        {
+            const size_t mask = slots.size() - 1;
+            size_t index = session->hash & mask;
+            while (slots[index].session != nullptr)
+                index = (index + 1) & mask;
+            slots[index].hash = session->hash;
+            slots[index].session = session;
+        }
+
+        /**
+         * @brief rehashes all sessions in **capacity** slots
+         */
+        void        resize(size_t capacity)
+        {
+            std::vector<slot> old_slots(capacity);
+            old_slots.swap(slots);
+            for (const slot& old : old_slots)
+            {
+                if (old.session != nullptr)
+                    place(old.session);
+            }
+        }
+
+        /**
+         * @brief appends **session** at the most recent end of the activity list
+         */
+        void        link_back(_Session* session)
+        {
+            session->previous = newest;
+            session->next = nullptr;
+            if (newest != nullptr)
+                newest->next = session;
+            else
+                oldest = session;
+            newest = session;
+        }
+
+        /**
+         * @brief removes **session** from the activity list
+         */
+        void        unlink(_Session* session)
+        {
+            if (session->previous != nullptr)
+                session->previous->next = session->next;
+            else
+                oldest = session->next;
+            if (session->next != nullptr)
+                session->next->previous = session->previous;
+            else
+                newest = session->previous;
+            session->previous = nullptr;
+            session->next = nullptr;
+        }
+
+        /**
+         * @brief slots of the table, size is a power of two
+         */
+        std::vector<slot>   slots;
+
+        /**
+         * @brief number of sessions
+         */
+        size_t              count = 0;
+
+        /**
+         * @brief least recently active session
+         */
+        _Session*           oldest = nullptr;
+
+        /**
+         * @brief most recently active session
+         */
+        _Session*           newest = nullptr;
+};
+
+
+template<typename ..._Args>
+class session_server_impl;
+
+
+/**
+ * @brief type alias for session_server_impl with no extended actions and no session data
+ */
+using session_server = session_server_impl<
+                                            unisock::events::actions_list</* no extended actions */>,
+                                            unisock::entity_model</* no extended session data */>
+                                          >;
+
+/**
+ * @brief type alias for session_server_impl with custom session data
+ *
+ * @tparam _SessionData data to add to sessions
+ */
+template<typename ..._SessionData>
+using session_server_of = session_server_impl<
+                                                unisock::events::actions_list</* no extended actions */>,
+                                                unisock::entity_model<_SessionData...>
+                                             >;
+
+
+/**
+ * @brief   udp socket keeping a session per peer
+ *
+ * @details each datagram received is routed to the session of its sender, a session is created (NEW_PEER) for unknown senders,
+ *          and sessions idle for longer than the idle timeout are deleted (PEER_EXPIRED).\n
+ *          idle sessions are expired when a datagram is received and when expire() is called, a server with no traffic
+ *          should call expire() periodically (see events::run_until).
+ *
+ * @tparam _ExtendedActions     additional actions
+ * @tparam _SessionData         data types to add to sessions
+ */
+template<typename ..._ExtendedActions, typename ..._SessionData>
+class session_server_impl<
+                            unisock::events::actions_list   <_ExtendedActions...>,
+                            unisock::entity_model           <_SessionData...>
+                         >
+    :   public udp::socket_impl<
+                                session_actions_list<udp::session<_SessionData...>, _ExtendedActions...>,
+                                unisock::entity_model<>
+                               >
+{
+    public:
+        /**
+         * @brief type of the sessions of this server
+         */
+        using session_type = udp::session<_SessionData...>;
+
+        /**
+         * @brief type of the base udp socket
+         */
+        using base_type = udp::socket_impl<
+                                            session_actions_list<session_type, _ExtendedActions...>,
+                                            unisock::entity_model<>
+                                          >;
+
+        /**
+         * @brief clock used for sessions activity
+         */
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * @brief empty constructor, server will be self-handeled
+         */
+        session_server_impl()
+        : base_type()
+        {
+            this->init_sessions();
+        }
+
+        /**
+         * @brief constructor with handler, server will be handeled by an external handler
+         *
+         * @param handler handler to use for managing event on this server
+         */
+        session_server_impl(std::shared_ptr<events::handler> handler)
+        : base_type(handler)
+        {
+            this->init_sessions();
+        }
+
+        /**
+         * @brief   sets the time after which a session without datagrams expires
+         *
+         * @param timeout   idle timeout, 0 disables expiry
+         */
+        template<typename _Rep, typename _Period>
+        void    set_idle_timeout(std::chrono::duration<_Rep, _Period> timeout)
+        {
+            this->idle_timeout = std::chrono::duration_cast<clock::duration>(timeout);
+        }
+
+        /**
+         * @brief   expires sessions idle since **now** - idle timeout, calls PEER_EXPIRED for each of them
+         *
+         * @param now   current time
+         *
+         * @return number of expired sessions
+         */
+        size_t  expire(clock::time_point now = clock::now())
+        {
+            if (this->idle_timeout.count() <= 0)
+                return (0);
+
+            size_t n_expired = 0;
+            for (session_type* oldest = sessions.least_recent(); oldest != nullptr; oldest = sessions.least_recent())
+            {
+                if (now - oldest->last_activity < this->idle_timeout)
+                    break ;
+
+                // removed from the table first, hooks cannot find or remove it again
+                std::unique_ptr<session_type> expired { sessions.release(oldest) };
+                this->template execute<session_actions::PEER_EXPIRED>(expired.get());
+                ++n_expired;
+            }
+            return (n_expired);
+        }
+
+        /**
+         * @brief returns the session of **address**, nullptr if **address** has no session
+         */
+        session_type*   get_session(const socket_address& address) const
+        {
+            return (sessions.find(address));
+        }
+
+        /**
+         * @brief deletes **session** without calling PEER_EXPIRED, next datagram of its peer creates a new session
+         */
+        void    remove_session(session_type* session)
+        {
+            sessions.erase(session);
+        }
+
+        /**
+         * @brief returns the number of sessions
+         */
+        size_t  session_count() const
+        {
+            return (sessions.size());
+        }
+
+        /**
+         * @brief sends **message** of size **message_len** to the peer of **session**, see udp::socket_impl::send_to
+         */
+        bool    send_to(session_type* session, const char* message, size_t message_len, int flags = 0)
+        {
+            return (this->base_type::send_to(session->address, message, message_len, flags));
+        }
+
+        using base_type::send_to;
+
+    private:
+        /**
+         * @brief routes received datagrams to sessions
+         */
+        void    init_sessions()
+        {
+            this->template on<udp::actions::RECEIVE>(
+                [this](const socket_address& address, const char* message, size_t message_len){
+                    this->receive_from(address, message, message_len);
+                }
+            );
+        }
+
+        /**
+         * @brief   finds or creates the session of **address**, then calls back RECEIVE with the session
+         */
+        void    receive_from(const socket_address& address, const char* message, size_t message_len)
+        {
+            const clock::time_point now = clock::now();
+            this->expire(now);
+
+            const inet_address  key { address };
+            const size_t        hash = key.hash();
+            session_type*       session = sessions.find(key, hash);
+            if (session == nullptr)
+            {
+                session = sessions.insert(address, hash);
+                sessions.touch(session, now);
+                this->template execute<session_actions::NEW_PEER>(session);
+                // the session may have been removed by the hook
+                session = sessions.find(key, hash);
+                if (session == nullptr)
+                    return ;
+            }
+            else
+                sessions.touch(session, now);
+
+            this->template execute<session_actions::RECEIVE>(session, message, message_len);
+        }
+
+        /**
+         * @brief sessions of this server
+         */
+        session_table<session_type>     sessions;
+
+        /**
+         * @brief idle timeout of sessions, 0 disables expiry
+         */
+        clock::duration                 idle_timeout { 0 };
+};
+
+
+} // ******** namespace udp
+
+} // ******** namespace unisock
@@ -0,0 +1,420 @@
+/**
+ * @file sharded.hpp
+ * @author ROBINO Luca
+ * @brief  udp socket sharded across threads with SO_REUSEPORT
+ * @version 1.0
+ * @date 2024-02-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "udp/socket.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+/**
+ * @addindex
+ */
+namespace unisock {
+
+/**
+ * @addindex
+ */
+namespace udp {
+
+/**
+ * @brief   selects the shard receiving a datagram in udp::sharded_socket_impl
+ */
+enum class shard_steering
+{
+    /**
+     * @brief kernel default, hash of the 4-tuple of the datagram: all datagrams of a flow go to the same shard
+     */
+    DEFAULT,
+
+    /**
+     * @brief   receive hash of the packet (RSS hash computed by the NIC) modulo the number of shards
+     *
+     * @details flow-consistent as DEFAULT, and keeps datagrams of a NIC receive queue on the same shard
+     */
+    FLOW_HASH,
+
+    /**
+     * @brief   cpu that received the packet modulo the number of shards
+     *
+     * @details threads started by sharded_socket_impl::start are pinned to the cpu of their shard,
+     *          so that datagrams are processed on the cpu where the kernel received them
+     */
+    CPU,
+};
+
+
+/**
+ * @brief   statistics of a udp::sharded_socket_impl shard, or aggregated for all shards
+ */
+struct shard_stats
+{
+    /**
+     * @brief number of datagrams received (RECEIVE events)
+     */
+    size_t  datagrams = 0;
+
+    /**
+     * @brief number of bytes received
+     */
+    size_t  bytes = 0;
+
+    /**
+     * @brief number of ERROR events
+     */
+    size_t  errors = 0;
+};
+
+
+/**
+ * @brief udp sharded socket definition with all args
+ *
+ * @tparam _Args any argument
+ */
+template<typename ..._Args>
+class sharded_socket_impl;
+
+
+/**
+ * @brief   one logical udp socket made of one SO_REUSEPORT socket per thread
+ *
+ * @details every shard is a udp::socket_impl bound to the same address with its own events::handler,
+ *          the kernel spreads received datagrams between shards (see shard_steering) so that each shard
+ *          can be drained by its own thread with start(), or by threads of the user with events::poll(shard(i)).\n
+ *          actions hooked with on() are hooked on every shard and are called from the thread polling the shard,
+ *          callbacks must be safe to call concurrently.
+ *
+ * @tparam _ExtendedActions actions added to the udp::socket actions
+ * @tparam _EntityData      data appended to each shard
+ */
+template<typename ..._ExtendedActions, typename ..._EntityData>
+class sharded_socket_impl<
+                            /* list of actions to be extended */
+                            unisock::events::actions_list   <_ExtendedActions...>,
+                            /* list of data type to model shards sockets */
+                            unisock::entity_model           <_EntityData...>
+                         >
+{
+    public:
+        /**
+         * @brief type of the socket of each shard
+         */
+        using shard_type = udp::socket_impl<
+                                            unisock::events::actions_list<_ExtendedActions...>,
+                                            unisock::entity_model<_EntityData...>
+                                           >;
+
+        /**
+         * @brief   creates **n_shards** unbound shards, each with its own events::handler
+         *
+         * @param n_shards  number of shards, number of cpus if 0
+         */
+        explicit sharded_socket_impl(size_t n_shards = 0)
+        {
+            if (n_shards == 0)
+                n_shards = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+            counters.reset(new shard_counters[n_shards]);
+            for (size_t index = 0; index < n_shards; ++index)
+            {
+                shards.emplace_back(new shard_type(std::make_shared<events::handler>()));
+                shard_counters& counter = counters[index];
+
+                shards.back()->template on<udp::actions::RECEIVE>(
+                    [&counter](const socket_address& address, const char* message, size_t message_len){
+                        (void)address;
+                        (void)message;
+                        counter.datagrams.fetch_add(1, std::memory_order_relaxed);
+                        counter.bytes.fetch_add(message_len, std::memory_order_relaxed);
+                    }
+                );
+                shards.back()->template on<basic_actions::ERROR>(
+                    [&counter](const std::string& function, int error){
+                        (void)function;
+                        (void)error;
+                        counter.errors.fetch_add(1, std::memory_order_relaxed);
+                    }
+                );
+            }
+        }
+
+        sharded_socket_impl(const sharded_socket_impl& copy) = delete;
+
+        /**
+         * @brief stops threads started by start() and closes shards
+         */
+        ~sharded_socket_impl()
+        {
+            this->close();
+        }
+
+        /**
+         * @brief   hooks **function** on action **_Action** of every shard
+         *
+         * @note    **function** is called from the threads polling the shards
+         */
+        template<typename _Action, typename _Function>
+        void    on(_Function function, ushort flags = events::action_flag::DEFAULT)
+        {
+            for (auto& shard : shards)
+                shard->template on<_Action>(function, flags);
+        }
+
+        /**
+         * @brief   binds every shard to **hostname** and **port** with SO_REUSEPORT
+         *
+         * @details if **port** is 0, the first shard is bound to an ephemeral port and the other shards to the same port.\n
+         *          the steering program for FLOW_HASH and CPU is attached to the group with SO_ATTACH_REUSEPORT_CBPF,
+         *          datagrams go to the shard bound at the returned index.
+         *
+         * @param hostname  address to bind
+         * @param port      port to bind
+         * @param use_IPv6  binds IPv6 sockets
+         * @param steering  selects the shard receiving a datagram, see shard_steering
+         *
+         * @return true if every shard was bound, false on error, the ERROR hook of the failing shard is called and all shards are closed
+         */
+        bool    bind(const std::string& hostname, int port, bool use_IPv6 = false, shard_steering steering = shard_steering::DEFAULT)
+        {
+            this->steering = steering;
+            for (auto& shard : shards)
+            {
+                shard->set_reuse_port(true);
+                if (!shard->bind(hostname, port, use_IPv6))
+                {
+                    this->close();
+                    return (false);
+                }
+                if (port == 0)
+                {
+                    // reads the ephemeral port picked by the kernel for the first shard
+                    sockaddr_storage    bound;
+                    socklen_t           bound_len = sizeof(bound);
+                    if (0 > ::getsockname(shard->get_socket(), reinterpret_cast<sockaddr*>(&bound), &bound_len))
+                    {
+                        this->close();
+                        return (false);
+                    }
+                    shard->address = socket_address(reinterpret_cast<const sockaddr*>(&bound), bound_len);
+                    port = shard->address.port();
+                }
+            }
+
+            if (steering != shard_steering::DEFAULT && !this->attach_steering(steering))
+            {
+                this->close();
+                return (false);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   starts one thread per shard, polling the shard until stop() is called
+         *
+         * @details with shard_steering::CPU, the thread of shard i is pinned to cpu i
+         *
+         * @param timeout   timeout of each events::poll in milliseconds, delays stop() at most by this amount
+         */
+        void    start(int timeout = 100)
+        {
+            if (!threads.empty())
+                return ;
+
+            running.store(true, std::memory_order_release);
+            for (size_t index = 0; index < shards.size(); ++index)
+            {
+                std::shared_ptr<events::handler> handler = shards[index]->get_handler();
+                threads.emplace_back([this, handler, timeout](){
+                    while (running.load(std::memory_order_acquire))
+                        events::poll(handler, timeout);
+                });
+#if defined(__linux__)
+                if (steering == shard_steering::CPU)
+                {
+                    cpu_set_t cpus;
+                    CPU_ZERO(&cpus);
+                    CPU_SET(index, &cpus);
+                    pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpus), &cpus);
+                }
+#endif
+            }
+        }
+
+        /**
+         * @brief stops and joins threads started by start()
+         */
+        void    stop()
+        {
+            running.store(false, std::memory_order_release);
+            for (std::thread& thread : threads)
+                thread.join();
+            threads.clear();
+        }
+
+        /**
+         * @brief stops threads started by start() and closes every shard
+         */
+        void    close()
+        {
+            this->stop();
+            for (auto& shard : shards)
+            {
+                if (shard->get_socket() >= 0)
+                    shard->close();
+            }
+        }
+
+        /**
+         * @brief returns the number of shards
+         */
+        size_t  shard_count() const
+        {
+            return (shards.size());
+        }
+
+        /**
+         * @brief returns the shard at **index**, to set options or poll it from a user thread
+         */
+        shard_type&     shard(size_t index)
+        {
+            return (*shards[index]);
+        }
+
+        /**
+         * @brief returns the address shards are bound to
+         */
+        const socket_address&   address() const
+        {
+            return (shards.front()->address);
+        }
+
+        /**
+         * @brief returns statistics of the shard at **index**
+         */
+        shard_stats     stats(size_t index) const
+        {
+            shard_stats result;
+            result.datagrams = counters[index].datagrams.load(std::memory_order_relaxed);
+            result.bytes = counters[index].bytes.load(std::memory_order_relaxed);
+            result.errors = counters[index].errors.load(std::memory_order_relaxed);
+            return (result);
+        }
+
+        /**
+         * @brief returns statistics aggregated for all shards
+         */
+        shard_stats     stats() const
+        {
+            shard_stats result;
+            for (size_t index = 0; index < shards.size(); ++index)
+            {
+                const shard_stats shard = this->stats(index);
+                result.datagrams += shard.datagrams;
+                result.bytes += shard.bytes;
+                result.errors += shard.errors;
+            }
+            return (result);
+        }
+
+    private:
+        /**
+         * @brief counters of a shard, on their own cache line as they are written by the thread of the shard
+         */
+        struct shard_counters
+        {
+            std::atomic<size_t>     datagrams { 0 };
+            std::atomic<size_t>     bytes { 0 };
+            std::atomic<size_t>     errors { 0 };
+            // padding instead of alignas(64), over-aligned new needs C++17
+            char                    padding[64];
+        };
+
+        /**
+         * @brief   attaches a classic BPF program returning the shard index of a packet to the reuseport group
+         *
+         * @return true if program was attached, false on error, ERROR hook of the first shard is called
+         */
+        bool    attach_steering(shard_steering steering)
+        {
+#if defined(__linux__)
+            const uint32_t  ancillary = (steering == shard_steering::CPU ? SKF_AD_CPU : SKF_AD_RXHASH);
+            const sock_filter   code[] = {
+                // A = ancillary data of the packet (cpu or receive hash)
+                { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF) + ancillary },
+                // A = A % number of shards
+                { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(shards.size()) },
+                // returns A, index of the shard in the group
+                { BPF_RET | BPF_A, 0, 0, 0 },
+            };
+            return (shards.front()->attach_reuse_port_filter(code, sizeof(code) / sizeof(code[0])));
+#else
+            (void)steering;
+            return (false);
+#endif
+        }
+
+        /**
+         * @brief shards, bound in order so that shard i is socket i of the reuseport group
+         */
+        std::vector<std::unique_ptr<shard_type>>    shards;
+
+        /**
+         * @brief counters of each shard
+         */
+        std::unique_ptr<shard_counters[]>           counters;
+
+        /**
+         * @brief threads started by start()
+         */
+        std::vector<std::thread>    threads;
+
+        /**
+         * @brief cleared by stop() to end threads
+         */
+        std::atomic<bool>           running { false };
+
+        /**
+         * @brief steering set on bind
+         */
+        shard_steering              steering = shard_steering::DEFAULT;
+};
+
+
+/**
+ * @brief   type alias for udp sharded socket implementation (see udp::sharded_socket_impl)
+ */
+using sharded_socket = udp::sharded_socket_impl<
+                                                unisock::events::actions_list</* no extended actions*/>,
+                                                unisock::entity_model</* no extended socket data*/>
+                                               >;
+
+
+/**
+ * @brief   type alias for udp sharded socket implementation with custom data on each shard (see udp::sharded_socket_impl)
+ *
+ * @tparam  _Data custom data to append to each shard
+ */
+template<typename ..._SocketModelData>
+using sharded_socket_of = udp::sharded_socket_impl<
+                                                    unisock::events::actions_list</* no extended actions*/>,
+                                                    unisock::entity_model<_SocketModelData...>
+                                                   >;
+
+} // ******** namespace udp
+
+} // ******** namespace unisock
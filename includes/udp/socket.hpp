@@ -4,6 +4,15 @@
 #include "socket/socket_container.hpp"
 #include "events/events.hpp"
 #include "raw/socket.hpp"
+#include "socket/resolver.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+
+#if defined(__linux__)
+# include <linux/filter.h>
+#endif
 
 
 /**
@@ -98,6 +107,20 @@ namespace actions
         static constexpr const char* callback_prototype = "void (const socket_address& address, const char* message, size_t message_len)";
     };
 
+    /**
+     * @brief   udp::socket received a batch of datagrams
+     * 
+     * @details this event will be called once per batch when batched receive is enabled (see udp::socket_impl::set_recv_batch),
+     *          before RECEIVE is called for each datagram of the batch
+     * 
+     * @note    hook prototype: ```void (const raw::datagram* datagrams, size_t count)``` \n
+     */
+    struct  RECEIVE_BATCH
+    {
+        static constexpr const char* action_name = "udp::RECEIVE_BATCH";
+        static constexpr const char* callback_prototype = "void (const raw::datagram* datagrams, size_t count)";
+    };
+
     /**
      * @brief   udp::socket successfully bound to address
      * 
@@ -130,6 +153,9 @@ using actions_list = std::tuple <
     unisock::events::action<actions::RECEIVE,
         std::function< void (const socket_address&, const char*, size_t)> >,
 
+    unisock::events::action<actions::RECEIVE_BATCH,
+        std::function< void (const raw::datagram*, size_t)> >,
+
     unisock::events::action<actions::BIND,
         std::function< void (const socket_address&)> >,
 
@@ -140,6 +166,284 @@ using actions_list = std::tuple <
 >;
 
 
+/**
+ * @brief   outbound queue of datagrams, flushed in batches with sendmmsg
+ * 
+ * @details datagrams are copied into a ring preallocated when the queue is created: each datagram is stored
+ *          contiguously in a byte buffer as the address (only the bytes used by its family) followed by the message,
+ *          and is referenced by a slot of a fixed size ring of **max_depth** slots. sendmmsg headers point directly
+ *          into the buffer, so that queueing and flushing a datagram never allocates.\n
+ *          uses sendmmsg where available, otherwise falls back to sendto in a loop
+ * 
+ * @ref udp::socket_impl::set_send_batch
+ */
+class   send_queue
+{
+    public:
+        /**
+         * @brief default maximum number of datagrams waiting in the queue
+         */
+        static constexpr size_t DEFAULT_MAX_DEPTH = 4096;
+
+        /**
+         * @brief   default size of the buffer holding the addresses and messages of queued datagrams
+         * @details about DEFAULT_MAX_DEPTH datagrams of 1KB, pages of the buffer are only used once written
+         */
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 22;
+
+        /**
+         * @brief creates an empty queue
+         * 
+         * @param batch_size    maximum number of datagrams sent per syscall
+         * @param max_depth     maximum number of datagrams waiting in the queue
+         * @param buffer_size   size of the buffer holding the addresses and messages of queued datagrams
+         */
+        explicit send_queue(size_t batch_size, size_t max_depth, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+        : slots(std::max<size_t>(max_depth, 1)), buffer(new char[buffer_size]), buffer_size(buffer_size)
+#if defined(__linux__)
+        , headers(batch_size), iov(batch_size)
+#else
+        , batch_size(batch_size)
+#endif
+        {}
+
+        /**
+         * @brief returns the number of datagrams waiting in the queue
+         */
+        size_t          size() const
+        {
+            return (count);
+        }
+
+        /**
+         * @brief returns true if no datagram is waiting
+         */
+        bool            empty() const
+        {
+            return (count == 0);
+        }
+
+        /**
+         * @brief returns true if the queue reached its maximum depth
+         */
+        bool            full() const
+        {
+            return (count >= slots.size());
+        }
+
+        /**
+         * @brief   copies a datagram at the end of the queue
+         * 
+         * @param address       destination of the datagram
+         * @param address_len   size of **address**, only these bytes are stored
+         * @param message       message to send as char buffer
+         * @param message_len   size of the **message** buffer
+         * 
+         * @return false if the queue reached its maximum depth or its buffer has no room for the datagram
+         */
+        bool            push(const sockaddr* address, socklen_t address_len, const char* message, size_t message_len)
+        {
+            const size_t    record_size = (address_len + message_len + RECORD_ALIGNMENT) & ~(RECORD_ALIGNMENT - 1);
+            size_t          offset = 0;
+            if (full() || !reserve(record_size, offset))
+                return (false);
+
+            slot& datagram = slots[(first + count) % slots.size()];
+            datagram.offset = offset;
+            datagram.address_len = address_len;
+            datagram.message_len = message_len;
+            std::memcpy(&buffer[offset], address, address_len);
+            std::memcpy(&buffer[offset + address_len], message, message_len);
+            end = offset + record_size;
+            ++count;
+            return (true);
+        }
+
+        /**
+         * @brief   copies a datagram at the end of the queue, see push(const sockaddr*, socklen_t, const char*, size_t)
+         */
+        bool            push(const socket_address& address, const char* message, size_t message_len)
+        {
+            return (this->push(address.to<sockaddr>(), address.size(), message, message_len));
+        }
+
+        /**
+         * @brief drops the datagram at the front of the queue
+         */
+        void            pop()
+        {
+            first = (first + 1) % slots.size();
+            --count;
+        }
+
+        /**
+         * @brief   moves the datagrams of **other** at the end of this queue, in order
+         * 
+         * @return false if this queue has no room for all of them, the datagrams left stay in **other**
+         */
+        bool            take(send_queue& other)
+        {
+            while (!other.empty())
+            {
+                const slot& datagram = other.slots[other.first];
+                const char* record = &other.buffer[datagram.offset];
+                if (!this->push(reinterpret_cast<const sockaddr*>(record), datagram.address_len, record + datagram.address_len, datagram.message_len))
+                    return (false);
+                other.pop();
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   sends a batch of datagrams from the front of the queue without blocking, sent datagrams are removed from the queue
+         * 
+         * @param socket    socket file descriptor
+         * @param n_bytes   set to the number of bytes sent
+         * 
+         * @return number of datagrams sent, -1 on error with errno set, the datagram that failed stays at the front of the queue
+         */
+        int             send(int socket, size_t& n_bytes)
+        {
+            n_bytes = 0;
+#if defined(__linux__)
+            const size_t n_datagrams = std::min(headers.size(), count);
+            for (size_t i = 0; i < n_datagrams; ++i)
+            {
+                const slot& datagram = slots[(first + i) % slots.size()];
+                char*       record = &buffer[datagram.offset];
+                iov[i].iov_base = record + datagram.address_len;
+                iov[i].iov_len = datagram.message_len;
+                headers[i].msg_hdr.msg_name = (datagram.address_len > 0 ? record : nullptr);
+                headers[i].msg_hdr.msg_namelen = datagram.address_len;
+                headers[i].msg_hdr.msg_iov = &iov[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            int n_sent = ::sendmmsg(socket, headers.data(), n_datagrams, MSG_DONTWAIT);
+            for (int i = 0; i < n_sent; ++i)
+            {
+                n_bytes += headers[i].msg_len;
+                this->pop();
+            }
+            return (n_sent);
+#else
+            int n_sent = 0;
+            for (; n_sent < static_cast<int>(batch_size) && count > 0; ++n_sent)
+            {
+                const slot& datagram = slots[first];
+                const char* record = &buffer[datagram.offset];
+                ssize_t sent = ::sendto(socket,
+                                        record + datagram.address_len,
+                                        datagram.message_len,
+                                        MSG_DONTWAIT,
+                                        (datagram.address_len > 0 ? reinterpret_cast<const sockaddr*>(record) : nullptr),
+                                        datagram.address_len);
+                if (sent < 0)
+                    return (n_sent > 0 ? n_sent : -1);
+                n_bytes += sent;
+                this->pop();
+            }
+            return (n_sent);
+#endif
+        }
+
+    private:
+        /**
+         * @brief alignment of datagrams in the buffer, records of empty datagrams still take this size
+         */
+        static constexpr size_t RECORD_ALIGNMENT = 8;
+
+        /**
+         * @brief datagram waiting to be sent, stored at **offset** in the buffer as its address followed by its message
+         */
+        struct slot
+        {
+            size_t      offset;
+            socklen_t   address_len;
+            size_t      message_len;
+        };
+
+        /**
+         * @brief   finds **size** contiguous free bytes in the buffer
+         * 
+         * @details records are written after the last one and wrap to the start of the buffer when the end has no
+         *          room, the write position never reaches the first queued record so that a full buffer is not
+         *          mistaken for an empty one
+         * 
+         * @param size      number of bytes of the record
+         * @param offset    set to the offset of the free bytes
+         * 
+         * @return false if the buffer has no room for **size** bytes
+         */
+        bool            reserve(size_t size, size_t& offset) const
+        {
+            if (count == 0)
+            {
+                offset = 0;
+                return (size <= buffer_size);
+            }
+
+            const size_t begin = slots[first].offset;
+            if (end > begin && buffer_size - end >= size)
+                offset = end;
+            else if (end > begin && begin > size)
+                offset = 0;
+            else if (end <= begin && begin - end > size)
+                offset = end;
+            else
+                return (false);
+            return (true);
+        }
+
+        /**
+         * @brief ring of queued datagrams, **count** datagrams starting at index **first**
+         */
+        std::vector<slot>           slots;
+
+        /**
+         * @brief index of the datagram at the front of the queue
+         */
+        size_t                      first = 0;
+
+        /**
+         * @brief number of datagrams waiting in the queue
+         */
+        size_t                      count = 0;
+
+        /**
+         * @brief addresses and messages of queued datagrams, not initialized
+         */
+        std::unique_ptr<char[]>     buffer;
+
+        /**
+         * @brief size of buffer
+         */
+        size_t                      buffer_size;
+
+        /**
+         * @brief offset in the buffer after the last queued datagram
+         */
+        size_t                      end = 0;
+
+#if defined(__linux__)
+        /**
+         * @brief sendmmsg headers, one per datagram of a batch
+         */
+        std::vector<mmsghdr>        headers;
+
+        /**
+         * @brief iovec of each datagram of a batch
+         */
+        std::vector<iovec>          iov;
+#else
+        /**
+         * @brief maximum number of datagrams sent per send()
+         */
+        size_t                      batch_size;
+#endif
+};
+
+
 /**
  * @brief   type alias for udp socket implementation (see udp::socket_impl<std::tuple<_Actions...>, _Data...>)
  * 
@@ -210,9 +514,59 @@ class socket_impl<
     
 
     protected:
+        /**
+         * @brief direct readable dispatch of udp::socket, see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready udp::socket
+         * @param context   unused
+         */
+        static void dispatch_recvfrom(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<socket_impl*>(socket)->recvfrom();
+        }
+
+        /**
+         * @brief direct readable dispatch of udp::socket when batched receive is enabled, see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready udp::socket
+         * @param context   unused
+         */
+        static void dispatch_recvmmsg(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<socket_impl*>(socket)->recvmmsg();
+        }
+
+        /**
+         * @brief direct readable dispatch of udp::socket when connected to a peer, see unisock::socket::set_dispatch
+         *
+         * @param socket    the ready udp::socket
+         * @param context   unused
+         */
+        static void dispatch_recv(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<socket_impl*>(socket)->recv();
+        }
+
+        /**
+         * @brief direct writeable dispatch of udp::socket, flushes the outbound queue, see unisock::socket::set_dispatch
+         *
+         * @param socket    the writeable udp::socket
+         * @param context   unused
+         */
+        static void dispatch_send_flush(socket_base* socket, void* context)
+        {
+            (void)context;
+            static_cast<socket_impl*>(socket)->send_flush();
+        }
+
         void    init_socket()
         {
-            this->template on<basic_actions::READABLE>([this](){ this->recvfrom(); });
+            this->template on<basic_actions::READABLE>([this](){ this->receive(); });
+            this->template on<basic_actions::WRITEABLE>([this](){ this->send_flush(); });
+            this->set_dispatch(&socket_impl::dispatch_recvfrom, &socket_impl::dispatch_send_flush);
 
             // remap raw::actions::RECVFROM to udp::common_action::receive
             this->template on<raw::actions::RECVFROM>(
@@ -221,12 +575,445 @@ class socket_impl<
                 }
             );
 
+            this->template on<raw::actions::RECVMMSG>(
+                [this](const raw::datagram* datagrams, size_t count){
+                    this->template execute<udp::actions::RECEIVE_BATCH>(datagrams, count);
+                }
+            );
+
             this->template on<basic_actions::CLOSED>(
-                [this](){ this->template execute<udp::actions::CLOSED>(this->address); }
+                [this](){
+                    this->connected = false;
+                    this->update_dispatch();
+                    this->template execute<udp::actions::CLOSED>(this->address);
+                }
             );
         }
 
+        /**
+         * @brief receives datagrams with the receive path of current mode: batched, connected, or recvfrom
+         */
+        void    receive()
+        {
+            if (this->batch)
+                this->recvmmsg();
+            else if (this->connected)
+                this->recv();
+            else
+                this->recvfrom();
+        }
+
+        /**
+         * @brief sets the direct readable dispatch matching current receive mode, see receive()
+         */
+        void    update_dispatch()
+        {
+            const socket_base::dispatch_table& dispatch = this->get_dispatch();
+            // READABLE was hooked, keeps the default dispatch which calls receive() from the READABLE action
+            if (dispatch.readable == &socket_base::dispatch_readable)
+                return ;
+
+            socket_base::dispatch_function readable = &socket_impl::dispatch_recvfrom;
+            if (this->batch)
+                readable = &socket_impl::dispatch_recvmmsg;
+            else if (this->connected)
+                readable = &socket_impl::dispatch_recv;
+            this->set_dispatch(readable, dispatch.writeable, dispatch.context);
+        }
+
     public:
+        /**
+         * @brief   enables batched receive with recvmmsg, see raw::socket_impl::set_recv_batch
+         * 
+         * @details each readable event receives up to **batch_size** datagrams with a single syscall,
+         *          RECEIVE_BATCH is called once with the batch, then RECEIVE for each datagram.
+         * 
+         * @param batch_size    maximum number of datagrams received per syscall, 0 disables batched receive
+         * @param buffer_size   maximum size of a datagram, larger datagrams are truncated
+         * @param gro           splits buffers coalesced by UDP_GRO into datagrams, see set_gro
+         */
+        void    set_recv_batch(size_t batch_size, size_t buffer_size = base_type::RECV_BUFFER_SIZE, bool gro = false)
+        {
+            this->base_type::set_recv_batch(batch_size, buffer_size, gro);
+            this->update_dispatch();
+        }
+
+        /**
+         * @brief   connects the socket to **peer**, datagrams are then sent with send() and received with recv()
+         * 
+         * @details the kernel resolves the route to **peer** once and filters datagrams from other addresses,
+         *          send() and recv() do not pass an address per call, and RECEIVE reports the address cached in
+         *          the socket (see get_peer) instead of copying the sender address of each datagram.\n
+         *          opens the socket if it was not opened by bind.
+         * 
+         * @param peer  address of the peer
+         * 
+         * @return true if socket was connected, false on error, ERROR hook is called with errno of error
+         */
+        bool    connect(const socket_address& peer)
+        {
+            if (!this->open(peer.family()))
+                return (false);
+
+            if (0 > ::connect(this->get_socket(), peer.template to<sockaddr>(), peer.size()))
+            {
+                this->template execute<basic_actions::ERROR>("connect", errno);
+                return (false);
+            }
+            this->peer = peer;
+            this->connected = true;
+            this->update_dispatch();
+            return (true);
+        }
+
+        /**
+         * @brief   dissolves the association with the peer set by connect(), socket can send to and receive from any address again
+         * 
+         * @return true if socket was disconnected, false on error, ERROR hook is called with errno of error
+         */
+        bool    disconnect()
+        {
+            if (!this->connected)
+                return (true);
+
+            sockaddr unspec;
+            std::memset(&unspec, 0, sizeof(unspec));
+            unspec.sa_family = AF_UNSPEC;
+            if (0 > ::connect(this->get_socket(), &unspec, sizeof(unspec)))
+            {
+                this->template execute<basic_actions::ERROR>("connect", errno);
+                return (false);
+            }
+            this->connected = false;
+            this->update_dispatch();
+            return (true);
+        }
+
+        /**
+         * @brief returns true if socket is connected to a peer, see connect()
+         */
+        bool    is_connected() const
+        {
+            return (this->connected);
+        }
+
+        /**
+         * @brief returns the address of the peer set by connect()
+         */
+        const socket_address&   get_peer() const
+        {
+            return (this->peer);
+        }
+
+        /**
+         * @brief   sends **message** of size **message_len** to the connected peer with send
+         * 
+         * @note    the message is sent right away, bypassing the outbound queue (see set_send_batch)
+         * 
+         * @param message       message to send as char buffer
+         * @param message_len   size of the **message** buffer
+         * @param flags         flags for send, 0 by default
+         * 
+         * @return true if message was sent, false on error, ERROR hook is called with errno of error
+         */
+        bool    send(const char* message, size_t message_len, int flags = 0)
+        {
+            assert(this->connected);
+
+            if (0 > ::send(this->get_socket(), message, message_len, flags))
+            {
+                this->template execute<basic_actions::ERROR>("send", errno);
+                return (false);
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   receives datagrams from the connected peer with recv, calls back RECEIVE with the cached peer address
+         * 
+         * @details when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          recv loops until the socket is flushed (EAGAIN) or until its quota is exhausted.
+         * 
+         * @return true if bytes were received, false on error or if socket had nothing to receive
+         */
+        bool    recv()
+        {
+            assert(this->get_socket() > 0);
+
+            // keeps a reference to the handler, this socket may be deleted by a hook
+            std::shared_ptr<events::handler> handler = this->handler;
+            const int   socket = this->get_socket();
+            char        buffer[base_type::RECV_BUFFER_SIZE];
+            ssize_t     n_bytes = 0;
+
+            if ((this->timestamping & _lib::TIMESTAMP_TX) && !this->recv_errqueue())
+                return (false);
+
+            do
+            {
+                if (this->with_ancillary())
+                    n_bytes = this->receive_ancillary(socket, buffer, sizeof(buffer), nullptr, nullptr);
+                else
+                    n_bytes = ::recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n_bytes < 0)
+                {
+                    // ECONNREFUSED is reported here when the peer is not listening
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        this->template execute<basic_actions::ERROR>("recv", errno);
+                    return (false);
+                }
+
+                if (this->capture)
+                    this->capture_packet(this->peer, buffer, n_bytes);
+                ushort handler_ref = handler->get_ref();
+                this->template execute<udp::actions::RECEIVE>(this->peer, buffer, n_bytes);
+                // a socket was added or deleted by the hook, this socket may not exist anymore
+                if (handler->ref_has_changed(handler_ref))
+                    return (true);
+            }
+            while (handler->consume(socket, n_bytes));
+            return (true);
+        }
+
+        /**
+         * @brief   enables receive-side segmentation offload (UDP_GRO)
+         * 
+         * @details the kernel coalesces consecutive datagrams of a same sender into one buffer, which is received
+         *          in one syscall and split back into datagrams using the segment size from ancillary data.
+         *          datagrams are delivered as with batched receive: RECEIVE_BATCH once, then RECEIVE for each datagram.
+         * 
+         * @note    the socket must be opened (see open, bind), needs Linux 5.0 or later
+         * 
+         * @param batch_size    maximum number of coalesced buffers received per syscall, 0 disables GRO
+         * 
+         * @return true if GRO was set, false on error, ERROR hook is called with errno of error
+         */
+        bool    set_gro(size_t batch_size)
+        {
+#if defined(UDP_GRO)
+            int enable = batch_size > 0 ? 1 : 0;
+            if (!this->setsockopt(SOL_UDP, UDP_GRO, &enable, sizeof(enable)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            this->set_recv_batch(batch_size, raw::recv_batch::GRO_BUFFER_SIZE, true);
+            return (true);
+#else
+            (void)batch_size;
+            this->template execute<basic_actions::ERROR>("setsockopt", ENOPROTOOPT);
+            return (false);
+#endif
+        }
+
+        /**
+         * @brief maximum number of segments sent per syscall by send_segments
+         */
+        static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+        /**
+         * @brief maximum number of bytes sent per syscall by send_segments, below the 64KB limit of IPv4 and IPv6 packets
+         */
+        static constexpr size_t MAX_GSO_SIZE = 65000;
+
+        /**
+         * @brief   sends **buffer** to **address** as datagrams of **segment_size** bytes using send-side segmentation offload (UDP_SEGMENT)
+         * 
+         * @details the kernel splits each large buffer into datagrams, so that a long run of datagrams to a same peer
+         *          costs one syscall and one pass in the stack per MAX_GSO_SEGMENTS datagrams.
+         *          the last datagram can be shorter than **segment_size**.\n
+         *          where UDP_SEGMENT is not available, datagrams are sent one by one with sendto.
+         * 
+         * @note    datagrams are sent right away, bypassing the outbound queue (see set_send_batch)
+         * 
+         * @param address       the address to send the datagrams to
+         * @param buffer        datagrams to send, contiguous
+         * @param buffer_len    size of **buffer**
+         * @param segment_size  size of each datagram
+         * 
+         * @return true if all datagrams were sent, false on error, ERROR hook is called with errno of error
+         */
+        bool    send_segments(const socket_address& address, const char* buffer, size_t buffer_len, uint16_t segment_size)
+        {
+            assert(this->get_socket() > 0);
+            assert(segment_size > 0);
+
+            const size_t segments_per_call = std::max<size_t>(1, std::min(MAX_GSO_SEGMENTS, MAX_GSO_SIZE / segment_size));
+            const size_t bytes_per_call = segments_per_call * segment_size;
+
+            for (size_t offset = 0; offset < buffer_len; offset += bytes_per_call)
+            {
+                const size_t length = std::min(bytes_per_call, buffer_len - offset);
+#if defined(UDP_SEGMENT)
+                control_buffer  control;
+
+                // a single datagram does not need segmentation
+                if (length > segment_size)
+                    control.add_segment_size(segment_size);
+
+                if (!this->base_type::send_to(address, buffer + offset, length, control))
+                    return (false);
+#else
+                for (size_t sent = 0; sent < length; sent += segment_size)
+                {
+                    if (!this->base_type::send_to(address, buffer + offset + sent, std::min<size_t>(segment_size, length - sent)))
+                        return (false);
+                }
+#endif
+            }
+            return (true);
+        }
+
+        /**
+         * @brief   enables the outbound queue of send_to, flushed in batches with sendmmsg
+         * 
+         * @details send_to copies datagrams into the queue and asks the handler for writing, the queue is flushed
+         *          next time events::poll reports the socket as writeable, so that datagrams sent in a dispatch cycle
+         *          are sent together. datagrams that could not be sent because the socket buffer is full (EAGAIN) stay
+         *          in the queue and are retried when the socket becomes writeable again.\n
+         *          the queue and its buffer are allocated here, datagrams waiting in a previous queue are moved to the new one.
+         * 
+         * @note    disabling the queue flushes it, datagrams that could not be sent because the socket buffer is full
+         *          are still sent from the queue when the socket becomes writeable, send_to keeps queueing until then
+         *          so that datagrams are sent in order, the queue is released once empty
+         * 
+         * @param batch_size    maximum number of datagrams sent per syscall, 0 disables the queue
+         * @param max_depth     maximum number of datagrams waiting in the queue, send_to fails with ENOBUFS when reached
+         * @param buffer_size   size of the buffer holding queued datagrams, send_to fails with ENOBUFS when it is full
+         */
+        void    set_send_batch(size_t batch_size, size_t max_depth = send_queue::DEFAULT_MAX_DEPTH, size_t buffer_size = send_queue::DEFAULT_BUFFER_SIZE)
+        {
+            if (this->queue && this->get_socket() >= 0)
+                this->send_flush();
+            if (!this->queue && batch_size == 0)
+                return ;
+
+            if (batch_size == 0)
+            {
+                this->release_queue = true;
+                if (this->queue->empty() || this->get_socket() < 0)
+                {
+                    this->queue.reset();
+                    this->release_queue = false;
+                }
+                return ;
+            }
+
+            std::unique_ptr<send_queue> resized(new send_queue(batch_size, max_depth, buffer_size));
+            if (this->queue && !resized->take(*this->queue))
+                this->template execute<basic_actions::ERROR>("set_send_batch", ENOBUFS);
+            this->queue = std::move(resized);
+            this->release_queue = false;
+        }
+
+        /**
+         * @brief returns the number of datagrams waiting in the outbound queue
+         */
+        size_t  send_queue_size() const
+        {
+            return (this->queue ? this->queue->size() : 0);
+        }
+
+        /**
+         * @brief   sends **message** of size **message_len** to **address**
+         * 
+         * @details if the outbound queue is enabled (see set_send_batch), the datagram is queued and sent on next flush,
+         *          otherwise it is sent right away with sendto (see raw::socket_impl::send_to)
+         * 
+         * @param address       the address to send the message to
+         * @param message       message to send as char buffer
+         * @param message_len   size of the **message** buffer
+         * @param flags         flags for sendto, 0 by default, ignored when the outbound queue is enabled
+         * 
+         * @return true if message was sent or queued, false on error, ERROR hook is called with errno of error
+         */
+        bool    send_to(const socket_address& address, const char* message, size_t message_len, int flags = 0)
+        {
+            if (!this->queue)
+                return (this->base_type::send_to(address, message, message_len, flags));
+
+            assert(this->get_socket() > 0);
+            if (!this->queue->push(address, message, message_len))
+            {
+                this->template execute<basic_actions::ERROR>("send_to", ENOBUFS);
+                return (false);
+            }
+            if (this->queue->size() == 1)
+                this->set_want_write(true);
+            return (true);
+        }
+
+        /**
+         * @brief   sends **message** of size **message_len** to **address** with ancillary data of **control**
+         * 
+         * @details a server with several local addresses replies from the address the request was received on with
+         *          the destination of get_ancillary() (needs set_ancillary(ANCILLARY_PKTINFO)) set as source in **control**
+         * 
+         * @note    the message is sent right away with sendmsg, bypassing the outbound queue (see set_send_batch)
+         * 
+         * @param address       the address to send the message to
+         * @param message       message to send as char buffer
+         * @param message_len   size of the **message** buffer
+         * @param control       ancillary data to send with the message (see control_buffer)
+         * @param flags         flags for sendmsg, 0 by default
+         * 
+         * @return true if message was sent, false on error, ERROR hook is called with errno of error
+         */
+        bool    send_to(const socket_address& address, const char* message, size_t message_len, const control_buffer& control, int flags = 0)
+        {
+            return (this->base_type::send_to(address, message, message_len, control, flags));
+        }
+
+        /**
+         * @brief   sends datagrams waiting in the outbound queue with sendmmsg
+         * 
+         * @details send_flush loops until the queue is empty or the socket is full.
+         *          when dispatched by events::poll with a socket quota set in events::dispatch_budget,
+         *          each batch counts as one write and send_flush also stops when its quota is exhausted,
+         *          without a quota, one batch is sent per writeable event.\n
+         *          a datagram that failed to be sent with an error other than EAGAIN is dropped and ERROR hook is called.
+         */
+        void    send_flush()
+        {
+            if (!this->queue)
+                return ;
+
+            std::shared_ptr<events::handler> handler = this->handler;
+            const socket_base*  self = this;
+            const int           socket = this->get_socket();
+            // called by the user or by the hook of another socket, the budget does not apply
+            const bool          dispatched = handler->dispatches(socket);
+
+            while (!this->queue->empty())
+            {
+                size_t  n_bytes = 0;
+                int     n_sent = this->queue->send(socket, n_bytes);
+                if (n_sent < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        break ;
+                    // drops the datagram that cannot be sent, the socket can still send the others
+                    this->queue->pop();
+                    ushort handler_ref = handler->get_ref();
+                    this->template execute<basic_actions::ERROR>("sendmmsg", errno);
+                    if (handler->ref_has_changed(handler_ref) && !handler->has_socket(socket, self))
+                        return ;
+                    if (!this->queue)
+                        return ;
+                    continue ;
+                }
+                if (dispatched && !handler->consume(socket, n_bytes))
+                    break ;
+            }
+
+            if (this->queue->empty() && this->release_queue)
+            {
+                this->queue.reset();
+                this->release_queue = false;
+            }
+            this->set_want_write(this->queue && !this->queue->empty());
+        }
+
         bool    open(sa_family_t af = AF_INET)
         {
             if (get_socket() < 0)
@@ -240,12 +1027,61 @@ class socket_impl<
             return (true);
         }
 
+        /**
+         * @brief   sets SO_REUSEPORT on the socket when it is bound, so that several sockets can bind the same address
+         * 
+         * @details the kernel spreads datagrams between sockets bound with SO_REUSEPORT to the same address,
+         *          by default with a hash of the 4-tuple of the datagram, see udp::sharded_socket_impl
+         * 
+         * @note    must be called before bind
+         * 
+         * @param enable    true to set SO_REUSEPORT on bind
+         */
+        void    set_reuse_port(bool enable)
+        {
+            this->reuse_port = enable;
+        }
+
+#if defined(__linux__)
+        /**
+         * @brief   attaches a classic BPF program selecting the socket receiving a datagram in the SO_REUSEPORT group of the socket
+         * 
+         * @details the program returns the index of the socket in the group, sockets being numbered in bind order,
+         *          the program applies to the whole group, see udp::sharded_socket_impl
+         * 
+         * @note    the socket must be bound with SO_REUSEPORT (see set_reuse_port), needs Linux 4.5 or later
+         * 
+         * @param code      instructions of the program
+         * @param code_len  number of instructions
+         * 
+         * @return true if program was attached, false on error, ERROR hook is called with errno of error
+         */
+        bool    attach_reuse_port_filter(const sock_filter* code, size_t code_len)
+        {
+# if defined(SO_ATTACH_REUSEPORT_CBPF)
+            sock_fprog program = { static_cast<unsigned short>(code_len), const_cast<sock_filter*>(code) };
+            if (!this->setsockopt(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+            return (true);
+# else
+            (void)code;
+            (void)code_len;
+            this->template execute<basic_actions::ERROR>("setsockopt", ENOPROTOOPT);
+            return (false);
+# endif
+        }
+#endif
+
         bool    bind(const std::string hostname, int port, bool use_IPv6 = false)
         {
             // socket should not be bound more that once,, thus should be uninitialized
             assert(get_socket() == -1);
 
-            this->open(use_IPv6 ? AF_INET6 : AF_INET);
+            if (!this->open_reusable(use_IPv6))
+                return (false);
 
             addrinfo_result result = socket_address::addrinfo(this->address, hostname, use_IPv6 ? AF_INET6 : AF_INET);
             if (result != addrinfo_result::SUCCESS)
@@ -253,7 +1089,129 @@ class socket_impl<
                 this->template execute<basic_actions::ERROR>("addrinfo", errno);
                 return false;
             }
+            return (this->bind_resolved(port, use_IPv6));
+        };
+
+
+        /**
+         * @brief   same as bind(), but resolves **hostname** on the resolver of this socket instead of blocking events::poll
+         * 
+         * @details the socket is opened once **hostname** is resolved, from events::poll on the handler of this socket.
+         *          udp::actions::BIND is then executed on success, basic_actions::ERROR with "addrinfo" and the
+         *          getaddrinfo error code (EAI_*, see gai_strerror) if the lookup failed.
+         * 
+         * @param hostname  hostname to bind
+         * @param port      port to bind
+         * @param use_IPv6  use IPv6
+         * 
+         * @ref unisock::resolver
+         */
+        void    async_bind(const std::string& hostname, int port, bool use_IPv6 = false)
+        {
+            this->get_resolver()->resolve(hostname, use_IPv6 ? AF_INET6 : AF_INET,
+                [this, port, use_IPv6](addrinfo_result result, const socket_address& resolved, int gai_error)
+                {
+                    if (result != addrinfo_result::SUCCESS)
+                    {
+                        this->template execute<basic_actions::ERROR>("addrinfo", gai_error);
+                        return ;
+                    }
+
+                    // socket should not be bound more that once,, thus should be uninitialized
+                    assert(get_socket() == -1);
+                    if (!this->open_reusable(use_IPv6))
+                        return ;
+                    this->address = resolved;
+                    this->bind_resolved(port, use_IPv6);
+                }
+            );
+        }
+
+
+        /**
+         * @brief   sets the resolver used by async_bind()
+         * 
+         * @note    a resolver shared between entities must not call back an entity that was destroyed,
+         *          entities must outlive their pending lookups
+         */
+        void    set_resolver(std::shared_ptr<unisock::resolver> resolver)
+        {
+            this->async_resolver = resolver;
+        }
+
+
+        /**
+         * @brief returns the resolver used by async_bind(), creates one on the handler of this socket if none was set
+         */
+        std::shared_ptr<unisock::resolver>  get_resolver()
+        {
+            if (!this->async_resolver)
+                this->async_resolver = std::make_shared<unisock::resolver>(get_handler());
+            return (this->async_resolver);
+        }
+
+
+        using base_type::on;
+        using base_type::get_handler;
+
+        using base_type::set_timestamping;
+        using base_type::get_timestamping;
+        using base_type::get_timestamps;
+        using base_type::recv_errqueue;
+
+        using base_type::set_ancillary;
+        using base_type::get_ancillary;
+
+        using base_type::set_capture;
+
+#if defined(__linux__)
+        using base_type::attach_filter;
+        using base_type::detach_filter;
+#endif
+
+        using base_type::get_socket;
+        using base_type::close;
+        using base_type::address;
+
+
+        using base_type::data;        
+
+    protected:
+        /**
+         * @brief execute() is protected so that childrens of udp::socket can execute their extended actions
+         */
+        using base_type::execute;
+
+        /**
+         * @brief opens the socket and sets SO_REUSEPORT if enabled (see set_reuse_port)
+         */
+        bool    open_reusable(bool use_IPv6)
+        {
+            if (!this->open(use_IPv6 ? AF_INET6 : AF_INET))
+                return (false);
+
+#if defined(SO_REUSEPORT)
+            int enable = 1;
+            if (this->reuse_port && !this->setsockopt(SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)))
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", errno);
+                return (false);
+            }
+#else
+            if (this->reuse_port)
+            {
+                this->template execute<basic_actions::ERROR>("setsockopt", ENOPROTOOPT);
+                return (false);
+            }
+#endif
+            return (true);
+        }
 
+        /**
+         * @brief binds the socket to its resolved address on **port**, executes udp::actions::BIND on success
+         */
+        bool    bind_resolved(int port, bool use_IPv6)
+        {
             if (use_IPv6)
                 this->address.template to<sockaddr_in6>()->sin6_port = htons(port);
             else
@@ -266,19 +1224,37 @@ class socket_impl<
 
             this->template execute<udp::actions::BIND>(this->address);
             return (true);
-        };
+        }
 
+        /**
+         * @brief outbound queue of send_to, nullptr if not enabled (see set_send_batch)
+         */
+        std::unique_ptr<send_queue>  queue;
 
-        using base_type::on;
-        using base_type::get_handler;
+        /**
+         * @brief true if the outbound queue was disabled and is released once its datagrams are sent (see set_send_batch)
+         */
+        bool            release_queue = false;
 
-        using base_type::get_socket;
-        using base_type::close;
-        using base_type::address;
+        /**
+         * @brief address of the peer set by connect()
+         */
+        socket_address  peer;
 
-        using base_type::send_to;
+        /**
+         * @brief true if socket is connected to peer
+         */
+        bool            connected = false;
 
-        using base_type::data;        
+        /**
+         * @brief true if SO_REUSEPORT is set on bind (see set_reuse_port)
+         */
+        bool            reuse_port = false;
+
+        /**
+         * @brief resolver of async_bind(), created on first use
+         */
+        std::shared_ptr<unisock::resolver>  async_resolver;
 };
 
 
@@ -286,20 +1262,188 @@ class socket_impl<
 
 
 /**
- * @brief 
+ * @brief   process-wide pool of unbound udp sockets used by udp::send_to and udp::send_batch
+ * 
+ * @details keeps one socket per address family (AF_INET, AF_INET6), opened on first use and reused by all
+ *          following sends, so that sending a datagram without a udp::socket costs a single syscall.
+ *          sockets are not added to any events::handler. sending from several threads is safe.
+ */
+class   pooled_sender
+{
+    public:
+        /**
+         * @brief maximum number of datagrams sent per sendmmsg by send_batch
+         */
+        static constexpr size_t MAX_BATCH_SIZE = 64;
+
+        /**
+         * @brief returns the process-wide sender
+         */
+        static pooled_sender&   instance()
+        {
+            static pooled_sender sender;
+            return (sender);
+        }
+
+        explicit pooled_sender() = default;
+
+        pooled_sender(const pooled_sender& copy) = delete;
+
+        /**
+         * @brief closes pooled sockets
+         */
+        ~pooled_sender()
+        {
+            if (ipv4 >= 0)
+                ::close(ipv4);
+            if (ipv6 >= 0)
+                ::close(ipv6);
+        }
+
+        /**
+         * @brief   returns the pooled socket of **family**, opens it on first call
+         * 
+         * @param family    AF_INET or AF_INET6
+         * 
+         * @return the socket file descriptor, -1 on error with errno set
+         */
+        int     socket_of(sa_family_t family)
+        {
+            if (family != AF_INET && family != AF_INET6)
+            {
+                errno = EAFNOSUPPORT;
+                return (-1);
+            }
+
+            std::atomic<int>& pooled = (family == AF_INET6 ? ipv6 : ipv4);
+            int socket = pooled.load(std::memory_order_acquire);
+            if (socket >= 0)
+                return (socket);
+
+            socket = ::socket(family, SOCK_DGRAM, 0);
+            if (socket < 0)
+                return (-1);
+
+            // another thread opened the socket first
+            int expected = -1;
+            if (!pooled.compare_exchange_strong(expected, socket, std::memory_order_acq_rel))
+            {
+                ::close(socket);
+                return (expected);
+            }
+            return (socket);
+        }
+
+        /**
+         * @brief   sends **message** of size **message_len** to **address** with the pooled socket of its family
+         * 
+         * @return true if message was sent, false on error with errno set
+         */
+        bool    send_to(const socket_address& address, const char* message, size_t message_len, int flags = 0)
+        {
+            int socket = socket_of(address.family());
+            if (socket < 0)
+                return (false);
+            return (0 <= ::sendto(socket, message, message_len, flags, address.to<sockaddr>(), address.size()));
+        }
+
+        /**
+         * @brief   sends **count** datagrams, each to its own address, with sendmmsg where available
+         * 
+         * @details consecutive datagrams of a same address family are sent together, up to MAX_BATCH_SIZE per syscall
+         * 
+         * @param datagrams datagrams to send, see raw::datagram
+         * @param count     number of datagrams
+         * @param flags     flags for sendmmsg / sendto
+         * 
+         * @return number of datagrams sent, stops at the first error with errno set
+         */
+        size_t  send_batch(const raw::datagram* datagrams, size_t count, int flags = 0)
+        {
+            size_t n_sent = 0;
+            while (n_sent < count)
+            {
+                const sa_family_t family = datagrams[n_sent].address.family();
+                int socket = socket_of(family);
+                if (socket < 0)
+                    return (n_sent);
+
+#if defined(__linux__)
+                struct mmsghdr  headers[MAX_BATCH_SIZE];
+                struct iovec    iov[MAX_BATCH_SIZE];
+                unsigned int    length = 0;
+
+                std::memset(headers, 0, sizeof(headers));
+                for (; length < MAX_BATCH_SIZE && n_sent + length < count; ++length)
+                {
+                    const raw::datagram& datagram = datagrams[n_sent + length];
+                    if (datagram.address.family() != family)
+                        break ;
+                    iov[length].iov_base = const_cast<char*>(datagram.message);
+                    iov[length].iov_len = datagram.message_len;
+                    headers[length].msg_hdr.msg_name = const_cast<sockaddr*>(datagram.address.to<sockaddr>());
+                    headers[length].msg_hdr.msg_namelen = datagram.address.size();
+                    headers[length].msg_hdr.msg_iov = &iov[length];
+                    headers[length].msg_hdr.msg_iovlen = 1;
+                }
+
+                int sent = ::sendmmsg(socket, headers, length, flags);
+                if (sent <= 0)
+                    return (n_sent);
+                n_sent += sent;
+#else
+                const raw::datagram& datagram = datagrams[n_sent];
+                if (0 > ::sendto(socket, datagram.message, datagram.message_len, flags, datagram.address.to<sockaddr>(), datagram.address.size()))
+                    return (n_sent);
+                ++n_sent;
+#endif
+            }
+            return (n_sent);
+        }
+
+    private:
+        /**
+         * @brief pooled AF_INET socket, -1 until first use
+         */
+        std::atomic<int>    ipv4 { -1 };
+
+        /**
+         * @brief pooled AF_INET6 socket, -1 until first use
+         */
+        std::atomic<int>    ipv6 { -1 };
+};
+
+
+/**
+ * @brief   sends an udp datagram without a udp::socket
+ * 
+ * @details uses sendto on a socket of the process-wide udp::pooled_sender, no socket is opened or closed per call
+ * 
+ * @param address       the address to send the message to
+ * @param message       message to send as char buffer
+ * @param message_len   size of the **message** buffer
+ * @param flags         flags for sendto, 0 by default
+ * 
+ * @return true if message was sent, false on error with errno set
+ */
+inline bool send_to(const socket_address& address, const char* message, size_t message_len, int flags = 0)
+{
+    return (pooled_sender::instance().send_to(address, message, message_len, flags));
+}
+
+
+/**
+ * @brief   sends a batch of udp datagrams without a udp::socket, see udp::pooled_sender::send_batch
  * 
- * @details uses sendto to send an udp packet using the specified socket
+ * @param datagrams datagrams to send, each with its own address
+ * @param count     number of datagrams
+ * @param flags     flags for sendmmsg, 0 by default
  * 
- * @return send_result 
+ * @return number of datagrams sent, stops at the first error with errno set
  */
-bool    send_to(const socket_address& address, const char* message, size_t message_len, int flags = 0)
+inline size_t   send_batch(const raw::datagram* datagrams, size_t count, int flags = 0)
 {
-    raw::socket sock {};
-    if (!sock.open(address.family(), SOCK_DGRAM, 0))
-        return (false);
-    bool result = sock.send_to(address, message, message_len, flags);
-    sock.close();
-    return (result);
+    return (pooled_sender::instance().send_batch(datagrams, count, flags));
 }
 
 
@@ -12,6 +12,8 @@
 #include "events/events_types.hpp"
 #include "events/handlers/poll/handler_impl.hpp"
 
+#include <algorithm>
+
 /**
  * @addindex
  */
@@ -37,6 +39,7 @@ void handler_impl<handler_types::POLL>::add_socket(int socket, unisock::socket_b
     data.fd = socket;
     this->sockets.push_back(data);
     this->socket_ptrs.push_back(ref);
+    this->dispatchers.push_back(ref->get_dispatch());
 }
 
 
@@ -49,6 +52,7 @@ void handler_impl<handler_types::POLL>::del_socket(int socket)
     // erase from socket_ptrs the element at same position as it from sockets
     // since both vectors are always the same size and conserve respectively the order of contained sockets
     this->socket_ptrs.erase(std::next(this->socket_ptrs.begin(), it - this->sockets.begin()));
+    this->dispatchers.erase(std::next(this->dispatchers.begin(), it - this->sockets.begin()));
     this->sockets.erase(it);
 }
 
@@ -67,6 +71,16 @@ size_t handler_impl<handler_types::POLL>::count() const
 
 
 
+bool handler_impl<handler_types::POLL>::has_socket(int socket, const unisock::socket_base* socket_ptr) const
+{
+    auto it = std::find(this->sockets.begin(), this->sockets.end(), socket);
+    if (it == this->sockets.end())
+        return (false);
+    return (this->socket_ptrs[it - this->sockets.begin()] == socket_ptr);
+}
+
+
+
 void handler_impl<handler_types::POLL>::socket_want_read(int socket, bool active)
 {
     auto it = std::find(this->sockets.begin(), this->sockets.end(), socket);
@@ -92,6 +106,16 @@ void handler_impl<handler_types::POLL>::socket_want_write(int socket, bool activ
 }
 
 
+
+void handler_impl<handler_types::POLL>::socket_set_dispatch(int socket, const unisock::socket_base::dispatch_table& dispatch)
+{
+    auto it = std::find(this->sockets.begin(), this->sockets.end(), socket);
+    if (it == this->sockets.end())
+        return ;
+    this->dispatchers[it - this->sockets.begin()] = dispatch;
+}
+
+
 } // ******** namespace _lib
 
 } // ******** namespace events
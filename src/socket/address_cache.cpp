@@ -0,0 +1,163 @@
+#include "socket/address_cache.hpp"
+
+#include <netdb.h>
+
+using namespace unisock;
+
+
+address_cache::address_cache()
+: tick(0), ttl(std::chrono::seconds(DEFAULT_TTL)), negative_ttl(std::chrono::seconds(DEFAULT_NEGATIVE_TTL)), capacity(DEFAULT_CAPACITY)
+{}
+
+
+address_cache&		address_cache::instance()
+{
+	static address_cache	cache;
+	return (cache);
+}
+
+
+// family is prepended so that the same hostname is cached once per family
+std::string			address_cache::make_key(const std::string& hostname, sa_family_t family)
+{
+	std::string	key;
+	key.reserve(hostname.size() + 2);
+	key += static_cast<char>(family & 0xFF);
+	key += static_cast<char>((family >> 8) & 0xFF);
+	key += hostname;
+	return (key);
+}
+
+
+bool				address_cache::find(const std::string& hostname, sa_family_t family, std::vector<socket_address>& addresses, addrinfo_result& result, int& gai_error) const
+{
+	const std::string	key = make_key(hostname, family);
+	std::shared_lock<std::shared_timed_mutex>	lock(mutex);
+
+	auto it = entries.find(key);
+	if (it == entries.end() || it->second->expires <= clock_type::now())
+		return (false);
+
+	const entry&	found = *it->second;
+	found.last_used.store(++tick, std::memory_order_relaxed);
+	addresses = found.addresses;
+	result = found.result;
+	gai_error = found.gai_error;
+	errno = found.error;
+	return (true);
+}
+
+
+void				address_cache::store(const std::string& hostname, sa_family_t family, const std::vector<socket_address>& addresses, addrinfo_result result, int error, int gai_error)
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+
+	const clock_type::duration	lifetime = (result == addrinfo_result::SUCCESS ? ttl : negative_ttl);
+	if (capacity == 0 || lifetime <= clock_type::duration::zero()
+		|| (result != addrinfo_result::SUCCESS
+			&& (result != addrinfo_result::ERROR || !address_cache::is_negative_cacheable(gai_error))))
+		return ;
+
+	const std::string	key = make_key(hostname, family);
+	auto it = entries.find(key);
+	if (it == entries.end())
+	{
+		if (entries.size() >= capacity)
+			this->evict();
+		it = entries.emplace(key, std::unique_ptr<entry>(new entry)).first;
+	}
+
+	entry&	stored = *it->second;
+	stored.addresses = addresses;
+	stored.result = result;
+	stored.error = error;
+	stored.gai_error = gai_error;
+	stored.expires = clock_type::now() + lifetime;
+	stored.last_used.store(++tick, std::memory_order_relaxed);
+}
+
+
+// only names that do not exist are cached, other errors are transient or depend on the request
+bool				address_cache::is_negative_cacheable(int gai_error)
+{
+#if defined(EAI_NODATA)
+	if (gai_error == EAI_NODATA)
+		return (true);
+#endif
+	return (gai_error == EAI_NONAME);
+}
+
+// linear scan, only done when inserting in a full cache
+void				address_cache::evict()
+{
+	const clock_type::time_point	now = clock_type::now();
+	for (auto it = entries.begin(); it != entries.end(); )
+	{
+		if (it->second->expires <= now)
+			it = entries.erase(it);
+		else
+			++it;
+	}
+
+	while (!entries.empty() && entries.size() >= capacity)
+	{
+		auto oldest = entries.begin();
+		for (auto it = entries.begin(); it != entries.end(); ++it)
+		{
+			if (it->second->last_used.load(std::memory_order_relaxed) < oldest->second->last_used.load(std::memory_order_relaxed))
+				oldest = it;
+		}
+		entries.erase(oldest);
+	}
+}
+
+
+void				address_cache::erase(const std::string& hostname, sa_family_t family)
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+	entries.erase(make_key(hostname, family));
+}
+
+
+void				address_cache::clear()
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+	entries.clear();
+}
+
+
+void				address_cache::set_ttl(clock_type::duration ttl)
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+	this->ttl = ttl;
+}
+
+
+void				address_cache::set_negative_ttl(clock_type::duration ttl)
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+	this->negative_ttl = ttl;
+}
+
+
+void				address_cache::set_capacity(size_t capacity)
+{
+	std::unique_lock<std::shared_timed_mutex>	lock(mutex);
+	this->capacity = capacity;
+	if (capacity == 0)
+		entries.clear();
+	else if (entries.size() > capacity)
+	{
+		// evict() leaves room for one insertion
+		++this->capacity;
+		this->evict();
+		this->capacity = capacity;
+	}
+}
+
+
+size_t				address_cache::size() const
+{
+	std::shared_lock<std::shared_timed_mutex>	lock(mutex);
+	return (entries.size());
+}
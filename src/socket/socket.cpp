@@ -7,11 +7,11 @@ namespace unisock {
 
 
 socket_base::socket_base()
-: _sock(-1)
+: _dispatch { &socket_base::dispatch_readable, &socket_base::dispatch_writeable, nullptr }, _sock(-1)
 {}
 
 socket_base::socket_base(int socket)
-: _sock(socket)
+: _dispatch { &socket_base::dispatch_readable, &socket_base::dispatch_writeable, nullptr }, _sock(socket)
 {}
 
 bool    socket_base::open(int domain, int type, int protocol)
@@ -51,4 +51,23 @@ bool    socket_base::getsockopt(int level, int option_name, void* option_value,
     return (0 == ::getsockopt(this->_sock, level, option_name, option_value, option_len));
 }
 
+
+const socket_base::dispatch_table&  socket_base::get_dispatch() const
+{
+    return (_dispatch);
+}
+
+
+void    socket_base::dispatch_readable(socket_base* socket, void* context)
+{
+    (void)context;
+    socket->on_readable();
+}
+
+void    socket_base::dispatch_writeable(socket_base* socket, void* context)
+{
+    (void)context;
+    socket->on_writeable();
+}
+
 } // ******** namespace events
\ No newline at end of file
@@ -1,21 +1,29 @@
 #include "socket/socket_address.hpp"
+#include "socket/address_cache.hpp"
+#include "socket/inet_address.hpp"
+
+#include <algorithm>
+#include <cstddef>
 
 using namespace unisock;
 
 
 socket_address::socket_address()
+: _size(0)
 {
 	memset(&_address, 0, sizeof(_address));
 }
 
 
 socket_address::socket_address(const socket_address& other)
+: _size(other._size)
 {
 	memcpy(&_address, &other._address, sizeof(_address));
 }
 
 
 socket_address::socket_address(const sockaddr_storage& addr)
+: _size(0)
 {
 	memcpy(&_address, &addr, sizeof(_address));
 }
@@ -25,7 +33,9 @@ socket_address::socket_address(const sockaddr_storage& addr)
 socket_address::socket_address(const sockaddr* addr, size_t addr_len)
 : socket_address()
 {
+	addr_len = std::min<size_t>(addr_len, sizeof(_address));
 	memcpy(&_address, addr, addr_len);
+	_size = static_cast<socklen_t>(addr_len);
 }
 
 // constructor for IPv4 / IPv6 addresses
@@ -43,6 +53,7 @@ socket_address::socket_address(const std::string& host, in_port_t port, bool use
 socket_address&   	socket_address::operator=(const socket_address& other)
 {
 	memcpy(&_address, &other._address, sizeof(_address));
+	_size = other._size;
 	return (*this);
 }
 
@@ -50,28 +61,173 @@ socket_address&   	socket_address::operator=(const socket_address& other)
 
 std::string 		socket_address::get_ip(const socket_address& address)
 {		
-	char ip[IP_ADDRESS_BUFFER_SIZE] { 0 };
+	char ip[IP_ADDRESS_BUFFER_SIZE];
+
+	if (address.family() != AF_INET && address.family() != AF_INET6)
+		return ("[invalid address family]");
+	if (0 == address.format_ip(ip, sizeof(ip)))
+		return "[inet_ntop error: " + std::string(strerror(errno)) + "]";
+	return std::string(ip);
+}
+
+
 
-	switch (address.family())
+// writes the ip only, inet_ntop does not allocate nor resolve
+static size_t		format_ip_of(const sockaddr* address, char* buffer, size_t buffer_size)
+{
+	const void*	ip;
+
+	switch (address->sa_family)
 	{
 	case AF_INET:
-		if (nullptr == inet_ntop(AF_INET, &address.to<sockaddr_in>()->sin_addr, ip, address.size()))
-			return "[inet_ntop error: " + std::string(strerror(errno)) + "]";
-		return std::string(ip);
-	
+		ip = &reinterpret_cast<const sockaddr_in*>(address)->sin_addr;
+		break ;
 	case AF_INET6:
-		if (nullptr == inet_ntop(AF_INET6, &address.to<sockaddr_in6>()->sin6_addr, ip, address.size()))
-			return "[inet_ntop error: " + std::string(strerror(errno)) + "]";
-		return std::string(ip);
+		ip = &reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr;
+		break ;
+	default:
+		if (buffer_size > 0)
+			buffer[0] = '\0';
+		return (0);
+	}
+	if (nullptr == inet_ntop(address->sa_family, ip, buffer, buffer_size))
+	{
+		if (buffer_size > 0)
+			buffer[0] = '\0';
+		return (0);
+	}
+	return (strlen(buffer));
+}
+
+
+size_t				socket_address::format_ip(char* buffer, size_t buffer_size) const
+{
+	return (format_ip_of(to<sockaddr>(), buffer, buffer_size));
+}
+
+
+// path of an AF_UNIX address, "@name" for abstract addresses, empty for unnamed ones,
+// abstract names end at address_size, or at their first null byte if address_size is 0
+static size_t		format_unix_of(const sockaddr* address, size_t address_size, char* buffer, size_t buffer_size)
+{
+	const char*		path = reinterpret_cast<const sockaddr_un*>(address)->sun_path;
+	const size_t	path_offset = offsetof(sockaddr_un, sun_path);
+	const bool		abstract = (path[0] == '\0');
+	const char*		name = abstract ? path + 1 : path;
+	size_t			length = strnlen(name, sizeof(sockaddr_un::sun_path) - (abstract ? 1 : 0));
+	if (abstract && address_size > path_offset)
+		length = std::min(address_size - path_offset - 1, sizeof(sockaddr_un::sun_path) - 1);
+
+	if (buffer_size == 0)
+		return (0);
+	if (length == 0 || length + (abstract ? 1 : 0) + 1 > buffer_size)
+	{
+		buffer[0] = '\0';
+		return (0);
 	}
-	return ("[invalid address family]");            
+	if (abstract)
+		buffer[0] = '@';
+	memcpy(buffer + (abstract ? 1 : 0), name, length);
+	length += (abstract ? 1 : 0);
+	buffer[length] = '\0';
+	return (length);
 }
 
 
+size_t				socket_address::format(char* buffer, size_t buffer_size) const
+{
+	if (family() == AF_UNIX)
+		return (format_unix_of(to<sockaddr>(), size(), buffer, buffer_size));
+	return (socket_address::format(to<sockaddr>(), buffer, buffer_size));
+}
+
+
+// "ip:port" or "[ip]:port", port digits are written by hand to avoid snprintf
+size_t				socket_address::format(const sockaddr* address, char* buffer, size_t buffer_size)
+{
+	if (address->sa_family == AF_UNIX)
+		return (format_unix_of(address, 0, buffer, buffer_size));
+
+	const bool		ipv6 = (address->sa_family == AF_INET6);
+	const size_t	offset = ipv6 ? 1 : 0;
+
+	if (buffer_size <= offset)
+		return (0);
+	size_t length = format_ip_of(address, buffer + offset, buffer_size - offset);
+	if (length == 0)
+	{
+		buffer[0] = '\0';
+		return (0);
+	}
+	length += offset;
+
+	const uint16_t	port = ntohs(ipv6 ? reinterpret_cast<const sockaddr_in6*>(address)->sin6_port
+										: reinterpret_cast<const sockaddr_in*>(address)->sin_port);
+	char			digits[5];
+	size_t			n_digits = 0;
+	uint16_t		remaining = port;
+	do
+	{
+		digits[n_digits++] = static_cast<char>('0' + remaining % 10);
+		remaining /= 10;
+	} while (remaining != 0);
+
+	// brackets, colon, digits and null terminator
+	if (length + (ipv6 ? 1 : 0) + 1 + n_digits + 1 > buffer_size)
+	{
+		buffer[0] = '\0';
+		return (0);
+	}
+	if (ipv6)
+	{
+		buffer[0] = '[';
+		buffer[length++] = ']';
+	}
+	buffer[length++] = ':';
+	while (n_digits > 0)
+		buffer[length++] = digits[--n_digits];
+	buffer[length] = '\0';
+	return (length);
+}
+
+
+
+// size of the struct of the family, used when no size was stored with the address
+static size_t		family_size(const sockaddr* address)
+{
+	switch (address->sa_family)
+	{
+	case AF_UNSPEC:
+		return (0);
+	case AF_INET:
+		return (sizeof(sockaddr_in));
+	case AF_INET6:
+		return (sizeof(sockaddr_in6));
+	case AF_UNIX:
+	{
+		// pathname with its null terminator, unnamed addresses only hold their family
+		const char*	path = reinterpret_cast<const sockaddr_un*>(address)->sun_path;
+		const size_t length = strnlen(path, sizeof(sockaddr_un::sun_path));
+		return (offsetof(sockaddr_un, sun_path) + (length > 0 ? std::min(length + 1, sizeof(sockaddr_un::sun_path)) : 0));
+	}
+	}
+#if defined(SIN6_LEN)
+	if (address->sa_len != 0)
+		return (address->sa_len);
+#endif
+	return (sizeof(sockaddr_storage));
+}
+
 
 size_t              socket_address::size() const
 {
-	return (to<sockaddr>()->sa_len);
+	return (_size != 0 ? _size : family_size(to<sockaddr>()));
+}
+
+
+void				socket_address::set_size(size_t size)
+{
+	_size = static_cast<socklen_t>(std::min<size_t>(size, sizeof(_address)));
 }
 
 
@@ -81,46 +237,226 @@ sa_family_t         socket_address::family() const
 }
 
 
+uint16_t            socket_address::port() const
+{
+	switch (family())
+	{
+	case AF_INET:
+		return (ntohs(to<sockaddr_in>()->sin_port));
+	case AF_INET6:
+		return (ntohs(to<sockaddr_in6>()->sin6_port));
+	}
+	return (0);
+}
 
 
-// retrieves the address depending on hostname and family using getaddrinfo, 
-// and puts the result address into referenced address sockaddr_storage
+// hashes family, address and port only, other fields (padding, flowinfo) are ignored,
+// same hash as inet_address so that both can key the same tables
+size_t				socket_address::hash() const
+{
+	switch (family())
+	{
+	case AF_INET:
+	case AF_INET6:
+		return (inet_address(*this).hash());
+	}
+
+	// FNV-1a on the whole address for other families
+	const unsigned char*	bytes = reinterpret_cast<const unsigned char*>(&_address);
+	uint64_t				hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size(); ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+	return (hash);
+}
+
+
+// compares family, address and port only, consistent with hash()
+bool				socket_address::operator==(const socket_address& other) const
+{
+	if (family() != other.family())
+		return (false);
+
+	switch (family())
+	{
+	case AF_INET:
+		return (to<sockaddr_in>()->sin_port == other.to<sockaddr_in>()->sin_port
+			&& to<sockaddr_in>()->sin_addr.s_addr == other.to<sockaddr_in>()->sin_addr.s_addr);
+	case AF_INET6:
+		return (to<sockaddr_in6>()->sin6_port == other.to<sockaddr_in6>()->sin6_port
+			&& 0 == memcmp(&to<sockaddr_in6>()->sin6_addr, &other.to<sockaddr_in6>()->sin6_addr, sizeof(in6_addr)));
+	}
+	return (size() == other.size() && 0 == memcmp(&_address, &other._address, size()));
+}
+
+
+bool				socket_address::operator!=(const socket_address& other) const
+{
+	return (!(*this == other));
+}
+
+
+
+
+// resolves hostname with getaddrinfo, without the cache, gai_error is set to the last getaddrinfo error
 // returns: see addrinfo_result enum above
-addrinfo_result  socket_address::addrinfo(struct sockaddr_storage& address, const std::string& hostname, const sa_family_t family)
+static addrinfo_result	resolve_addresses(std::vector<socket_address>& addresses, const std::string& hostname, const sa_family_t family, int& gai_error)
 {
 	// try to get addr from hostname
-	int         err = 0;
 	struct addrinfo    hints;
 	struct addrinfo*   res = nullptr;
 	std::memset(&hints, 0, sizeof(hints));
 	hints.ai_family = family;
 
-	int n_retries = MAX_HOST_RESOLVE_RETRIES;
+	int n_retries = socket_address::MAX_HOST_RESOLVE_RETRIES;
 	do
 	{
-		err = getaddrinfo(hostname.c_str(), NULL, &hints, &res);
-		if (err == 0)
+		gai_error = getaddrinfo(hostname.c_str(), NULL, &hints, &res);
+		if (gai_error == 0)
 			break ;
 			
-		else if (err != EAI_AGAIN)
+		else if (gai_error != EAI_AGAIN)
 			return (addrinfo_result::ERROR);
 	} while (--n_retries > 0);
 	if (n_retries == 0 || res == nullptr)
 		return (addrinfo_result::UNAVAILABLE);
 
-	if (res->ai_addrlen > sizeof(address))
-		return (addrinfo_result::ADDRESS_TOO_BIG);
+	// getaddrinfo lists the same address once per socket type
+	bool	too_big = false;
+	for (struct addrinfo* info = res; info != nullptr; info = info->ai_next)
+	{
+		if (info->ai_addrlen > sizeof(sockaddr_storage))
+		{
+			too_big = true;
+			continue ;
+		}
+		socket_address	address { info->ai_addr, info->ai_addrlen };
+		if (std::find(addresses.begin(), addresses.end(), address) == addresses.end())
+			addresses.push_back(address);
+	}
+	freeaddrinfo(res);
+
+	if (addresses.empty())
+		return (too_big ? addrinfo_result::ADDRESS_TOO_BIG : addrinfo_result::UNAVAILABLE);
+	return (addrinfo_result::SUCCESS);
+}
+
+
+// parses numeric addresses with inet_pton, without getaddrinfo (NSS, /etc/hosts, ...)
+bool			socket_address::parse_numeric(struct sockaddr_storage& address, const char* hostname, size_t hostname_len, const sa_family_t family)
+{
+	// inet_pton needs a null terminated string, longest IPv6 address fits in INET6_ADDRSTRLEN
+	char	buffer[INET6_ADDRSTRLEN];
+
+	if (hostname_len == 0 || hostname_len >= sizeof(buffer))
+		return (false);
+	memcpy(buffer, hostname, hostname_len);
+	buffer[hostname_len] = '\0';
+
+	if (family == AF_INET || family == AF_UNSPEC)
+	{
+		in_addr	ipv4;
+		if (1 == inet_pton(AF_INET, buffer, &ipv4))
+		{
+			memset(&address, 0, sizeof(address));
+			sockaddr_in*	in = reinterpret_cast<sockaddr_in*>(&address);
+#if defined(SIN6_LEN)
+			in->sin_len = sizeof(sockaddr_in);
+#endif
+			in->sin_family = AF_INET;
+			in->sin_addr = ipv4;
+			return (true);
+		}
+	}
+	if (family == AF_INET6 || family == AF_UNSPEC)
+	{
+		in6_addr	ipv6;
+		if (1 == inet_pton(AF_INET6, buffer, &ipv6))
+		{
+			memset(&address, 0, sizeof(address));
+			sockaddr_in6*	in6 = reinterpret_cast<sockaddr_in6*>(&address);
+#if defined(SIN6_LEN)
+			in6->sin6_len = sizeof(sockaddr_in6);
+#endif
+			in6->sin6_family = AF_INET6;
+			in6->sin6_addr = ipv6;
+			return (true);
+		}
+	}
+	return (false);
+}
+
+
+// retrieves all addresses of hostname with family, from the cache or using getaddrinfo
+// returns: see addrinfo_result enum above
+addrinfo_result  socket_address::addrinfo_all(std::vector<socket_address>& addresses, const std::string& hostname, const sa_family_t family, int* gai_error)
+{
+	addrinfo_result	result;
+	socket_address	numeric;
+	int				eai = 0;
+
+	addresses.clear();
+	if (gai_error)
+		*gai_error = 0;
+	if (socket_address::parse_numeric(numeric._address, hostname.data(), hostname.size(), family))
+	{
+		addresses.push_back(numeric);
+		return (addrinfo_result::SUCCESS);
+	}
+	if (!address_cache::instance().find(hostname, family, addresses, result, eai))
+	{
+		errno = 0;
+		result = resolve_addresses(addresses, hostname, family, eai);
+		const int error = errno;
+		if (result != addrinfo_result::SUCCESS)
+			addresses.clear();
+		address_cache::instance().store(hostname, family, addresses, result, error, eai);
+		errno = error;
+	}
+	if (gai_error)
+		*gai_error = eai;
+	return (result);
+}
+
+
+// retrieves the address depending on hostname and family using getaddrinfo, 
+// and puts the result address into referenced address sockaddr_storage
+// returns: see addrinfo_result enum above
+addrinfo_result  socket_address::addrinfo(struct sockaddr_storage& address, const std::string& hostname, const sa_family_t family)
+{
+	if (socket_address::parse_numeric(address, hostname.data(), hostname.size(), family))
+		return (addrinfo_result::SUCCESS);
+
+	std::vector<socket_address>	addresses;
+	addrinfo_result result = socket_address::addrinfo_all(addresses, hostname, family);
+	if (result != addrinfo_result::SUCCESS)
+		return (result);
 
-	std::memcpy(&address, res->ai_addr, res->ai_addrlen);
+	std::memcpy(&address, &addresses.front()._address, sizeof(address));
 	return (addrinfo_result::SUCCESS);
 }
 
 // overload addrinfo for socket_address
 addrinfo_result  socket_address::addrinfo(socket_address& address, const std::string& hostname, const sa_family_t family)
 {
+	address._size = 0;
 	return (socket_address::addrinfo(address._address, hostname, family));
 }
 
+// overload addrinfo for a hostname that is not null terminated, allocates only to resolve names
+addrinfo_result  socket_address::addrinfo(struct sockaddr_storage& address, const char* hostname, size_t hostname_len, const sa_family_t family)
+{
+	if (socket_address::parse_numeric(address, hostname, hostname_len, family))
+		return (addrinfo_result::SUCCESS);
+	return (socket_address::addrinfo(address, std::string(hostname, hostname_len), family));
+}
+
+// overload addrinfo for socket_address and a hostname that is not null terminated
+addrinfo_result  socket_address::addrinfo(socket_address& address, const char* hostname, size_t hostname_len, const sa_family_t family)
+{
+	address._size = 0;
+	return (socket_address::addrinfo(address._address, hostname, hostname_len, family));
+}
+
 
 
 // retrieves the hostname of addr using getnameinfo, 
@@ -195,6 +531,72 @@ socket_address socket_address::from(const std::string& hostname, const in_port_t
 
 
 
+/* creates an inet address from a hostname that is not null        */
+/* terminated, port, family, same as from(std::string, ...)         */
+socket_address socket_address::from(const char* hostname, size_t hostname_len, const in_port_t port, const sa_family_t family)
+{
+	socket_address address {};
+	addrinfo_result result = socket_address::addrinfo(address, hostname, hostname_len, family);
+	if (result != addrinfo_result::SUCCESS)
+		throw std::logic_error(std::string("error when trying to get address info: ") + strerror(errno));
+
+	if (address.family() == AF_INET)
+		address.to<sockaddr_in>()->sin_port = htons(port);
+	else if (address.family() == AF_INET6)
+		address.to<sockaddr_in6>()->sin6_port = htons(port);
+	else
+		throw std::logic_error("invalid inet address from constructor: required port but address is not of type AF_INET or AF_INET6");
+	return (address);
+}
+
+
+
+// abstract names start with a null byte, the size of the address delimits them
+bool			socket_address::unix_address(socket_address& address, const std::string& path, bool abstract)
+{
+	const size_t	max_length = sizeof(sockaddr_un::sun_path) - 1;
+
+#if !defined(__linux__)
+	if (abstract)
+	{
+		errno = EAFNOSUPPORT;
+		return (false);
+	}
+#endif
+	if (path.empty())
+	{
+		errno = EINVAL;
+		return (false);
+	}
+	if (path.size() > max_length)
+	{
+		errno = ENAMETOOLONG;
+		return (false);
+	}
+
+	address = socket_address {};
+	sockaddr_un*	un = reinterpret_cast<sockaddr_un*>(address.to<sockaddr>());
+	un->sun_family = AF_UNIX;
+	memcpy(un->sun_path + (abstract ? 1 : 0), path.data(), path.size());
+	// pathnames include their null terminator, abstract names include their leading null byte and no terminator
+	address._size = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+#if defined(SIN6_LEN)
+	un->sun_len = static_cast<uint8_t>(address._size);
+#endif
+	return (true);
+}
+
+
+socket_address socket_address::from_unix(const std::string& path, bool abstract)
+{
+	socket_address address {};
+	if (!socket_address::unix_address(address, path, abstract))
+		throw std::logic_error(std::string("invalid unix address: ") + strerror(errno));
+	return (address);
+}
+
+
+
 /* returns a string describing the address structure */
 std::string         socket_address::to_string() const
 {
@@ -271,4 +673,18 @@ std::string     socket_address::_to_string<AF_INET6>() const
 	+   "sin6_flowinfo: " + std::to_string(static_cast<int>(to<sockaddr_in6>()->sin6_flowinfo)) + "\n"
 	+   "sin6_scope_id: " + std::to_string(static_cast<int>(to<sockaddr_in6>()->sin6_scope_id)) + "\n"
 	);
+}
+
+template<>
+std::string     socket_address::_to_string<AF_UNIX>() const
+{
+	char path[sizeof(sockaddr_un::sun_path) + 1];
+	if (0 == this->format(path, sizeof(path)))
+		strcpy(path, "(unnamed)");
+
+	return (
+		"sun_len:     " + std::to_string(size()) + "\n"
+	+   "sun_family:  " + std::string("AF_UNIX") + "\n"
+	+   "sun_path:    " + std::string(path) + "\n"
+	);
 }
\ No newline at end of file